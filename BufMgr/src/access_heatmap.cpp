@@ -0,0 +1,118 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "access_heatmap.h"
+
+#include <cstdio>
+#include <fstream>
+
+namespace badgerdb {
+
+AccessHeatmap::AccessHeatmap(std::uint32_t sampleEvery,
+                             std::uint32_t pagesPerBucket, std::uint32_t topK)
+    : sampleEvery_(sampleEvery > 0 ? sampleEvery : 1),
+      pagesPerBucket_(pagesPerBucket > 0 ? pagesPerBucket : 1),
+      topK_(topK),
+      capacity_(4 * topK),
+      countdown_(sampleEvery_) {}
+
+void AccessHeatmap::record(const std::string &filename, PageId pageNo,
+                           bool hit) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  FileHeat &heat = files_[filename];
+  ++(hit ? heat.hits : heat.misses);
+  ++heat.buckets[pageNo / pagesPerBucket_];
+
+  if (capacity_ == 0) return;
+  PageKey key(filename, pageNo);
+  auto counted = counterOf_.find(key);
+  std::uint32_t index;
+  if (counted != counterOf_.end()) {
+    index = counted->second;
+    byCount_.erase({counters_[index].count, index});
+  } else if (counters_.size() < capacity_) {
+    index = counters_.size();
+    counters_.push_back({key, 0, 0});
+    counterOf_[key] = index;
+  } else {
+    // Take over the counter of the least requested page.
+    index = byCount_.begin()->second;
+    byCount_.erase(byCount_.begin());
+    counterOf_.erase(counters_[index].key);
+    counters_[index].key = key;
+    counters_[index].error = counters_[index].count;
+    counterOf_[key] = index;
+  }
+  ++counters_[index].count;
+  byCount_.insert({counters_[index].count, index});
+}
+
+std::map<std::string, AccessHeatmap::FileHeat> AccessHeatmap::files() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::map<std::string, FileHeat> scaled = files_;
+  for (auto &file : scaled) {
+    file.second.hits *= sampleEvery_;
+    file.second.misses *= sampleEvery_;
+    for (auto &bucket : file.second.buckets) bucket.second *= sampleEvery_;
+  }
+  return scaled;
+}
+
+std::vector<AccessHeatmap::HotPage> AccessHeatmap::topPages() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<HotPage> top;
+  for (auto it = byCount_.rbegin(); it != byCount_.rend() && top.size() < topK_;
+       ++it) {
+    const Counter &counter = counters_[it->second];
+    top.push_back({counter.key.first, counter.key.second,
+                   counter.count * sampleEvery_,
+                   counter.error * sampleEvery_});
+  }
+  return top;
+}
+
+void AccessHeatmap::dump(const std::string &path) const {
+  const std::map<std::string, FileHeat> heat = files();
+  const std::vector<HotPage> top = topPages();
+
+  // Written to a temporary file first so a reader never sees half a dump.
+  const std::string tmpPath = path + ".tmp";
+  {
+    std::ofstream out(tmpPath, std::ios::trunc);
+    out << "# badgerdb access heatmap v1, 1 in " << sampleEvery_
+        << " requests sampled, counts are estimates\n";
+    for (const auto &file : heat) {
+      out << "file\t" << file.first << "\thits\t" << file.second.hits
+          << "\tmisses\t" << file.second.misses << "\n";
+    }
+    for (const auto &file : heat) {
+      for (const auto &bucket : file.second.buckets) {
+        const std::uint64_t first =
+            static_cast<std::uint64_t>(bucket.first) * pagesPerBucket_;
+        out << "range\t" << file.first << "\t" << first << "\t"
+            << first + pagesPerBucket_ - 1 << "\t" << bucket.second << "\n";
+      }
+    }
+    for (const HotPage &page : top) {
+      out << "top\t" << page.filename << "\t" << page.pageNo << "\t"
+          << page.count << "\t" << page.error << "\n";
+    }
+  }
+  std::rename(tmpPath.c_str(), path.c_str());
+}
+
+void AccessHeatmap::reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  files_.clear();
+  counters_.clear();
+  counterOf_.clear();
+  byCount_.clear();
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,165 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Where page requests go: per-file hits and misses, a histogram of
+ * each file's requests over ranges of page numbers, and the hottest pages.
+ *
+ * Only one request in every sampleEvery is recorded, and counts reported are
+ * scaled back up, so they are estimates.  The hottest pages are found with
+ * the space-saving algorithm: a fixed number of pages is counted, and a new
+ * page takes over the counter of the least requested one, inheriting its
+ * count as possible overestimate.  A page requested more than a
+ * 1 / capacity share of the time is always among them.
+ *
+ * This class is threadsafe.
+ */
+class AccessHeatmap {
+ public:
+  /**
+   * @brief Estimated requests for pages of one file.
+   */
+  struct FileHeat {
+    std::uint64_t hits;
+    std::uint64_t misses;
+
+    /**
+     * Requests by page range: bucket i covers pages from i * pagesPerBucket
+     * up to but excluding (i + 1) * pagesPerBucket.  Only ranges which were
+     * requested are present, so pages far into a file cost no more than
+     * others.
+     */
+    std::map<std::uint32_t, std::uint64_t> buckets;
+  };
+
+  /**
+   * @brief A page among the hottest, with its estimated number of requests
+   * and by how much that may overestimate it.
+   */
+  struct HotPage {
+    std::string filename;
+    PageId pageNo;
+    std::uint64_t count;
+    std::uint64_t error;
+  };
+
+  /**
+   * @param sampleEvery     One request in this many is recorded.
+   * @param pagesPerBucket  Pages per range of the per-file histograms.
+   * @param topK            Number of hottest pages to report; four times as
+   *                        many are counted, for accuracy.
+   */
+  AccessHeatmap(std::uint32_t sampleEvery, std::uint32_t pagesPerBucket,
+                std::uint32_t topK);
+
+  AccessHeatmap(const AccessHeatmap &) = delete;
+  AccessHeatmap &operator=(const AccessHeatmap &) = delete;
+
+  /**
+   * Returns one in every sampleEvery calls true, for the caller to record
+   * that request.  Only the thread using the buffer manager may call it.
+   */
+  bool sample() {
+    if (--countdown_ != 0) return false;
+    countdown_ = sampleEvery_;
+    return true;
+  }
+
+  /**
+   * Records a sampled request.
+   *
+   * @param filename  File the page belongs to.
+   * @param pageNo    Page requested.
+   * @param hit       True if the page was in the buffer pool.
+   */
+  void record(const std::string &filename, PageId pageNo, bool hit);
+
+  /**
+   * Returns the estimated requests for every file seen, by file name.
+   */
+  std::map<std::string, FileHeat> files() const;
+
+  /**
+   * Returns the hottest pages, hottest first.
+   */
+  std::vector<HotPage> topPages() const;
+
+  /**
+   * Returns the number of pages per histogram range.
+   */
+  std::uint32_t pagesPerBucket() const { return pagesPerBucket_; }
+
+  /**
+   * Writes everything recorded to a text file: one line per file, per
+   * non-empty page range and per hot page.
+   *
+   * @param path  File to write.
+   */
+  void dump(const std::string &path) const;
+
+  /**
+   * Forgets everything recorded.
+   */
+  void reset();
+
+ private:
+  typedef std::pair<std::string, PageId> PageKey;
+
+  /**
+   * @brief Counter of the space-saving summary.
+   */
+  struct Counter {
+    PageKey key;
+    std::uint64_t count;
+    std::uint64_t error;
+  };
+
+  const std::uint32_t sampleEvery_;
+  const std::uint32_t pagesPerBucket_;
+  const std::uint32_t topK_;
+  const std::uint32_t capacity_;
+
+  /**
+   * Requests left until the next one sampled.
+   */
+  std::uint32_t countdown_;
+
+  /**
+   * Protects the members below.
+   */
+  mutable std::mutex mutex_;
+
+  /**
+   * Sampled requests per file.
+   */
+  std::map<std::string, FileHeat> files_;
+
+  /**
+   * Space-saving counters, the counter of each page counted, and the
+   * counters ordered by count so that the smallest is found at once.
+   */
+  std::vector<Counter> counters_;
+  std::map<PageKey, std::uint32_t> counterOf_;
+  std::set<std::pair<std::uint64_t, std::uint32_t>> byCount_;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,171 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "access_trace.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace badgerdb {
+
+namespace {
+
+const char TRACE_MAGIC[8] = {'B', 'D', 'B', 'T', 'R', 'A', 'C', 'E'};
+const std::uint32_t TRACE_VERSION = 1;
+
+/**
+ * Time between drains of the ring when it is not filling up.
+ */
+const std::chrono::milliseconds DRAIN_INTERVAL(10);
+
+/**
+ * Returns the number of records a file name of the given length takes up.
+ */
+std::size_t nameRecords(std::size_t length) {
+  return (length + sizeof(TraceRecord) - 1) / sizeof(TraceRecord);
+}
+
+}  // namespace
+
+const std::uint8_t TraceRecord::DIRTY;
+const std::uint8_t TraceRecord::HIT;
+
+AccessTraceWriter::AccessTraceWriter(const std::string &path,
+                                     std::uint32_t capacity)
+    : out_(path, std::ios::binary | std::ios::trunc),
+      start_(std::chrono::steady_clock::now()),
+      head_(0),
+      tail_(0),
+      written_(0),
+      dropped_(0),
+      stopping_(false) {
+  std::uint64_t size = 2;
+  while (size < capacity) size <<= 1;
+  ring_.resize(size);
+  mask_ = size - 1;
+
+  TraceHeader header;
+  std::memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+  header.version = TRACE_VERSION;
+  header.recordSize = sizeof(TraceRecord);
+  out_.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+  thread_ = std::thread(&AccessTraceWriter::run, this);
+}
+
+AccessTraceWriter::~AccessTraceWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  thread_.join();
+}
+
+void AccessTraceWriter::record(TraceRecord::Op op, const std::string &filename,
+                               PageId pageNo, std::uint8_t flags) {
+  auto id = fileIds_.find(filename);
+  if (id == fileIds_.end()) {
+    // New files are rare, so they are handed over under the lock.
+    id = fileIds_.emplace(filename, fileIds_.size()).first;
+    std::lock_guard<std::mutex> lock(mutex_);
+    newFiles_.emplace_back(id->second, filename);
+  }
+
+  const std::uint64_t head = head_.load(std::memory_order_relaxed);
+  const std::uint64_t used = head - tail_.load(std::memory_order_acquire);
+  if (used > mask_) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  TraceRecord &record = ring_[head & mask_];
+  record.timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - start_)
+                           .count();
+  record.fileId = id->second;
+  record.pageNo = pageNo;
+  record.op = op;
+  record.flags = flags;
+  record.reserved = 0;
+  record.reserved2 = 0;
+  head_.store(head + 1, std::memory_order_release);
+
+  // Wake the drain thread early once the ring is half full.
+  if (used + 1 == (mask_ + 1) / 2) wake_.notify_one();
+}
+
+void AccessTraceWriter::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopping_) {
+    wake_.wait_for(lock, DRAIN_INTERVAL);
+    lock.unlock();
+    drain();
+    lock.lock();
+  }
+  lock.unlock();
+  drain();
+}
+
+void AccessTraceWriter::drain() {
+  // Names are taken after the head: every file recorded up to the head was
+  // handed over before its first record, so no record precedes its name.
+  const std::uint64_t head = head_.load(std::memory_order_acquire);
+  std::vector<std::pair<std::uint32_t, std::string>> newFiles;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    newFiles.swap(newFiles_);
+  }
+  for (const auto &file : newFiles) {
+    TraceRecord record = TraceRecord();
+    record.fileId = file.first;
+    record.pageNo = file.second.size();
+    record.op = TraceRecord::FILE_NAME;
+    out_.write(reinterpret_cast<const char *>(&record), sizeof(record));
+    std::string padded(file.second);
+    padded.resize(nameRecords(padded.size()) * sizeof(TraceRecord), '\0');
+    out_.write(padded.data(), padded.size());
+  }
+
+  std::uint64_t tail = tail_.load(std::memory_order_relaxed);
+  while (tail != head) {
+    // Write the records up to the end of the ring, or to the head.
+    const std::uint64_t end = std::min(head, (tail | mask_) + 1);
+    out_.write(reinterpret_cast<const char *>(&ring_[tail & mask_]),
+               (end - tail) * sizeof(TraceRecord));
+    written_.fetch_add(end - tail, std::memory_order_relaxed);
+    tail = end;
+    tail_.store(tail, std::memory_order_release);
+  }
+  out_.flush();
+}
+
+AccessTraceReader::AccessTraceReader(const std::string &path)
+    : in_(path, std::ios::binary), good_(false) {
+  TraceHeader header;
+  if (in_.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+    good_ = std::memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) == 0 &&
+            header.version == TRACE_VERSION &&
+            header.recordSize == sizeof(TraceRecord);
+  }
+}
+
+bool AccessTraceReader::next(TraceRecord &record) {
+  while (good_ &&
+         in_.read(reinterpret_cast<char *>(&record), sizeof(record))) {
+    if (record.op != TraceRecord::FILE_NAME) return true;
+
+    std::string name(nameRecords(record.pageNo) * sizeof(TraceRecord), '\0');
+    if (!in_.read(&name[0], name.size())) break;
+    name.resize(record.pageNo);
+    files_[record.fileId] = name;
+  }
+  return false;
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,203 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief One buffer manager request in an access trace.
+ *
+ * A trace file starts with a TraceHeader and is followed by records in the
+ * order the requests were made, in the byte order of the machine which wrote
+ * it.  Files are referred to by small ids; a FILE_NAME record introduces an
+ * id before its first use and is followed by the name, padded with zeros to
+ * a whole number of records.
+ */
+struct TraceRecord {
+  /**
+   * Requests which are traced.
+   */
+  enum Op : std::uint8_t { READ, ALLOC, UNPIN, DISPOSE, FLUSH_FILE, FILE_NAME };
+
+  /**
+   * Bits of flags: the page was dirtied by an UNPIN, or a READ was a hit
+   */
+  static const std::uint8_t DIRTY = 1;
+  static const std::uint8_t HIT = 2;
+
+  /**
+   * Time of the request, in nanoseconds since tracing started
+   */
+  std::uint64_t timestampNs;
+
+  /**
+   * File and page requested; for FILE_NAME the id being introduced and the
+   * length of its name, and for FLUSH_FILE an invalid page number
+   */
+  std::uint32_t fileId;
+  std::uint32_t pageNo;
+
+  std::uint8_t op;
+  std::uint8_t flags;
+  std::uint16_t reserved;
+  std::uint32_t reserved2;
+};
+
+/**
+ * @brief First bytes of a trace file.
+ */
+struct TraceHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t recordSize;
+};
+
+/**
+ * @brief Records buffer manager requests to a trace file.
+ *
+ * record() only appends to a ring buffer in memory, without locking; a
+ * background thread drains the ring to disk.  Should the ring fill up faster
+ * than it is drained, records are dropped and counted instead of making the
+ * caller wait.
+ *
+ * record() must only be called by one thread at a time, the one using the
+ * buffer manager; the counters may be read from any thread.
+ */
+class AccessTraceWriter {
+ public:
+  /**
+   * Starts a trace, replacing any file at path.
+   *
+   * @param path     File to write the trace to
+   * @param capacity Records the ring holds, rounded up to a power of two
+   */
+  AccessTraceWriter(const std::string &path, std::uint32_t capacity);
+
+  /**
+   * Stops tracing, after writing out every record in the ring.
+   */
+  ~AccessTraceWriter();
+
+  AccessTraceWriter(const AccessTraceWriter &) = delete;
+  AccessTraceWriter &operator=(const AccessTraceWriter &) = delete;
+
+  /**
+   * Records a request.
+   *
+   * @param op       Request made
+   * @param filename File requested
+   * @param pageNo   Page requested
+   * @param flags    TraceRecord::DIRTY and TraceRecord::HIT bits
+   */
+  void record(TraceRecord::Op op, const std::string &filename, PageId pageNo,
+              std::uint8_t flags = 0);
+
+  /**
+   * Returns the number of records written to the trace file so far.
+   */
+  std::uint64_t getWrittenCount() const { return written_; }
+
+  /**
+   * Returns the number of records dropped because the ring was full.
+   */
+  std::uint64_t getDroppedCount() const { return dropped_; }
+
+ private:
+  /**
+   * Body of the drain thread.
+   */
+  void run();
+
+  /**
+   * Writes out new file names, then the records in the ring.
+   */
+  void drain();
+
+  std::ofstream out_;
+  std::chrono::steady_clock::time_point start_;
+
+  /**
+   * Ids of the files seen so far; used by the recording thread only
+   */
+  std::unordered_map<std::string, std::uint32_t> fileIds_;
+
+  /**
+   * Ring of records.  head_ is advanced by the recording thread and tail_
+   * by the drain thread; they are kept on separate cache lines.
+   */
+  std::vector<TraceRecord> ring_;
+  std::uint64_t mask_;
+  std::atomic<std::uint64_t> head_;
+  char pad_[64];
+  std::atomic<std::uint64_t> tail_;
+
+  std::atomic<std::uint64_t> written_;
+  std::atomic<std::uint64_t> dropped_;
+
+  /**
+   * Protects the members below; stopping_ is signalled through wake_.
+   */
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  bool stopping_;
+  std::vector<std::pair<std::uint32_t, std::string>> newFiles_;
+
+  std::thread thread_;
+};
+
+/**
+ * @brief Reads back a trace written by AccessTraceWriter.
+ */
+class AccessTraceReader {
+ public:
+  /**
+   * Opens a trace file.  good() tells whether it is one.
+   */
+  explicit AccessTraceReader(const std::string &path);
+
+  /**
+   * Returns whether the file is a readable trace.
+   */
+  bool good() const { return good_; }
+
+  /**
+   * Reads the next request, taking in file names on the way.
+   *
+   * @param record Set to the request read
+   * @return       False at the end of the trace.
+   */
+  bool next(TraceRecord &record);
+
+  /**
+   * Returns the names of the files introduced so far, by id.
+   */
+  const std::map<std::uint32_t, std::string> &files() const { return files_; }
+
+ private:
+  std::ifstream in_;
+  bool good_;
+  std::map<std::uint32_t, std::string> files_;
+};
+
+}  // namespace badgerdb
@@ -89,4 +89,21 @@ void BufHashTbl::remove(const File& file, const PageId pageNo) {
   throw HashNotFoundException(file.filename(), pageNo);
 }
 
+void BufHashTbl::rehash(const int htSize) {
+  std::vector<std::shared_ptr<hashBucket>> old(htSize);
+  old.swap(ht);
+  HTSIZE = htSize;
+
+  // Relink the existing buckets rather than copying them.
+  for (std::shared_ptr<hashBucket>& chain : old) {
+    while (chain) {
+      std::shared_ptr<hashBucket> tmpBuc = chain;
+      chain = tmpBuc->next;
+      const int index = hash(tmpBuc->file, tmpBuc->pageNo);
+      tmpBuc->next = ht[index];
+      ht[index] = tmpBuc;
+    }
+  }
+}
+
 }  // namespace badgerdb
@@ -104,6 +104,19 @@ class BufHashTbl {
    * table
    */
   void remove(const File& file, const PageId pageNo);
+
+  /**
+   * Returns the number of buckets in the hash table.
+   */
+  int size() const { return HTSIZE; }
+
+  /**
+   * Redistributes every entry over a new number of buckets, so that chains
+   * stay short after the pool grows.
+   *
+   * @param htSize  New number of buckets
+   */
+  void rehash(const int htSize);
 };
 
 }  // namespace badgerdb
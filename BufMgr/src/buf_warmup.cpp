@@ -0,0 +1,165 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "buf_warmup.h"
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Moves the calling thread to the idle CPU and I/O scheduling classes, so
+ * that warming up never competes with foreground requests.
+ */
+void lowerThreadPriority() {
+#ifdef __linux__
+  const pid_t tid = syscall(SYS_gettid);
+  setpriority(PRIO_PROCESS, tid, 19);
+  const int IOPRIO_WHO_PROCESS = 1;
+  const int IOPRIO_CLASS_IDLE = 3;
+  const int IOPRIO_CLASS_SHIFT = 13;
+  syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, tid,
+          IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+#endif
+}
+
+}  // namespace
+
+BufWarmup::BufWarmup(const std::vector<File> &files,
+                     const std::vector<std::vector<PageId>> &pages,
+                     unsigned threads)
+    : files_(files), nextRun_(0), running_(0), cancelled_(false) {
+  for (std::size_t f = 0; f < files_.size(); ++f) {
+    fileIndex_[files_[f].filename()] = f;
+    fds_.push_back(::open(files_[f].filename().c_str(), O_RDONLY));
+    // Pages of compressed files are not at fixed positions; they are left
+    // to be read normally when missed.
+    if (fds_.back() < 0 || files_[f].isCompressed()) continue;
+
+    // Sort the pages of each file and coalesce them into runs.
+    std::vector<PageId> sorted(pages[f]);
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    for (std::size_t i = 0; i < sorted.size(); ++i) {
+      if (!runs_.empty() && runs_.back().file == f &&
+          runs_.back().first + runs_.back().count == sorted[i] &&
+          runs_.back().count < MAX_RUN_PAGES) {
+        ++runs_.back().count;
+      } else {
+        runs_.push_back({f, sorted[i], 1});
+      }
+    }
+  }
+
+  threads = std::max(1u, std::min<unsigned>(threads, runs_.size()));
+  running_ = threads;
+  for (unsigned t = 0; t < threads; ++t) {
+    threads_.emplace_back(&BufWarmup::work, this);
+  }
+}
+
+BufWarmup::~BufWarmup() {
+  cancelled_ = true;
+  drained_.notify_all();
+  for (std::thread &thread : threads_) {
+    thread.join();
+  }
+  for (int fd : fds_) {
+    if (fd >= 0) ::close(fd);
+  }
+}
+
+void BufWarmup::work() {
+  lowerThreadPriority();
+  std::vector<char> buffer(MAX_RUN_PAGES * Page::SIZE);
+
+  for (std::size_t r = nextRun_++; r < runs_.size() && !cancelled_;
+       r = nextRun_++) {
+    const Run &run = runs_[r];
+    const ssize_t bytes =
+        pread(fds_[run.file], buffer.data(), run.count * Page::SIZE,
+              File::pagePosition(run.first));
+    files_[run.file].countIo(FileIoStats::READ_CALLS);
+    if (bytes <= 0) continue;
+    files_[run.file].countIo(FileIoStats::BYTES_READ, bytes);
+    files_[run.file].countIo(FileIoStats::PAGE_READS, bytes / Page::SIZE);
+
+    const std::uint32_t count = bytes / Page::SIZE;
+    std::unique_lock<std::mutex> lock(mutex_);
+    drained_.wait(lock, [this] {
+      return cancelled_ || staged_.size() < MAX_STAGED_PAGES;
+    });
+    for (std::uint32_t i = 0; i < count; ++i) {
+      const Key key(run.file, run.first + i);
+      if (written_.count(key)) continue;
+
+      Page page;
+      page.readImage(&buffer[i * Page::SIZE]);
+      // Skip pages which have been freed or reused since the dump, and
+      // corrupt ones, which a regular read reports when they are missed.
+      if (page.page_number() != key.second) continue;
+      if (File::verifyChecksums() && !page.hasValidChecksum()) continue;
+      staged_[key] = std::move(page);
+    }
+  }
+  --running_;
+}
+
+bool BufWarmup::take(const File &file, const PageId pageNo, Page &page) {
+  const auto f = fileIndex_.find(file.filename());
+  if (f == fileIndex_.end()) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto staged = staged_.find(Key(f->second, pageNo));
+  if (staged == staged_.end()) {
+    return false;
+  }
+  page = std::move(staged->second);
+  staged_.erase(staged);
+  drained_.notify_one();
+  return true;
+}
+
+bool BufWarmup::next(File *&file, PageId &pageNo, Page &page) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (staged_.empty()) {
+    return false;
+  }
+  const auto staged = staged_.begin();
+  file = &files_[staged->first.first];
+  pageNo = staged->first.second;
+  page = std::move(staged->second);
+  staged_.erase(staged);
+  drained_.notify_one();
+  return true;
+}
+
+void BufWarmup::invalidate(const File &file, const PageId pageNo) {
+  const auto f = fileIndex_.find(file.filename());
+  if (f == fileIndex_.end()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  written_.insert(Key(f->second, pageNo));
+  staged_.erase(Key(f->second, pageNo));
+}
+
+bool BufWarmup::done() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return running_ == 0 && staged_.empty();
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,157 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "file.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Background reader which warms up a buffer pool from a list of pages.
+ *
+ * Used by BufMgr::loadResidentPages().  The pages of each file are sorted and
+ * coalesced into runs of consecutive pages.  Worker threads read each run with
+ * a single pread() at idle I/O and CPU priority and stage the decoded pages in
+ * memory.  They never touch the buffer pool or the File objects, so they do
+ * not need any of the buffer manager's state.  The thread owning the buffer
+ * manager installs staged pages into free frames at its own pace, or takes a
+ * staged page directly when it misses on it.
+ *
+ * Pages the buffer manager writes or deletes while the load is running are
+ * remembered, and staged copies of them are dropped since they may be stale.
+ */
+class BufWarmup {
+ public:
+  /**
+   * Longest run of consecutive pages read with a single call.
+   */
+  static const std::uint32_t MAX_RUN_PAGES = 32;
+
+  /**
+   * Number of staged pages at which the workers wait for the buffer manager
+   * to catch up.
+   */
+  static const std::size_t MAX_STAGED_PAGES = 1024;
+
+  /**
+   * Starts loading the given pages.
+   *
+   * @param files     Files the pages belong to, opened by the caller.
+   * @param pages     For each file, the numbers of the pages to load.
+   * @param threads   Number of worker threads.
+   */
+  BufWarmup(const std::vector<File> &files,
+            const std::vector<std::vector<PageId>> &pages, unsigned threads);
+
+  /**
+   * Cancels the load and waits for the workers to exit.
+   */
+  ~BufWarmup();
+
+  BufWarmup(const BufWarmup &) = delete;
+  BufWarmup &operator=(const BufWarmup &) = delete;
+
+  /**
+   * Removes the given page from the staging area if it is there.
+   *
+   * @param file    File the page belongs to.
+   * @param pageNo  Page number.
+   * @param page    Staged page, returned by reference.
+   * @return  True if the page was staged.
+   */
+  bool take(const File &file, const PageId pageNo, Page &page);
+
+  /**
+   * Removes any staged page for installation into the buffer pool.
+   *
+   * @param file    File the page belongs to, returned by reference.
+   * @param pageNo  Page number, returned by reference.
+   * @param page    Staged page, returned by reference.
+   * @return  False if nothing is staged right now.
+   */
+  bool next(File *&file, PageId &pageNo, Page &page);
+
+  /**
+   * Notes that the buffer manager wrote or deleted a page, making any copy
+   * read by the workers stale.
+   *
+   * @param file    File the page belongs to.
+   * @param pageNo  Page number.
+   */
+  void invalidate(const File &file, const PageId pageNo);
+
+  /**
+   * Returns true once every run has been read and every staged page consumed.
+   */
+  bool done();
+
+ private:
+  /**
+   * @brief Consecutive pages of one file read with a single call.
+   */
+  struct Run {
+    std::size_t file;
+    PageId first;
+    std::uint32_t count;
+  };
+
+  typedef std::pair<std::size_t, PageId> Key;
+
+  /**
+   * Body of each worker thread.
+   */
+  void work();
+
+  /**
+   * Files being loaded, their descriptors for pread() and their index by
+   * name.
+   */
+  std::vector<File> files_;
+  std::vector<int> fds_;
+  std::map<std::string, std::size_t> fileIndex_;
+
+  /**
+   * Runs to read, and the next one to hand to a worker.
+   */
+  std::vector<Run> runs_;
+  std::atomic<std::size_t> nextRun_;
+
+  /**
+   * Protects staged_ and written_.
+   */
+  std::mutex mutex_;
+  std::condition_variable drained_;
+
+  /**
+   * Pages read but not yet installed or taken.
+   */
+  std::map<Key, Page> staged_;
+
+  /**
+   * Pages written or deleted by the buffer manager during the load.
+   */
+  std::set<Key> written_;
+
+  std::vector<std::thread> threads_;
+  std::atomic<unsigned> running_;
+  std::atomic<bool> cancelled_;
+};
+
+}  // namespace badgerdb
@@ -17,17 +17,26 @@
 
 #include "buffer.h"
 
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <map>
 
 #include "exceptions/bad_buffer_exception.h"
+#include "exceptions/checksum_mismatch_exception.h"
+#include "exceptions/file_not_found_exception.h"
 #include "exceptions/buffer_exceeded_exception.h"
 #include "exceptions/hash_not_found_exception.h"
 #include "exceptions/page_not_pinned_exception.h"
 #include "exceptions/page_pinned_exception.h"
 #include "exceptions/hash_already_present_exception.h"
 #include "exceptions/hash_table_exception.h"
+#include "exceptions/invalid_page_exception.h"
+#include "latency_histogram.h"
+#include "probes.h"
 
 namespace badgerdb
 {
@@ -37,25 +46,55 @@ namespace badgerdb
     return ((int)(bufs * 1.2) & -2) + 1;
   }
 
+  std::uint64_t BufStats::*const BufStats::FIELDS[BufStats::NUM_COUNTERS] = {
+      &BufStats::accesses, &BufStats::hits, &BufStats::misses,
+      &BufStats::diskreads, &BufStats::tierReads, &BufStats::diskwrites,
+      &BufStats::writeBatches, &BufStats::cleanEvictions,
+      &BufStats::dirtyEvictions, &BufStats::allocations, &BufStats::clockSteps,
+      &BufStats::longestSweep, &BufStats::pinWaits, &BufStats::allocFailures,
+      &BufStats::checksumFailures, &BufStats::bypassed};
+
   //----------------------------------------
   // Constructor of the class BufMgr
   //----------------------------------------
 
   BufMgr::BufMgr(std::uint32_t bufs)
       : numBufs(bufs),
+        pendingBufs(0),
+        log(nullptr),
+        doublewrite(nullptr),
+        victimCache(nullptr),
+        flashCache(nullptr),
         hashTable(HASHTABLE_SZ(bufs)),
         bufDescTable(bufs),
+        warmupCursor(0),
+        dirtySeq(0),
+        checkpointNext(0),
+        checkpointLsn(0),
+        checkpointing(false),
+        bypassFrames(0),
+        bypassHand(0),
+        cleanFirstWindow(0),
+        gaugeFrames(bufs),
+        gaugeValid(0),
+        gaugeDirty(0),
+        gaugePinned(0),
         bufPool(bufs)
   {
+    //descriptors are cheap to construct; the pages themselves are only
+    //materialized by bufPool when a frame is first used
     for (FrameId i = 0; i < bufs; i++)
-    {
       bufDescTable[i].frameNo = i;
-      bufDescTable[i].valid = false;
-    }
 
     clockHand = bufs - 1;
   }
 
+  BufMgr::~BufMgr()
+  {
+    //the sampler reads the counters, so it must stop before they go away
+    stopMetricsSampler();
+  }
+
   void BufMgr::advanceClock()
   {
 
@@ -67,66 +106,376 @@ namespace badgerdb
     clockHand = (clockHand + 1) % numBufs;
   }
 
-  void BufMgr::allocBuf(FrameId &frame)
+  void BufMgr::allocBuf(FrameId &frame, const File *file, PageId pageNo)
   {
+    applyPendingResize();
+
+    //frames below bypass are reserved for pages the admission filter turns
+    //away; the filter is off if it would leave the clock no frames
+    const std::uint32_t bypass = admission && bypassFrames < numBufs ? bypassFrames : 0;
 
-    //orginHand represents the first clockHand checked.
-    FrameId originHand = clockHand;
-    bool flag = false; //counter for amount of frames with > 0 pinCnts
+    //a group at its quota has to make room among its own pages
+    FrameGroup *group = file ? groupOf(*file) : nullptr;
+    const bool atQuota = group && group->quota && group->frames >= group->quota;
 
-    for (int i = 0; i < numBufs; i++)
+    //two full turns of the clock: the first may only clear refbits, so a
+    //frame which is unpinned must be found by the end of the second
+    for (std::uint32_t i = 0; i < 2 * numBufs; i++)
     {
-      if (bufDescTable[i].pinCnt == 0)
-        flag = true; 
+      advanceClock();
+      if (clockHand < bypass)
+        continue;
+      BufDesc &desc = bufDescTable[clockHand];
+
+      //an invalid frame can be used as is
+      if (!desc.valid)
+      {
+        if (atQuota)
+          continue;
+        countSweep(i + 1);
+        frame = clockHand;
+        return;
+      }
+
+      //pinned frames can never be replaced, nor frames other groups have
+      //reserved
+      if (desc.pinCnt > 0)
+      {
+        bufStats.add(BufStats::PIN_WAITS);
+        continue;
+      }
+      if (!mayReplace(desc, group))
+        continue;
+
+      //recently referenced frames get a second chance, unless their group
+      //holds more frames than its quota
+      const bool overQuota = desc.group && desc.group->quota &&
+                             desc.group->frames > desc.group->quota;
+      if (desc.refbit && !overQuota)
+      {
+        desc.refbit = false;
+        continue;
+      }
+
+      //a clean page close by is cheaper to evict than a dirty one
+      const FrameId victim = desc.dirty && cleanFirstWindow
+                                 ? cleanFirstVictim(clockHand, bypass, group)
+                                 : clockHand;
+      const BufDesc &victimDesc = bufDescTable[victim];
+
+      //the victim stays unless the new page is likely to be used more often
+      if (bypass && file && pageNo != Page::INVALID_NUMBER &&
+          admission->estimate(pageKey(*file, pageNo)) <=
+              admission->estimate(pageKey(victimDesc.file, victimDesc.pageNo)) &&
+          allocBypassFrame(frame))
+      {
+        bufStats.add(BufStats::BYPASSED);
+        countSweep(i + 1);
+        return;
+      }
+
+      evict(victim);
+      countSweep(i + 1);
+
+      frame = victim; //return by reference
+      return;
     }
 
-    if (flag == false)
+    bufStats.add(BufStats::ALLOC_FAILURES);
+    throw BufferExceededException();
+  }
+
+  void BufMgr::countSweep(std::uint32_t steps)
+  {
+    bufStats.add(BufStats::ALLOCATIONS);
+    bufStats.add(BufStats::CLOCK_STEPS, steps);
+    bufStats.raise(BufStats::LONGEST_SWEEP, steps);
+  }
+
+  BufStats BufMgr::getBufStats() const
+  {
+    BufStats stats;
+    for (std::size_t i = 0; i < BufStats::NUM_COUNTERS; i++)
+      stats.*BufStats::FIELDS[i] = i == BufStats::LONGEST_SWEEP ? bufStats.max(i) : bufStats.sum(i);
+    return stats;
+  }
+
+  FrameId BufMgr::cleanFirstVictim(FrameId victim, std::uint32_t first,
+                                   const FrameGroup *group) const
+  {
+    const std::uint32_t window = std::min(cleanFirstWindow, numBufs - first);
+    for (std::uint32_t i = 1; i < window; i++)
     {
-      std::cout << "BufferExceededException() Thrown" << std::endl;
-      throw BufferExceededException();
+      const FrameId next = first + (victim - first + i) % (numBufs - first);
+      const BufDesc &other = bufDescTable[next];
+      if (other.valid && !other.dirty && other.pinCnt == 0 && !other.refbit &&
+          mayReplace(other, group))
+        return next;
     }
+    return victim;
+  }
 
-    //allocate free frame from clock algo
-    while (true)
+  bool BufMgr::mayReplace(const BufDesc &desc, const FrameGroup *group) const
+  {
+    //a group at its quota replaces its own pages only
+    if (group && group->quota && group->frames >= group->quota)
+      return desc.group == group;
+
+    //replacing a page of the same group leaves its occupancy unchanged
+    return !desc.group || desc.group == group ||
+           desc.group->frames > desc.group->reserved;
+  }
+
+  bool BufMgr::allocBypassFrame(FrameId &frame)
+  {
+    for (std::uint32_t i = 0; i < bypassFrames; i++)
     {
+      bypassHand = (bypassHand + 1) % bypassFrames;
+      BufDesc &desc = bufDescTable[bypassHand];
+      if (desc.valid && desc.pinCnt > 0)
+        continue;
+      if (desc.valid)
+        evict(bypassHand);
+      frame = bypassHand;
+      return true;
+    }
+    return false;
+  }
 
-      if (bufDescTable[clockHand].refbit == false && bufDescTable[clockHand].pinCnt == 0)
-      {
-        // allocate this frame
-        if (bufDescTable[clockHand].valid == true)
-        {
-          //remove from hashtable
-          hashTable.remove(bufDescTable[clockHand].file, bufDescTable[clockHand].pageNo);
-        }
+  std::uint64_t BufMgr::pageKey(const File &file, PageId pageNo)
+  {
+    return std::hash<std::string>()(file.filename()) ^
+           (static_cast<std::uint64_t>(pageNo) * 0x9E3779B97F4A7C15ull);
+  }
 
-        if (bufDescTable[clockHand].dirty == true)
-        {
-          //writes page back to disk
-          try {
-            flushFile(bufDescTable[clockHand].file);
-          } catch (BadBufferException e) {
-            std::cout << "File not flushed" << std::endl;
-          }
-        }
-        
-        frame = clockHand; //return by reference
-        //bufDescTable[frame].Set();
-        return;             //leave while loop
-      }
+  void BufMgr::setAdmissionFilter(bool enabled, std::uint32_t bypass)
+  {
+    admission.reset(enabled ? new FrequencySketch(numBufs) : nullptr);
+    bypassFrames = enabled ? bypass : 0;
+    bypassHand = 0;
+  }
 
-      else
+  const std::string &BufMgr::groupName(const File &file) const
+  {
+    auto assigned = fileGroups.find(file.filename());
+    return assigned == fileGroups.end() ? file.filename() : assigned->second;
+  }
+
+  FrameGroup *BufMgr::groupOf(const File &file)
+  {
+    //without any limits set, no lookup at all
+    if (frameGroups.empty())
+      return nullptr;
+    auto group = frameGroups.find(groupName(file));
+    return group == frameGroups.end() ? nullptr : &group->second;
+  }
+
+  void BufMgr::regroup()
+  {
+    for (auto &group : frameGroups)
+      group.second.frames = 0;
+    for (BufDesc &desc : bufDescTable)
+    {
+      desc.group = desc.valid ? groupOf(desc.file) : nullptr;
+      if (desc.group)
+        desc.group->frames++;
+    }
+  }
+
+  void BufMgr::setFrameQuota(const std::string &group, std::uint32_t reserved,
+                             std::uint32_t quota)
+  {
+    FrameGroup &limits = frameGroups[group];
+    limits.reserved = reserved;
+    limits.quota = quota;
+    regroup();
+  }
+
+  void BufMgr::clearFrameQuota(const std::string &group)
+  {
+    frameGroups.erase(group);
+    regroup();
+  }
+
+  void BufMgr::setFileGroup(const std::string &filename, const std::string &group)
+  {
+    if (group.empty())
+      fileGroups.erase(filename);
+    else
+      fileGroups[filename] = group;
+    regroup();
+  }
+
+  std::map<std::string, GroupOccupancy> BufMgr::getGroupOccupancy() const
+  {
+    std::map<std::string, GroupOccupancy> occupancy;
+    for (const auto &group : frameGroups)
+      occupancy[group.first] = {0, 0, 0, group.second.reserved, group.second.quota};
+    for (const BufDesc &desc : bufDescTable)
+    {
+      if (!desc.valid)
+        continue;
+      auto entry = occupancy.emplace(groupName(desc.file), GroupOccupancy{0, 0, 0, 0, 0}).first;
+      entry->second.frames++;
+      if (desc.pinCnt > 0)
+        entry->second.pinned++;
+      if (desc.dirty)
+        entry->second.dirty++;
+    }
+    return occupancy;
+  }
+
+  void BufMgr::writeBack(FrameId frameNo)
+  {
+    //even a single page must not be written in place unprotected
+    if (doublewrite)
+    {
+      writeBack(std::vector<FrameId>(1, frameNo));
+      return;
+    }
+
+    LatencyTimer timer(LatencyOp::WRITEBACK);
+    const std::uint64_t probeStartNs = probeStart(BADGERDB_PROBE_ENABLED(writeback));
+    BufDesc &desc = bufDescTable[frameNo];
+    Page &page = bufPool[frameNo];
+
+    //log-before-data: the log must be durable up to the page's last change
+    if (log)
+      log->flush(page.page_lsn());
+
+    desc.file.writePage(page);
+    if (desc.dirty)
+      gaugeDirty.fetch_sub(1, std::memory_order_relaxed);
+    desc.dirty = false;
+    desc.recLsn = 0;
+    bufStats.add(BufStats::DISK_WRITES);
+    bufStats.add(BufStats::WRITE_BATCHES);
+    countQuery(&QueryStats::writebacks);
+    countQuery(&QueryStats::bytesWritten, Page::SIZE);
+
+    if (warmup)
+      warmup->invalidate(desc.file, desc.pageNo);
+    if (flashCache)
+      flashCache->invalidate(desc.file, desc.pageNo);
+    BADGERDB_PROBE4(writeback, desc.file.filename().c_str(), desc.pageNo, frameNo,
+                    probeElapsed(probeStartNs));
+  }
+
+  void BufMgr::writeBack(const std::vector<FrameId> &frames)
+  {
+    if (!doublewrite)
+    {
+      for (FrameId frameNo : frames)
+        writeBack(frameNo);
+      return;
+    }
+
+    LatencyTimer timer(LatencyOp::WRITEBACK);
+    const std::uint64_t probeStartNs = probeStart(BADGERDB_PROBE_ENABLED(writeback));
+    std::vector<std::pair<File *, const Page *>> pages;
+    Lsn lsn = 0;
+    for (FrameId frameNo : frames)
+    {
+      pages.emplace_back(&bufDescTable[frameNo].file, &bufPool[frameNo]);
+      lsn = std::max(lsn, bufPool[frameNo].page_lsn());
+    }
+
+    //log-before-data for the whole batch at once
+    if (log)
+      log->flush(lsn);
+
+    doublewrite->write(pages);
+    //every page of a batch is reported with the latency of the whole batch
+    const std::uint64_t batchNs = probeElapsed(probeStartNs);
+    bufStats.add(BufStats::DISK_WRITES, pages.size());
+    bufStats.add(BufStats::WRITE_BATCHES);
+    countQuery(&QueryStats::writebacks, pages.size());
+    countQuery(&QueryStats::bytesWritten, pages.size() * Page::SIZE);
+
+    for (FrameId frameNo : frames)
+    {
+      BufDesc &desc = bufDescTable[frameNo];
+      if (desc.dirty)
+        gaugeDirty.fetch_sub(1, std::memory_order_relaxed);
+      desc.dirty = false;
+      desc.recLsn = 0;
+      if (warmup)
+        warmup->invalidate(desc.file, desc.pageNo);
+      if (flashCache)
+        flashCache->invalidate(desc.file, desc.pageNo);
+      BADGERDB_PROBE4(writeback, desc.file.filename().c_str(), desc.pageNo, frameNo,
+                      batchNs);
+    }
+  }
+
+  void BufMgr::markDirty(FrameId frameNo)
+  {
+    BufDesc &desc = bufDescTable[frameNo];
+
+    Lsn lsn = 0;
+    if (log)
+      lsn = log->logPage(desc.file, bufPool[frameNo]);
+    else
+      lsn = ++dirtySeq;
+
+    //only the first change since the page was last written counts
+    if (!desc.dirty)
+    {
+      desc.recLsn = lsn;
+      gaugeDirty.fetch_add(1, std::memory_order_relaxed);
+      countQuery(&QueryStats::dirtied);
+    }
+    desc.dirty = true;
+  }
+
+  void BufMgr::evict(FrameId frameNo)
+  {
+    BufDesc &desc = bufDescTable[frameNo];
+    bufStats.add(desc.dirty ? BufStats::DIRTY_EVICTIONS : BufStats::CLEAN_EVICTIONS);
+    BADGERDB_PROBE4(evict, desc.file.filename().c_str(), desc.pageNo, frameNo, desc.dirty);
+
+    //writes page back to disk, together with the dirty frames the clock
+    //will reach next when each batch costs an extra write
+    if (desc.dirty && doublewrite)
+    {
+      std::vector<FrameId> batch(1, frameNo);
+      const std::uint32_t window = std::min<std::uint32_t>(
+          4 * DOUBLEWRITE_BATCH_PAGES, bufDescTable.size());
+      for (std::uint32_t i = 1; i < window && batch.size() < DOUBLEWRITE_BATCH_PAGES; i++)
       {
-        advanceClock();
-        if (clockHand == originHand){
-          frame = clockHand;
-          return;
-        }
+        const FrameId next = (frameNo + i) % bufDescTable.size();
+        const BufDesc &other = bufDescTable[next];
+        if (other.valid && other.dirty && other.pinCnt == 0)
+          batch.push_back(next);
       }
+      writeBack(batch);
     }
+    else if (desc.dirty)
+      writeBack(frameNo);
+
+    //the now clean page is kept compressed rather than discarded, and
+    //offered to the flash cache
+    if (victimCache)
+      victimCache->insert(desc.file, bufPool[frameNo]);
+    if (flashCache)
+      flashCache->insert(desc.file, bufPool[frameNo]);
+
+    //remove from hashtable and unswizzle any swips to the frame
+    hashTable.remove(desc.file, desc.pageNo);
+    clearFrame(frameNo);
+  }
+
+  void BufMgr::readPage(File &file, const PageId pageNo, Page *&page, const char *pinTag)
+  {
+    //return (kind of) a pointer to the frame containing the page via the page paramter
+    page = &(this->bufPool[fetchPage(file, pageNo, pinTag)]);
   }
 
-  void BufMgr::readPage(File &file, const PageId pageNo, Page *&page)
+  FrameId BufMgr::fetchPage(File &file, const PageId pageNo, const char *pinTag)
   {
+    LatencyTimer timer(LatencyOp::READ_HIT);
+    const std::uint64_t probeStartNs = probeStart(BADGERDB_PROBE_ENABLED(read_hit) ||
+                                                  BADGERDB_PROBE_ENABLED(read_miss));
 
     //check if the page is already in buffer pool by invoking the BufHashTbl::lookup method on the hashtable to get a frame number.
     //This may throw a HashNotFoundException so be ready to catch it.
@@ -141,12 +490,52 @@ namespace badgerdb
     catch (HashNotFoundException &e)
     { //Case 1: hash is not found in the hashTable
 
-      //  -Call allocBuf() to allocate a buffer frame
-      allocBuf(frameNo);
+      //  -Call allocBuf() to allocate a buffer frame, which the admission
+      //   filter may make a bypass frame
+      timer.setOp(LatencyOp::READ_MISS);
+      bufStats.add(BufStats::ACCESSES);
+      bufStats.add(BufStats::MISSES);
+      countQuery(&QueryStats::misses);
+      trackAccess(file, pageNo, false);
+      traceRequest(TraceRecord::READ, file, pageNo);
+      recordAccess(file, pageNo);
+      allocBuf(frameNo, &file, pageNo);
 
       //  -Then, call file.readPage() to read the page from disk to buffer bool frame.
-      Page readPage = file.readPage(pageNo);
-      this->bufPool[frameNo] = readPage;
+      //   A page already read by a background warm-up, kept in the victim
+      //   tier or cached on flash is taken from there.
+      //   The temporary page is only built when there is a tier to fill it,
+      //   as constructing one clears a whole page.
+      bool cached = false;
+      if (warmup || victimCache || flashCache)
+      {
+        Page cachedPage;
+        cached = (warmup && warmup->take(file, pageNo, cachedPage)) ||
+                 (victimCache && victimCache->take(file, pageNo, cachedPage)) ||
+                 (flashCache && flashCache->lookup(file, pageNo, cachedPage));
+        if (cached)
+          this->bufPool.assign(frameNo, std::move(cachedPage));
+      }
+      if (cached)
+      {
+        bufStats.add(BufStats::TIER_READS);
+      }
+      else
+      {
+        try
+        {
+          this->bufPool.assign(frameNo, file.readPage(pageNo));
+          bufStats.add(BufStats::DISK_READS);
+          countQuery(&QueryStats::diskReads);
+          countQuery(&QueryStats::bytesRead, Page::SIZE);
+        }
+        catch (ChecksumMismatchException &e)
+        {
+          //the frame is left free; the caller decides how to repair the page
+          bufStats.add(BufStats::CHECKSUM_FAILURES);
+          throw;
+        }
+      }
 
       //should catch INVALIDPAGEEXCEPTION (#TODO: Confirm and implement catch)
       //  -Next, insert the page into the hashTable
@@ -154,11 +543,20 @@ namespace badgerdb
 
       //  -Finally, invoke Set() on the frame to set ut up properly
       //          +Set() will automatically leave the pinCnt = 1
-      this->bufDescTable[frameNo].Set(file, pageNo);
-      
-      //  -Return (kind of) a pointer to the frame containing the page via the page paramter
-      page = &(this->bufPool[frameNo]);
-      return;
+      this->bufDescTable[frameNo].Set(file, pageNo, groupOf(file));
+      gaugeValid.fetch_add(1, std::memory_order_relaxed);
+      gaugePinned.fetch_add(1, std::memory_order_relaxed);
+      trackPin(frameNo, pinTag);
+      BADGERDB_PROBE4(read_miss, file.filename().c_str(), pageNo, frameNo,
+                      probeElapsed(probeStartNs));
+
+      //a miss is a good moment to install a few more warmed-up pages and
+      //to trickle out a few pages of a running checkpoint
+      if (warmup)
+        pollResidentPageLoad();
+      if (checkpointing)
+        checkpointStep();
+      return frameNo;
     }
 
     // Case 2:
@@ -169,23 +567,29 @@ namespace badgerdb
 
     //set the appropraiate refbit
     this->bufDescTable[frameNo].refbit = true; //set to refbit to true/1
+    bufStats.add(BufStats::ACCESSES);
+    bufStats.add(BufStats::HITS);
+    countQuery(&QueryStats::hits);
+    trackAccess(file, pageNo, true);
+    traceRequest(TraceRecord::READ, file, pageNo, TraceRecord::HIT);
+    recordAccess(file, pageNo);
     
-    //clarify the value to increment 
-    const int ONE = 1;
-
     //increment the pinCnt for the page 
-    this->bufDescTable[frameNo].pinCnt = this->bufDescTable[frameNo].pinCnt + ONE;
+    pin(this->bufDescTable[frameNo]);
+    trackPin(frameNo, pinTag);
+    this->bufDescTable[frameNo].hits++;
     
+    BADGERDB_PROBE4(read_hit, file.filename().c_str(), pageNo, frameNo,
+                    probeElapsed(probeStartNs));
 
-    //return a pointer to the frame containing the page via the page parameter
-    // to do so, set page = the address of bufPool[#]
-    page = &(this->bufPool[frameNo]);
-
-    return;
+    return frameNo;
   }
 
   void BufMgr::unPinPage(File &file, const PageId pageNo, const bool dirty)
   {
+    LatencyTimer timer(LatencyOp::UNPIN);
+    applyPendingResize();
+    traceRequest(TraceRecord::UNPIN, file, pageNo, dirty ? TraceRecord::DIRTY : 0);
 
     FrameId frameNo;
 
@@ -201,17 +605,21 @@ namespace badgerdb
 
     } //else, page was found in the hash table.
 
-    //if dirty is true, sets the dirty bit to true
+    //if dirty is true, sets the dirty bit to true and logs the change
     if (dirty)
-    {
-      this->bufDescTable[frameNo].dirty = true;
-    }
+      markDirty(frameNo);
 
     //pinCnt logic
     if (this->bufDescTable[frameNo].pinCnt != 0)
     {
       //if the pinCnt is larger than 0, then decrement pinCnt by 1
-      this->bufDescTable[frameNo].pinCnt = this->bufDescTable[frameNo].pinCnt - 1;
+      unpin(this->bufDescTable[frameNo]);
+      if (pinTracker)
+        pinTracker->unpinned(frameNo);
+
+      //a frame left over from shrinking the pool is released once unpinned
+      if (frameNo >= numBufs && this->bufDescTable[frameNo].pinCnt == 0)
+        trimPool();
     }
     else
     { // else, pinCnt < 1 and it cant be decremented. throw PageNotPinnedException
@@ -226,66 +634,133 @@ namespace badgerdb
     return;
   }
 
-void BufMgr::allocPage(File& file, PageId& pageNo, Page*& page) {
+  void BufMgr::readPage(File &file, Swip &swip, Page *&page, const char *pinTag)
+  {
+    //a swizzled swip points straight at its frame, no hash lookup needed
+    if (swip.isSwizzled())
+    {
+      LatencyTimer timer(LatencyOp::READ_HIT);
+      const std::uint64_t probeStartNs = probeStart(BADGERDB_PROBE_ENABLED(read_hit));
+      BufDesc *desc = swip.desc();
+      if (desc->file.filename() != file.filename())
+        throw InvalidPageException(desc->pageNo, file.filename());
+      desc->refbit = true;
+      pin(*desc);
+      trackPin(desc->frameNo, pinTag);
+      desc->hits++;
+      bufStats.add(BufStats::ACCESSES);
+      bufStats.add(BufStats::HITS);
+      countQuery(&QueryStats::hits);
+      trackAccess(desc->file, desc->pageNo, true);
+      traceRequest(TraceRecord::READ, desc->file, desc->pageNo, TraceRecord::HIT);
+      recordAccess(desc->file, desc->pageNo);
+      page = &(bufPool[desc->frameNo]);
+      BADGERDB_PROBE4(read_hit, desc->file.filename().c_str(), desc->pageNo,
+                      desc->frameNo, probeElapsed(probeStartNs));
+      return;
+    }
 
-  // Allocate an empty page in the specified file
-  Page allocatedPage = file.allocatePage();
-  PageId allocatedPageNo = allocatedPage.page_number();
+    const FrameId frameNo = fetchPage(file, swip.pageId(), pinTag);
+    page = &(bufPool[frameNo]);
 
-  // Obtain a buffer pool frame (id passed via FrameId variable)
-  FrameId frame;
+    //remember the swip so that eviction can unswizzle it again
+    bufDescTable[frameNo].swips.push_back(&swip);
+    swip.swizzle(&bufDescTable[frameNo]);
+  }
 
-  //try {
-    //std::cout << "allocBuff" << std::endl;
-    allocBuf(frame);
-  //} catch (BufferExceededException e) {
-    //std::cout << "Buffer Full" << std::endl;
-    //return;
-  //}
+  void BufMgr::unPinPage(File &file, const Swip &swip, const bool dirty)
+  {
+    if (!swip.isSwizzled())
+    {
+      //the page is not resident, let the regular path report it
+      unPinPage(file, swip.pageId(), dirty);
+      return;
+    }
 
-  //std::cout << "allocBuff exit " << std::endl;
+    LatencyTimer timer(LatencyOp::UNPIN);
+    BufDesc *desc = swip.desc();
+    traceRequest(TraceRecord::UNPIN, file, desc->pageNo, dirty ? TraceRecord::DIRTY : 0);
+    if (desc->pinCnt == 0)
+      throw PageNotPinnedException(file.filename(), desc->pageNo, desc->frameNo);
 
-  // insert entry into hash table
+    if (dirty)
+      markDirty(desc->frameNo);
+    unpin(*desc);
+    if (pinTracker)
+      pinTracker->unpinned(desc->frameNo);
 
-  try {
-    //std::cout << "insert " << std::endl;
-    hashTable.insert(file, allocatedPageNo, frame);
-  } catch (HashAlreadyPresentException e) {
-    
-    // the corresponding page already exists in the hash table
-    //std::cout << e.message();
-    return;
-  } catch (HashTableException e) {
-    
-    // could not create a new bucket as running of memory
-    //std::cout << e.message();
-    return;
+    if (desc->frameNo >= numBufs && desc->pinCnt == 0)
+      trimPool();
+  }
+
+  void BufMgr::unswizzle(Swip &swip)
+  {
+    if (!swip.isSwizzled())
+      return;
+
+    BufDesc *desc = swip.desc();
+    desc->swips.erase(std::remove(desc->swips.begin(), desc->swips.end(), &swip),
+                      desc->swips.end());
+    swip.unswizzle(desc->pageNo);
   }
 
-  //std::cout << "exit insert " << std::endl;
+void BufMgr::allocPage(File& file, PageId& pageNo, Page*& page,
+                       const char* pinTag) {
+  LatencyTimer timer(LatencyOp::ALLOC_PAGE);
+
+  // Obtain a buffer pool frame (id passed via FrameId variable) before
+  // touching the file, so a full pool does not leak a page in the file
+  FrameId frame;
+  allocBuf(frame, &file);
+
+  // Allocate an empty page in the specified file
+  bufPool.assign(frame, file.allocatePage());
+  bufStats.add(BufStats::ACCESSES);
+  bufStats.add(BufStats::DISK_READS);
+  countQuery(&QueryStats::allocations);
+  PageId allocatedPageNo = bufPool[frame].page_number();
+
+  // a page number freed and reused since a dump is no longer worth warming,
+  // nor is an old copy of it in the victim tier
+  if (warmup)
+    warmup->invalidate(file, allocatedPageNo);
+  if (victimCache)
+    victimCache->invalidate(file, allocatedPageNo);
+  if (flashCache)
+    flashCache->invalidate(file, allocatedPageNo);
+
+  // insert entry into hash table
+  hashTable.insert(file, allocatedPageNo, frame);
 
   // invoke Set() on the frame
-  //std::cout << frame << std::endl
-  bufDescTable[frame].Set(file, allocatedPageNo);
-  //std::cout << "sets " << std::endl;
+  bufDescTable[frame].Set(file, allocatedPageNo, groupOf(file));
+  gaugeValid.fetch_add(1, std::memory_order_relaxed);
+  gaugePinned.fetch_add(1, std::memory_order_relaxed);
+  trackPin(frame, pinTag);
+
+  traceRequest(TraceRecord::ALLOC, file, allocatedPageNo);
 
   // return the page number and a pointer to the buffer frame allocated
   page = &(bufPool[frame]);
-  pageNo = bufDescTable[frame].pageNo;
+  pageNo = allocatedPageNo;
 }
 
   void BufMgr::flushFile(File &file)
   {
+    traceRequest(TraceRecord::FLUSH_FILE, file, Page::INVALID_NUMBER);
+    const std::uint64_t probeStartNs = probeStart(BADGERDB_PROBE_ENABLED(flush_file));
 
     FrameId frameNo;
+    std::vector<FrameId> flushed;
+    std::vector<FrameId> dirtyFrames;
 
     //Scan bufTable by iterating through each frame in buffer
-    for (frameNo = 0; numBufs > frameNo; frameNo++)
+    for (frameNo = 0; bufDescTable.size() > frameNo; frameNo++)
     {
 
       //get the information needed from the bufTable for the current iteration of frameNo
-      BufDesc checkBuf = this->bufDescTable[frameNo];
-      File checkFile = checkBuf.file;
+      BufDesc &checkBuf = this->bufDescTable[frameNo];
+      File &checkFile = checkBuf.file;
       int checkPinCount = checkBuf.pinCnt;
       PageId checkPageNo = checkBuf.pageNo;
 
@@ -309,72 +784,394 @@ void BufMgr::allocPage(File& file, PageId& pageNo, Page*& page) {
           throw BadBufferException(frameNo, checkBuf.dirty, checkFile.isValid(), checkBuf.refbit);
         }
 
-        //check to see if the page is dirty
-        if (checkBuf.dirty == true)
-        {
-
-          //if page is dirty, call file.writePage() to flush the page to disk.
-          Page pageToWrite = this->bufPool[frameNo];
-          checkFile.writePage(pageToWrite);
+        flushed.push_back(frameNo);
 
-          //then set the dirty bit for the page to false (0)
-          checkBuf.dirty = false;
-
-          //remove page from the hashTable (regardless if dirty or not)
-          this->hashTable.remove(checkFile, checkPageNo);
+        //dirty pages are written back together as one batch below
+        if (checkBuf.dirty == true)
+          dirtyFrames.push_back(frameNo);
+      }
+    }
 
-          //invoke clear() method of BufDesc for the page frame.
-          //this->bufDescTable.clear();
-          this->bufDescTable[frameNo].clear();
-        }
-        else if (!checkBuf.dirty) //if the page is not dirty, just remove and clear.
-        {
+    //write the dirty pages back to disk in page order, which also
+    //sets the dirty bit for the pages to false (0)
+    std::sort(dirtyFrames.begin(), dirtyFrames.end(), [this](FrameId a, FrameId b) {
+      return bufDescTable[a].pageNo < bufDescTable[b].pageNo;
+    });
+    writeBack(dirtyFrames);
 
-          //remove page from the hashTable (regardless if dirty or not)
-          this->hashTable.remove(checkFile, checkPageNo);
+    for (FrameId flushedFrame : flushed)
+    {
+      //remove page from the hashTable (regardless if dirty or not)
+      BufDesc &flushedBuf = this->bufDescTable[flushedFrame];
+      this->hashTable.remove(flushedBuf.file, flushedBuf.pageNo);
 
-          //invoke clear() method of BufDesc for the page frame.
-          this->bufDescTable[frameNo].clear();
-          //this->bufDescTable.clear();
-        }
-      }
+      //invoke clear() method of BufDesc for the page frame.
+      clearFrame(flushedFrame);
     }
 
+    //the file may be closed or replaced once flushed, so its pages must
+    //not be served from the victim tier or flash cache either
+    if (victimCache)
+      victimCache->invalidate(file);
+    if (flashCache)
+      flashCache->invalidate(file);
+    BADGERDB_PROBE3(flush_file, file.filename().c_str(), flushed.size(),
+                    probeElapsed(probeStartNs));
+
     //once we iterate through each, return
     return;
   }
   
 void BufMgr::disposePage(File& file, const PageId PageNo) {
-  
-  // Get the frame id (id passed via FrameId variable)
+  traceRequest(TraceRecord::DISPOSE, file, PageNo);
+
+  // Free the frame allocated to the page, if it is in the buffer pool
   FrameId frame;
-  hashTable.lookup(file, PageNo, frame);
-
-  for (FrameId i = 0; i < bufDescTable.size(); i++) {
-
-    // Check that page to be deleted is allocated a frame within buffer pool
-    if (bufDescTable[i].frameNo == frame) {
-      
-      // Free the allocated frame
-      bufDescTable[frame].clear();
-
-      // Remove entry from hash table
-      try {
-        hashTable.remove(file, PageNo);
-      } 
-      catch (HashNotFoundException e) {
-        std::cout << e.message();
+  try {
+    hashTable.lookup(file, PageNo, frame);
+    hashTable.remove(file, PageNo);
+    clearFrame(frame);
+  } catch (HashNotFoundException &e) {
+  }
+
+  // Delete the page from the file itself
+  if (warmup)
+    warmup->invalidate(file, PageNo);
+  if (victimCache)
+    victimCache->invalidate(file, PageNo);
+  if (flashCache)
+    flashCache->invalidate(file, PageNo);
+  file.deletePage(PageNo);
+}
+
+
+  void BufMgr::resize(std::uint32_t bufs)
+  {
+    bufs = std::max<std::uint32_t>(bufs, 1);
+
+    //frames beyond the current end of the pool are added empty
+    for (FrameId i = bufDescTable.size(); i < bufs; i++)
+    {
+      bufDescTable.emplace_back();
+      bufDescTable.back().frameNo = i;
+      bufPool.emplace_back();
+    }
+
+    //the hash table was sized for the pool it was built for; once the pool
+    //has more than doubled, chains would grow long, so it is rebuilt
+    if (HASHTABLE_SZ(bufs) > 2 * hashTable.size())
+      hashTable.rehash(HASHTABLE_SZ(bufs));
+
+    numBufs = bufs;
+    gaugeFrames.store(bufs, std::memory_order_relaxed);
+    if (clockHand >= numBufs)
+      clockHand = numBufs - 1;
+
+    trimPool();
+  }
+
+  void BufMgr::applyPendingResize()
+  {
+    const std::uint32_t bufs = pendingBufs.exchange(0);
+    if (bufs != 0)
+      resize(bufs);
+  }
+
+  void BufMgr::trimPool()
+  {
+    //evict every unpinned page in a frame that is being removed
+    for (FrameId i = numBufs; i < bufDescTable.size(); i++)
+    {
+      BufDesc &desc = bufDescTable[i];
+      if (desc.valid && desc.pinCnt == 0)
+        evict(i);
+      if (!desc.valid)
+        bufPool.release(i);
+    }
+
+    //release the empty frames at the end of the pool
+    while (bufDescTable.size() > numBufs && !bufDescTable.back().valid)
+    {
+      bufDescTable.pop_back();
+      bufPool.pop_back();
+    }
+  }
+
+  void BufMgr::dumpResidentPages(const std::string &path)
+  {
+    std::vector<FrameId> frames;
+    for (FrameId i = 0; i < bufDescTable.size(); i++)
+    {
+      if (bufDescTable[i].valid)
+        frames.push_back(i);
+    }
+
+    //hottest first: recently referenced, then most requested
+    std::stable_sort(frames.begin(), frames.end(), [this](FrameId a, FrameId b) {
+      const BufDesc &da = bufDescTable[a];
+      const BufDesc &db = bufDescTable[b];
+      if (da.refbit != db.refbit)
+        return da.refbit;
+      return da.hits > db.hits;
+    });
+
+    //write to a temporary file first so a crash never leaves half a dump
+    const std::string tmpPath = path + ".tmp";
+    {
+      std::ofstream out(tmpPath, std::ios::trunc);
+      out << "# badgerdb resident pages v1\n";
+      for (FrameId i : frames)
+        out << bufDescTable[i].pageNo << "\t" << bufDescTable[i].file.filename() << "\n";
+    }
+    std::rename(tmpPath.c_str(), path.c_str());
+  }
+
+  void BufMgr::loadResidentPages(const std::string &path, unsigned threads)
+  {
+    warmup.reset();
+
+    std::ifstream in(path);
+    std::vector<File> files;
+    std::vector<std::vector<PageId>> pages;
+    std::map<std::string, std::size_t> fileIndex;
+    std::uint32_t listed = 0;
+
+    std::string line;
+    while (listed < numBufs && std::getline(in, line))
+    {
+      const std::size_t tab = line.find('\t');
+      if (line.empty() || line[0] == '#' || tab == std::string::npos)
+        continue;
+
+      const std::string filename = line.substr(tab + 1);
+      auto index = fileIndex.find(filename);
+      if (index == fileIndex.end())
+      {
+        //files which have gone away since the dump are skipped
+        try
+        {
+          files.push_back(File::open(filename));
+        }
+        catch (FileNotFoundException &e)
+        {
+          continue;
+        }
+        pages.emplace_back();
+        index = fileIndex.emplace(filename, files.size() - 1).first;
       }
+      pages[index->second].push_back(std::stoul(line.substr(0, tab)));
+      listed++;
     }
+
+    if (listed == 0)
+      return;
+    warmupCursor = 0;
+    warmup.reset(new BufWarmup(files, pages, threads));
+  }
+
+  std::uint32_t BufMgr::pollResidentPageLoad(std::uint32_t maxPages)
+  {
+    std::uint32_t installed = 0;
+    while (warmup && installed < maxPages)
+    {
+      //warmed-up pages only ever go into free frames
+      while (warmupCursor < numBufs && bufDescTable[warmupCursor].valid)
+        warmupCursor++;
+      if (warmupCursor >= numBufs)
+      {
+        warmup.reset();
+        break;
+      }
+
+      File *file;
+      PageId pageNo;
+      Page warmPage;
+      if (!warmup->next(file, pageNo, warmPage))
+      {
+        if (warmup->done())
+          warmup.reset();
+        break;
+      }
+
+      //skip pages that have been read in the meantime
+      FrameId frameNo;
+      try
+      {
+        hashTable.lookup(*file, pageNo, frameNo);
+        continue;
+      }
+      catch (HashNotFoundException &e)
+      {
+      }
+
+      bufPool.assign(warmupCursor, std::move(warmPage));
+      hashTable.insert(*file, pageNo, warmupCursor);
+      BufDesc &desc = bufDescTable[warmupCursor];
+      desc.Set(*file, pageNo, groupOf(*file));
+      desc.pinCnt = 0;
+      gaugeValid.fetch_add(1, std::memory_order_relaxed);
+      desc.refbit = false;
+      installed++;
+    }
+    return installed;
+  }
+
+  std::vector<DirtyPage> BufMgr::getDirtyPageTable() const
+  {
+    std::vector<DirtyPage> table;
+    for (FrameId i = 0; i < bufDescTable.size(); i++)
+    {
+      const BufDesc &desc = bufDescTable[i];
+      if (desc.valid && desc.dirty)
+        table.push_back({i, desc.file.filename(), desc.pageNo, desc.recLsn});
+    }
+    return table;
+  }
+
+  std::size_t BufMgr::beginCheckpoint()
+  {
+    checkpointPages = getDirtyPageTable();
+    checkpointNext = 0;
+    checkpointing = true;
+
+    //writing in page order keeps the writes as sequential as possible
+    std::sort(checkpointPages.begin(), checkpointPages.end(),
+              [](const DirtyPage &a, const DirtyPage &b) {
+                if (a.filename != b.filename)
+                  return a.filename < b.filename;
+                return a.pageNo < b.pageNo;
+              });
+
+    //every change before this point is either on disk already or in the table
+    if (log)
+    {
+      std::vector<std::tuple<std::string, PageId, Lsn>> pages;
+      for (const DirtyPage &entry : checkpointPages)
+        pages.emplace_back(entry.filename, entry.pageNo, entry.recLsn);
+      checkpointLsn = log->logCheckpointBegin(pages);
+    }
+    else
+      checkpointLsn = dirtySeq;
+
+    return checkpointPages.size();
+  }
+
+  std::size_t BufMgr::checkpointStep(std::uint32_t maxPages)
+  {
+    if (!checkpointing)
+      return 0;
+
+    std::vector<FrameId> batch;
+    for (; batch.size() < maxPages && checkpointNext < checkpointPages.size();
+         checkpointNext++)
+    {
+      const DirtyPage &entry = checkpointPages[checkpointNext];
+      if (entry.frameNo >= bufDescTable.size())
+        continue;
+
+      //pages written back or evicted since the checkpoint began, and pages
+      //only dirtied after it began, have nothing left to write
+      BufDesc &desc = bufDescTable[entry.frameNo];
+      if (!desc.valid || !desc.dirty || desc.pageNo != entry.pageNo ||
+          desc.file.filename() != entry.filename ||
+          desc.recLsn > checkpointLsn)
+        continue;
+
+      //a pinned page may hold changes not logged yet; log its current image
+      //so the page on disk is never ahead of the log
+      if (desc.pinCnt > 0 && log)
+        log->logPage(desc.file, bufPool[entry.frameNo]);
+
+      batch.push_back(entry.frameNo);
+    }
+    writeBack(batch);
+
+    if (checkpointNext < checkpointPages.size())
+      return checkpointPages.size() - checkpointNext;
+
+    //every page dirty at the start has been written since
+    if (log)
+      log->logCheckpointEnd(checkpointLsn);
+    checkpointPages.clear();
+    checkpointNext = 0;
+    checkpointing = false;
+    return 0;
+  }
+
+  void BufMgr::checkpoint()
+  {
+    beginCheckpoint();
+    while (checkpointStep(bufDescTable.size()) > 0)
+      ;
+  }
+
+  void BufMgr::clearFrame(FrameId frameNo)
+  {
+    BufDesc &desc = bufDescTable[frameNo];
+    if (desc.valid)
+      gaugeValid.fetch_sub(1, std::memory_order_relaxed);
+    if (desc.dirty)
+      gaugeDirty.fetch_sub(1, std::memory_order_relaxed);
+    if (desc.pinCnt > 0)
+    {
+      gaugePinned.fetch_sub(1, std::memory_order_relaxed);
+      if (pinTracker)
+        pinTracker->forget(frameNo);
+    }
+    desc.clear();
   }
-}
 
+  MetricsSample BufMgr::sampleMetrics() const
+  {
+    MetricsSample sample = MetricsSample();
+    sample.frames = gaugeFrames.load(std::memory_order_relaxed);
+    sample.validFrames = gaugeValid.load(std::memory_order_relaxed);
+    sample.dirtyFrames = gaugeDirty.load(std::memory_order_relaxed);
+    sample.pinnedFrames = gaugePinned.load(std::memory_order_relaxed);
+    sample.hits = bufStats.sum(BufStats::HITS);
+    sample.misses = bufStats.sum(BufStats::MISSES);
+    sample.diskreads = bufStats.sum(BufStats::DISK_READS);
+    sample.diskwrites = bufStats.sum(BufStats::DISK_WRITES);
+    sample.clockSteps = bufStats.sum(BufStats::CLOCK_STEPS);
+    return sample;
+  }
+
+  void BufMgr::setAccessTracking(bool enabled, std::uint32_t sampleEvery,
+                                 std::uint32_t pagesPerBucket, std::uint32_t topK)
+  {
+    heatmap.reset(enabled ? new AccessHeatmap(sampleEvery, pagesPerBucket, topK) : nullptr);
+  }
+
+  void BufMgr::setPinTracking(bool enabled)
+  {
+    pinTracker.reset(enabled ? new PinTracker() : nullptr);
+  }
+
+  void BufMgr::setMissRatioCurve(bool enabled, std::uint32_t maxFrames,
+                                 std::uint32_t points, std::uint32_t maxSamples)
+  {
+    if (maxFrames == 0)
+      maxFrames = 4 * numBufs;
+    missRatioCurve.reset(enabled ? new MissRatioCurve(maxFrames, points, maxSamples) : nullptr);
+  }
+
+  void BufMgr::startAccessTrace(const std::string &path, std::uint32_t capacity)
+  {
+    trace.reset();
+    trace.reset(new AccessTraceWriter(path, capacity));
+  }
+
+  void BufMgr::startMetricsSampler(const MetricsSamplerOptions &options)
+  {
+    sampler.reset();
+    sampler.reset(new MetricsSampler(options, [this]() { return sampleMetrics(); }));
+  }
 
   void BufMgr::printSelf(void)
   {
     int validFrames = 0;
 
-    for (FrameId i = 0; i < numBufs; i++)
+    for (FrameId i = 0; i < bufDescTable.size(); i++)
     {
       std::cout << "FrameNo:" << i << " ";
       bufDescTable[i].Print();
@@ -8,11 +8,31 @@
 
 #pragma once
 
+#include <atomic>
+#include <deque>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <string>
 #include <vector>
 
+#include "access_heatmap.h"
+#include "access_trace.h"
 #include "bufHashTbl.h"
+#include "buf_warmup.h"
+#include "doublewrite_buffer.h"
 #include "file.h"
+#include "flash_cache.h"
+#include "frequency_sketch.h"
+#include "frame_pool.h"
+#include "log_manager.h"
+#include "metrics_sampler.h"
+#include "miss_ratio_curve.h"
+#include "pin_tracker.h"
+#include "query_stats.h"
+#include "stat_counters.h"
+#include "swip.h"
+#include "victim_cache.h"
 
 namespace badgerdb {
 
@@ -21,18 +41,51 @@ namespace badgerdb {
  */
 class BufMgr;
 
+/**
+ * @brief Frame limits of a group of files sharing the buffer pool, and the
+ * number of frames its pages currently occupy.
+ */
+struct FrameGroup {
+  /**
+   * Frames the group keeps even when other groups need frames
+   */
+  std::uint32_t reserved;
+
+  /**
+   * Most frames the group may take, or 0 for no limit
+   */
+  std::uint32_t quota;
+
+  /**
+   * Frames currently holding pages of the group
+   */
+  std::uint32_t frames;
+};
+
 /**
  * @brief Class for maintaining information about buffer pool frames
  */
 class BufDesc {
  public:
   /**
-   * Constructor of BufDesc class
+   * Constructor of BufDesc class.  Initializes the members directly rather
+   * than through clear(), since assigning an empty File is comparatively
+   * expensive and a large pool constructs millions of descriptors.
    */
-  BufDesc() { clear(); }
+  BufDesc()
+      : pageNo(Page::INVALID_NUMBER),
+        frameNo(0),
+        pinCnt(0),
+        dirty(false),
+        valid(false),
+        refbit(false),
+        hits(0),
+        recLsn(0),
+        group(nullptr) {}
 
  private:
   friend class BufMgr;
+  friend class Swip;
   /**
    * Pointer to file to which corresponding frame is assigned
    */
@@ -69,15 +122,44 @@ class BufDesc {
   bool refbit;
 
   /**
-   * Initialize buffer frame for a new user
+   * Number of times the page has been requested since it was read in
+   */
+  std::uint32_t hits;
+
+  /**
+   * LSN of the first change since the page was last written back, or 0 if
+   * the page is clean.  Without a log, a sequence number taken when the page
+   * became dirty instead.
+   */
+  Lsn recLsn;
+
+  /**
+   * Group with frame limits the page counts against, or null
+   */
+  FrameGroup* group;
+
+  /**
+   * Swips which have been swizzled to point directly at this frame
+   */
+  std::vector<Swip*> swips;
+
+  /**
+   * Initialize buffer frame for a new user.  Any swips pointing at the frame
+   * are turned back into page numbers.
    */
   void clear() {
+    for (Swip* swip : swips) swip->unswizzle(pageNo);
+    swips.clear();
     pinCnt = 0;
     file = File();
     pageNo = Page::INVALID_NUMBER;
     dirty = false;
     refbit = false;
     valid = false;
+    hits = 0;
+    recLsn = 0;
+    if (group) group->frames--;
+    group = nullptr;
   }
 
   /**
@@ -87,14 +169,20 @@ class BufDesc {
    *
    * @param filePtr	File object
    * @param pageNum	Page number in the file
+   * @param groupPtr	Group with frame limits the page counts against, or null
    */
-  void Set(File& file, PageId pageNum) {
+  void Set(File& file, PageId pageNum, FrameGroup* groupPtr = nullptr) {
     this->file = file;
     pageNo = pageNum;
     pinCnt = 1;
     dirty = false;
     valid = true;
     refbit = true;
+    hits = 1;
+    recLsn = 0;
+    if (group) group->frames--;
+    group = groupPtr;
+    if (group) group->frames++;
   }
 
   void Print() {
@@ -111,34 +199,195 @@ class BufDesc {
   }
 };
 
+inline PageId Swip::pageId() const {
+  return isSwizzled() ? desc()->pageNo : static_cast<PageId>(value_ >> 1);
+}
+
 /**
- * @brief Class to maintain statistics of buffer usage
+ * @brief Class to maintain statistics of buffer usage.  BufMgr counts events
+ * in sharded 64-bit counters; a BufStats is a snapshot of them, and the
+ * difference of two snapshots gives the activity in between.
  */
 struct BufStats {
+  /**
+   * Indices of the counters BufMgr keeps, one per field below
+   */
+  enum Counter {
+    ACCESSES,
+    HITS,
+    MISSES,
+    DISK_READS,
+    TIER_READS,
+    DISK_WRITES,
+    WRITE_BATCHES,
+    CLEAN_EVICTIONS,
+    DIRTY_EVICTIONS,
+    ALLOCATIONS,
+    CLOCK_STEPS,
+    LONGEST_SWEEP,
+    PIN_WAITS,
+    ALLOC_FAILURES,
+    CHECKSUM_FAILURES,
+    BYPASSED,
+    NUM_COUNTERS
+  };
+
   /**
    * Total number of accesses to buffer pool
    */
-  int accesses;
+  std::uint64_t accesses;
+
+  /**
+   * Number of requests for a page which was already in the buffer pool, and
+   * number which were not
+   */
+  std::uint64_t hits;
+  std::uint64_t misses;
 
   /**
    * Number of pages read from disk (including allocs)
    */
-  int diskreads;
+  std::uint64_t diskreads;
+
+  /**
+   * Number of missed pages served by the warm-up, victim tier or flash cache
+   * instead of a disk read
+   */
+  std::uint64_t tierReads;
 
   /**
    * Number of pages written back to disk
    */
-  int diskwrites;
+  std::uint64_t diskwrites;
+
+  /**
+   * Number of write-backs, each writing one page or one double-write batch
+   */
+  std::uint64_t writeBatches;
+
+  /**
+   * Number of pages evicted which were clean, and which had to be written
+   * back first
+   */
+  std::uint64_t cleanEvictions;
+  std::uint64_t dirtyEvictions;
+
+  /**
+   * Number of frames allocated by the clock, frames it looked at to find
+   * them and the most it looked at for one frame
+   */
+  std::uint64_t allocations;
+  std::uint64_t clockSteps;
+  std::uint64_t longestSweep;
+
+  /**
+   * Number of times the clock had to pass over a pinned frame
+   */
+  std::uint64_t pinWaits;
+
+  /**
+   * Number of allocations which failed because every frame was pinned
+   */
+  std::uint64_t allocFailures;
+
+  /**
+   * Number of pages read from disk whose checksum did not match
+   */
+  std::uint64_t checksumFailures;
+
+  /**
+   * Number of missed pages the admission filter turned away to a bypass frame
+   */
+  std::uint64_t bypassed;
 
   /**
    * Clear all values
    */
-  void clear() { accesses = diskreads = diskwrites = 0; }
+  void clear() {
+    for (std::uint64_t BufStats::*field : FIELDS) this->*field = 0;
+  }
 
   /**
    * Constructor of BufStats class
    */
   BufStats() { clear(); }
+
+  /**
+   * Returns the fraction of accesses which were hits, or 0 without accesses.
+   */
+  double hitRatio() const {
+    return hits + misses == 0 ? 0.0
+                              : static_cast<double>(hits) / (hits + misses);
+  }
+
+  /**
+   * Returns the activity between an earlier snapshot and this one.  The
+   * longest sweep is the longest seen up to this snapshot.
+   *
+   * @param earlier Snapshot taken before this one
+   */
+  BufStats operator-(const BufStats& earlier) const {
+    BufStats diff;
+    for (std::uint64_t BufStats::*field : FIELDS)
+      diff.*field = this->*field - earlier.*field;
+    diff.longestSweep = longestSweep;
+    return diff;
+  }
+
+  /**
+   * Fields in the order of the Counter indices
+   */
+  static std::uint64_t BufStats::*const FIELDS[NUM_COUNTERS];
+};
+
+/**
+ * @brief Entry of the dirty page table: a dirty frame and the earliest change
+ * to its page that has not been written back.
+ */
+struct DirtyPage {
+  /**
+   * Frame holding the page
+   */
+  FrameId frameNo;
+
+  /**
+   * Name of the file the page belongs to
+   */
+  std::string filename;
+
+  /**
+   * Page number in the file
+   */
+  PageId pageNo;
+
+  /**
+   * LSN (or, without a log, sequence number) of the first change since the
+   * page was last written back
+   */
+  Lsn recLsn;
+};
+
+/**
+ * @brief Frames held by one group of files, as reported by
+ * BufMgr::getGroupOccupancy().
+ */
+struct GroupOccupancy {
+  /**
+   * Frames holding pages of the group
+   */
+  std::uint32_t frames;
+
+  /**
+   * Of those, frames which are pinned and frames which are dirty
+   */
+  std::uint32_t pinned;
+  std::uint32_t dirty;
+
+  /**
+   * Limits set by BufMgr::setFrameQuota(), 0 if none
+   */
+  std::uint32_t reserved;
+  std::uint32_t quota;
 };
 
 /**
@@ -153,10 +402,37 @@ class BufMgr {
   FrameId clockHand;
 
   /**
-   * Number of frames in the buffer pool
+   * Number of frames in the buffer pool the clock hands out.  After the pool
+   * has been shrunk, frames at or beyond this index which are still pinned
+   * remain in bufPool until they are unpinned.
    */
   std::uint32_t numBufs;
 
+  /**
+   * Pool size requested through requestResize() but not yet applied, or 0
+   */
+  std::atomic<std::uint32_t> pendingBufs;
+
+  /**
+   * Write-ahead log changes are recorded in, or null
+   */
+  LogManager* log;
+
+  /**
+   * Double-write buffer pages are written through, or null
+   */
+  DoublewriteBuffer* doublewrite;
+
+  /**
+   * Compressed tier evicted pages are kept in, or null
+   */
+  VictimCache* victimCache;
+
+  /**
+   * Cache on local flash evicted pages are written to, or null
+   */
+  FlashCache* flashCache;
+
   /**
    * Hash table mapping (File, page) to frame
    */
@@ -164,40 +440,323 @@ class BufMgr {
 
   /**
    * Array of BufDesc objects to hold information corresponding to every frame
-   * allocation from 'bufPool' (the buffer pool)
+   * allocation from 'bufPool' (the buffer pool).  A deque, so that growing or
+   * shrinking the pool never moves the descriptors of other frames.
+   */
+  std::deque<BufDesc> bufDescTable;
+
+  /**
+   * Maintains Buffer pool usage statistics, one counter per BufStats field
+   */
+  ShardedCounters<BufStats::NUM_COUNTERS> bufStats;
+
+  /**
+   * Background load started by loadResidentPages(), or null
    */
-  std::vector<BufDesc> bufDescTable;
+  std::unique_ptr<BufWarmup> warmup;
 
   /**
-   * Maintains Buffer pool usage statistics
+   * Next frame to look at for a free frame to install warmed-up pages in
    */
-  BufStats bufStats;
+  FrameId warmupCursor;
+
+  /**
+   * Sequence number handed out as recLsn to pages made dirty while no log is
+   * attached
+   */
+  Lsn dirtySeq;
+
+  /**
+   * Dirty page table of the running checkpoint in (file, page) order, the
+   * next entry to write and the LSN the checkpoint began at
+   */
+  std::vector<DirtyPage> checkpointPages;
+  std::size_t checkpointNext;
+  Lsn checkpointLsn;
+  bool checkpointing;
+
+  /**
+   * Access frequencies the admission filter compares, or null without one
+   */
+  std::unique_ptr<FrequencySketch> admission;
+
+  /**
+   * Number of frames at the start of the pool the clock skips, which hold
+   * pages the admission filter turned away, and the last one handed out
+   */
+  std::uint32_t bypassFrames;
+  FrameId bypassHand;
+
+  /**
+   * Number of frames from the clock hand searched for a clean victim before
+   * a dirty one is evicted, or 0
+   */
+  std::uint32_t cleanFirstWindow;
+
+  /**
+   * Groups with frame limits by name, and the group of every file assigned
+   * to one by name; any other file is its own group, named after the file
+   */
+  std::map<std::string, FrameGroup> frameGroups;
+  std::map<std::string, std::string> fileGroups;
+
+  /**
+   * Occupancy gauges: frames handed out by the clock, and valid, dirty and
+   * pinned frames.  Kept up to date as frames change state so the metrics
+   * sampler can read them from its own thread without scanning the pool.
+   */
+  std::atomic<std::uint32_t> gaugeFrames;
+  std::atomic<std::uint32_t> gaugeValid;
+  std::atomic<std::uint32_t> gaugeDirty;
+  std::atomic<std::uint32_t> gaugePinned;
+
+  /**
+   * Background sampler started by startMetricsSampler(), or null
+   */
+  std::unique_ptr<MetricsSampler> sampler;
+
+  /**
+   * Sampled record of where requests go, or null without access tracking
+   */
+  std::unique_ptr<AccessHeatmap> heatmap;
+
+  /**
+   * Trace of requests started by startAccessTrace(), or null
+   */
+  std::unique_ptr<AccessTraceWriter> trace;
+
+  /**
+   * Miss ratio curve estimated from requests, or null unless enabled
+   */
+  std::unique_ptr<MissRatioCurve> missRatioCurve;
+
+  /**
+   * Profile of how long pages stay pinned, or null unless enabled
+   */
+  std::unique_ptr<PinTracker> pinTracker;
 
   /**
    * Advance clock to next frame in the buffer pool
    */
   void advanceClock();
   /**
-   * Allocate a free frame.
+   * Allocate a free frame.  With the admission filter enabled and the page
+   * the frame is for given, a page which is not accessed more often than the
+   * clock's victim is given a bypass frame instead, and the victim stays.
+   * Frame limits are those of the file's group: a group at its quota only
+   * replaces its own pages, no group is evicted below its reservation by
+   * another, and pages of a group over its quota get no second chance.
    *
    * @param frame   	Frame reference, frame ID of allocated frame returned
    * via this variable
+   * @param file   	File of the page the frame is for, or null
+   * @param pageNo  Page the frame is for, or Page::INVALID_NUMBER for a page
+   * yet to be allocated, which the admission filter always admits
    * @throws BufferExceededException If no such buffer is found which can be
    * allocated
    */
-  void allocBuf(FrameId& frame);
-  
+  void allocBuf(FrameId& frame, const File* file = nullptr,
+                PageId pageNo = Page::INVALID_NUMBER);
+
+  /**
+   * Reads a page into the buffer pool if it is not there yet and pins it, as
+   * readPage() does.
+   *
+   * @param file   	File object
+   * @param pageNo  Page number in the file to be read
+   * @param pinTag Caller tag the pin is profiled under
+   * @return  Frame holding the page.
+   */
+  FrameId fetchPage(File& file, const PageId pageNo, const char* pinTag);
+
+  /**
+   * Returns the frame to evict in place of the clock's victim: the first
+   * clean, unpinned and unreferenced frame within the clean-first window if
+   * the victim is dirty, or else the victim itself.
+   *
+   * @param victim  Frame the clock has chosen
+   * @param first   First frame the clock hands out
+   */
+  FrameId cleanFirstVictim(FrameId victim, std::uint32_t first,
+                           const FrameGroup* group) const;
+
+  /**
+   * Returns true if a valid, unpinned frame may be replaced by a page of the
+   * given group under the groups' frame limits.
+   *
+   * @param desc  Frame to replace
+   * @param group Group of the page the frame is for, or null
+   */
+  bool mayReplace(const BufDesc& desc, const FrameGroup* group) const;
+
+  /**
+   * Returns the name of the group a file belongs to.
+   */
+  const std::string& groupName(const File& file) const;
+
+  /**
+   * Returns the group with frame limits a file belongs to, or null.
+   */
+  FrameGroup* groupOf(const File& file);
+
+  /**
+   * Recomputes the group of every valid frame after the groups changed.
+   */
+  void regroup();
+
+  /**
+   * Counts a frame allocated by the clock after looking at the given number
+   * of frames.
+   */
+  void countSweep(std::uint32_t steps);
+
+  /**
+   * Frees the next unpinned bypass frame, if any.
+   *
+   * @param frame   	Frame reference, frame ID of the bypass frame returned
+   * via this variable
+   * @return  False if every bypass frame is pinned
+   */
+  bool allocBypassFrame(FrameId& frame);
+
+  /**
+   * Counts an access to a page in the admission filter and the miss ratio
+   * curve, if enabled.
+   */
+  void recordAccess(const File& file, PageId pageNo) {
+    if (!admission && !missRatioCurve) return;
+    const std::uint64_t key = pageKey(file, pageNo);
+    if (admission) admission->increment(key);
+    if (missRatioCurve) missRatioCurve->record(key);
+  }
+
+  /**
+   * Counts work done by the calling thread in its query scope, if any.
+   */
+  static void countQuery(std::uint64_t QueryStats::*counter,
+                         std::uint64_t n = 1) {
+    if (QueryStats* query = QueryScope::current())
+      query->*counter += n;
+  }
+
+  /**
+   * Records a pin taken on a frame in the pin profile, if enabled.
+   */
+  void trackPin(FrameId frameNo, const char* tag) {
+    if (pinTracker)
+      pinTracker->pinned(frameNo, tag, bufDescTable[frameNo].file.filename(),
+                         bufDescTable[frameNo].pageNo);
+  }
+
+  /**
+   * Records a request in the access heatmap, if tracking and sampled.
+   */
+  void trackAccess(const File& file, PageId pageNo, bool hit) {
+    if (heatmap && heatmap->sample())
+      heatmap->record(file.filename(), pageNo, hit);
+  }
+
+  /**
+   * Records a request in the access trace, if one is running.
+   */
+  void traceRequest(TraceRecord::Op op, const File& file, PageId pageNo,
+                    std::uint8_t flags = 0) {
+    if (trace)
+      trace->record(op, file.filename(), pageNo, flags);
+  }
+
+  /**
+   * Returns the key a page is counted under by the admission filter.
+   */
+  static std::uint64_t pageKey(const File& file, PageId pageNo);
+
+  /**
+   * Writes the page held in a dirty frame back to its file and marks the
+   * frame clean.  With a log attached, the log is first made durable up to
+   * the page's LSN.
+   *
+   * @param frameNo Frame to write back
+   */
+  void writeBack(FrameId frameNo);
+
+  /**
+   * Writes back the pages held in several dirty frames as one batch, through
+   * the double-write buffer if one is attached, and marks the frames clean.
+   *
+   * @param frames  Frames to write back
+   */
+  void writeBack(const std::vector<FrameId>& frames);
+
+  /**
+   * Marks the page in a frame dirty after a change, logging the change if a
+   * log is attached and noting the frame's recLsn if it was clean.
+   *
+   * @param frameNo Frame holding the changed page
+   */
+  void markDirty(FrameId frameNo);
+
+  /**
+   * Writes back the page held in a valid, unpinned frame if it is dirty and
+   * removes it from the buffer pool.  With a double-write buffer attached,
+   * other dirty unpinned frames ahead of the clock are written in the same
+   * batch and stay in the pool clean.
+   *
+   * @param frameNo Frame to evict
+   */
+  void evict(FrameId frameNo);
+
+  /**
+   * Removes the page in a frame from the occupancy gauges and clears the
+   * frame's descriptor.
+   *
+   * @param frameNo Frame to clear
+   */
+  void clearFrame(FrameId frameNo);
+
+  /**
+   * Adds a pin to a frame, counting it in the gauges if it was unpinned.
+   */
+  void pin(BufDesc& desc) {
+    if (desc.pinCnt++ == 0) gaugePinned.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Removes a pin from a pinned frame, counting it in the gauges once it is
+   * unpinned.
+   */
+  void unpin(BufDesc& desc) {
+    if (--desc.pinCnt == 0) gaugePinned.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Applies a resize requested through requestResize(), if any.
+   */
+  void applyPendingResize();
+
+  /**
+   * Evicts unpinned frames beyond numBufs and releases the frames at the end
+   * of the pool which are no longer used.
+   */
+  void trimPool();
+
  public:
   /**
-   * Actual buffer pool from which frames are allocated
+   * Actual buffer pool from which frames are allocated.  Frames are only
+   * materialized when first used, and pages stay at the same address while
+   * the pool is resized.
    */
-  std::vector<Page> bufPool;
+  FramePool bufPool;
 
   /**
    * Constructor of BufMgr class
    */
   BufMgr(std::uint32_t bufs);
 
+  /**
+   * Stops the metrics sampler, if running.
+   */
+  ~BufMgr();
+
   /**
    * Reads the given page from the file into a frame and returns the pointer to
    * page. If the requested page is already present in the buffer pool pointer
@@ -208,8 +767,30 @@ class BufMgr {
    * @param PageNo  Page number in the file to be read
    * @param page  	Reference to page pointer. Used to fetch the Page object
    * in which requested page from file is read in.
+   * @param pinTag Caller tag the pin is profiled under, such as
+   * BADGERDB_HERE; must outlive the pin
+   * @throws ChecksumMismatchException If the page read from disk is corrupt;
+   * the failure is counted in the buffer statistics
+   */
+  void readPage(File& file, const PageId pageNo, Page*& page,
+                const char* pinTag = nullptr);
+
+  /**
+   * Reads the page referenced by a swip.  If the swip is swizzled the frame it
+   * points at is pinned directly, without a hash table lookup.  Otherwise the
+   * page is read as by readPage(file, pageNo, page) and the swip is swizzled
+   * to point at its frame until the frame is evicted.
+   *
+   * @param file   	File object the referenced page belongs to
+   * @param swip  	Reference to the page
+   * @param page  	Reference to page pointer. Used to fetch the Page object
+   * in which requested page from file is read in.
+   * @param pinTag Caller tag the pin is profiled under
+   * @throws InvalidPageException If the swip is swizzled to a page of another
+   * file
    */
-  void readPage(File& file, const PageId pageNo, Page*& page);
+  void readPage(File& file, Swip& swip, Page*& page,
+                const char* pinTag = nullptr);
 
   /**
    * Unpin a page from memory since it is no longer required for it to remain in
@@ -223,6 +804,27 @@ class BufMgr {
    */
   void unPinPage(File& file, const PageId pageNo, const bool dirty);
 
+  /**
+   * Unpin the page referenced by a swip.  A swizzled swip releases its frame
+   * without a hash table lookup.
+   *
+   * @param file   	File object the referenced page belongs to
+   * @param swip  	Reference to the page
+   * @param dirty		True if the page to be unpinned needs to be
+   * marked dirty
+   * @throws  PageNotPinnedException If the page is not already pinned
+   */
+  void unPinPage(File& file, const Swip& swip, const bool dirty);
+
+  /**
+   * Turns a swizzled swip back into a page number and stops tracking it.
+   * Must be called before a swizzled swip is destroyed.  Does nothing if the
+   * swip is not swizzled.
+   *
+   * @param swip  	Swip to unswizzle
+   */
+  void unswizzle(Swip& swip);
+
   /**
    * Allocates a new, empty page in the file and returns the Page object.
    * The newly allocated page is also assigned a frame in the buffer pool.
@@ -232,8 +834,10 @@ class BufMgr {
    * returned via this reference.
    * @param page  	Reference to page pointer. The newly allocated in-memory
    * Page object is returned via this reference.
+   * @param pinTag Caller tag the pin is profiled under
    */
-  void allocPage(File& file, PageId& pageNo, Page*& page);
+  void allocPage(File& file, PageId& pageNo, Page*& page,
+                 const char* pinTag = nullptr);
 
   /**
    * Writes out all dirty pages of the file to disk.
@@ -259,19 +863,398 @@ class BufMgr {
   void disposePage(File& file, const PageId PageNo);
 
   /**
-   * Print member variable values.
+   * Attaches a write-ahead log.  From then on every unpin that marks a page
+   * dirty appends an image of the page to the log, and no dirty page is
+   * written back before the log is durable up to the page's LSN.  A commit
+   * then only needs LogManager::commit(); the pages themselves are written
+   * lazily on eviction.
+   *
+   * @param logManager  Log to use, or null to stop logging
+   */
+  void setLogManager(LogManager* logManager) { log = logManager; }
+
+  /**
+   * Largest number of dirty frames written together when a dirty page is
+   * evicted with a double-write buffer attached.
+   */
+  static const std::uint32_t DOUBLEWRITE_BATCH_PAGES = 16;
+
+  /**
+   * Attaches a double-write buffer.  From then on every page written back,
+   * whether on eviction, by flushFile() or by a checkpoint, goes through it
+   * in batches, so that a crash can never leave a torn page behind.
+   *
+   * @param buffer  Double-write buffer to use, or null to write in place
+   */
+  void setDoublewriteBuffer(DoublewriteBuffer* buffer) { doublewrite = buffer; }
+
+  /**
+   * Attaches a compressed tier for evicted pages.  From then on every page
+   * evicted from the pool is compressed into it once it is clean, and a miss
+   * checks it before reading the page from its file.
+   *
+   * @param cache   Victim cache to use, or null to discard evicted pages
+   */
+  void setVictimCache(VictimCache* cache) { victimCache = cache; }
+
+  /**
+   * Attaches a second-level cache on local flash.  From then on pages
+   * evicted from the pool are offered to it once clean, a miss checks it
+   * (after the victim tier, if any) before reading the page from its file,
+   * and its copy of a page is dropped whenever the page is written back.
+   *
+   * @param cache   Flash cache to use, or null to stop using one
+   */
+  void setFlashCache(FlashCache* cache) { flashCache = cache; }
+
+  /**
+   * Makes eviction prefer clean pages (CFLRU).  When the clock's victim is
+   * dirty, the given number of frames from the clock hand on are searched for
+   * a clean, unpinned and unreferenced frame, which is evicted instead; the
+   * dirty victim is only written back and evicted if there is none.  A miss
+   * then rarely waits for a write, at the cost of keeping dirty pages a little
+   * longer than recency alone would.
+   *
+   * @param frames  Size of the clean-first window, or 0 to treat dirty and
+   * clean frames alike
+   */
+  void setCleanFirstWindow(std::uint32_t frames) { cleanFirstWindow = frames; }
+
+  /**
+   * Returns the size of the clean-first window, 0 if disabled.
+   */
+  std::uint32_t getCleanFirstWindow() const { return cleanFirstWindow; }
+
+  /**
+   * Sets the frame limits of a group of files; a file not assigned to a group
+   * by setFileGroup() is a group of its own, named after the file.  Another
+   * group never evicts a page of the group while it holds no more than the
+   * reserved number of frames.  Once the group holds its quota of frames, a
+   * missed page of the group replaces another of its pages, and the request
+   * fails with BufferExceededException if all of them are pinned.  A group
+   * already over a lowered quota loses its pages first.  Reservations should
+   * add up to less than the pool, or other groups may find no frame at all.
+   *
+   * @param group     Name of the group
+   * @param reserved  Frames reserved for the group
+   * @param quota     Most frames the group may hold, or 0 for no limit
+   */
+  void setFrameQuota(const std::string& group, std::uint32_t reserved,
+                     std::uint32_t quota);
+
+  /**
+   * Removes the frame limits of a group.
+   *
+   * @param group     Name of the group
+   */
+  void clearFrameQuota(const std::string& group);
+
+  /**
+   * Assigns a file to a group, so that its pages count against the group's
+   * frame limits.
+   *
+   * @param filename  Name of the file
+   * @param group     Name of the group, or the empty string to make the file
+   * its own group again
+   */
+  void setFileGroup(const std::string& filename, const std::string& group);
+
+  /**
+   * Returns the frames held by each group with pages in the pool or frame
+   * limits set, by group name.
+   */
+  std::map<std::string, GroupOccupancy> getGroupOccupancy() const;
+
+  /**
+   * Default number of bypass frames reserved by setAdmissionFilter().
+   */
+  static const std::uint32_t ADMISSION_BYPASS_FRAMES = 1;
+
+  /**
+   * Enables or disables the TinyLFU admission filter.  While enabled, every
+   * request for a page is counted in a frequency sketch with periodic aging,
+   * and a missed page only replaces the clock's victim if it has been
+   * requested more often recently.  Otherwise it is read into one of a few
+   * bypass frames the clock does not hand out, where it is replaced by the
+   * next page turned away, so that a scan cannot flush the pool.  Enabling
+   * the filter again resets the sketch.
+   *
+   * @param enabled True to enable the filter
+   * @param bypass  Number of bypass frames; the filter has no effect unless
+   * the pool has more frames than that
+   */
+  void setAdmissionFilter(bool enabled,
+                          std::uint32_t bypass = ADMISSION_BYPASS_FRAMES);
+
+  /**
+   * Returns true while the admission filter is enabled.
+   */
+  bool hasAdmissionFilter() const { return admission != nullptr; }
+
+  /**
+   * Grows or shrinks the buffer pool to the given number of frames.  Growing
+   * adds empty frames.  Shrinking writes back and evicts the unpinned pages
+   * in the frames being removed; frames which are still pinned keep their
+   * page and are released once they are unpinned.  Pages stay at the same
+   * address throughout.
+   *
+   * @param bufs  New number of frames, at least 1
+   */
+  void resize(std::uint32_t bufs);
+
+  /**
+   * Asks for the pool to be resized from another thread.  The resize is
+   * applied by the thread using the buffer manager on its next allocation or
+   * unpin.
+   *
+   * @param bufs  New number of frames, at least 1
+   */
+  void requestResize(std::uint32_t bufs) { pendingBufs.store(bufs); }
+
+  /**
+   * Returns the number of frames the clock currently hands out.
+   */
+  std::uint32_t getNumBufs() const { return numBufs; }
+
+  /**
+   * Returns the number of frames currently held in memory, including frames
+   * still waiting to be released after a shrink.
+   */
+  std::uint32_t getPoolSize() const { return bufPool.size(); }
+
+  /**
+   * Returns true if the given frame currently holds a page in memory.  Frames
+   * get their page when one is first read or allocated into them.
+   *
+   * @param frameNo Frame number; frames past the pool hold no page.
+   */
+  bool isFrameMaterialized(FrameId frameNo) const {
+    return frameNo < bufPool.size() && bufPool.isMaterialized(frameNo);
+  }
+
+  /**
+   * Writes the file and page number of every valid frame to the given path,
+   * hottest pages first, so that loadResidentPages() can bring them back
+   * after a restart.  Pages referenced recently come first, ordered by the
+   * number of requests since they were read in.
+   *
+   * @param path  File to write the list to
+   */
+  void dumpResidentPages(const std::string& path);
+
+  /**
+   * Starts bringing back the pages listed by dumpResidentPages().  Pages are
+   * read by background threads at idle priority, in page order with
+   * consecutive pages coalesced into one read.  They are installed into free
+   * frames only, a few at a time whenever a page is missed or
+   * pollResidentPageLoad() is called, so foreground requests never wait for
+   * the load.  At most as many pages as there are frames are loaded.
+   *
+   * @param path    File written by dumpResidentPages()
+   * @param threads Number of background reader threads
+   */
+  void loadResidentPages(const std::string& path, unsigned threads = 2);
+
+  /**
+   * Installs up to the given number of pages read by a background load into
+   * free frames.  Ends the load once it is complete or the pool is full.
+   *
+   * @param maxPages  Maximum number of pages to install
+   * @return  Number of pages installed
+   */
+  std::uint32_t pollResidentPageLoad(std::uint32_t maxPages = 64);
+
+  /**
+   * Returns true while a load started by loadResidentPages() is running.
+   */
+  bool isLoadingResidentPages() const { return warmup != nullptr; }
+
+  /**
+   * Number of pages a running checkpoint writes each time a page is missed.
+   */
+  static const std::uint32_t CHECKPOINT_TRICKLE_PAGES = 4;
+
+  /**
+   * Returns the dirty page table: every dirty frame, its page and the first
+   * change to it which has not been written back.
+   */
+  std::vector<DirtyPage> getDirtyPageTable() const;
+
+  /**
+   * Starts a fuzzy checkpoint.  The dirty page table is recorded (and logged,
+   * if a log is attached) and its pages are then written back in file and
+   * page order, a few at a time whenever a page is missed or
+   * checkpointStep() is called.  Readers are never blocked and pages need
+   * not be unpinned: a pinned page is logged afresh and written as it is.
+   * Pages dirtied after the checkpoint began are left to the next one.
+   *
+   * Once every page in the table has been written, the log records that
+   * recovery may start at the LSN the checkpoint began at, which bounds the
+   * work done by LogManager::recover() without ever flushing the whole pool
+   * at once.  A checkpoint already running is restarted.
+   *
+   * @return  Number of pages the checkpoint will write
+   */
+  std::size_t beginCheckpoint();
+
+  /**
+   * Writes up to the given number of pages of the running checkpoint, and
+   * completes it once all have been written.
+   *
+   * @param maxPages  Maximum number of pages to write
+   * @return  Number of pages still to be written
+   */
+  std::size_t checkpointStep(std::uint32_t maxPages = CHECKPOINT_TRICKLE_PAGES);
+
+  /**
+   * Runs a whole checkpoint: begins one and writes all of its pages.
+   */
+  void checkpoint();
+
+  /**
+   * Returns true while a checkpoint begun by beginCheckpoint() is running.
+   */
+  bool isCheckpointing() const { return checkpointing; }
+
+  /**
+   * Enables or disables access tracking: per-file hits and misses, requests
+   * by range of page numbers and the hottest pages, from one request in
+   * every sampleEvery so that the hit path stays cheap.  Enabling tracking
+   * again starts it afresh.
+   *
+   * @param enabled         True to enable tracking
+   * @param sampleEvery     One request in this many is recorded
+   * @param pagesPerBucket  Pages per range of the per-file histograms
+   * @param topK            Number of hottest pages to report
+   */
+  void setAccessTracking(bool enabled, std::uint32_t sampleEvery = 16,
+                         std::uint32_t pagesPerBucket = 64,
+                         std::uint32_t topK = 32);
+
+  /**
+   * Enables or disables profiling how long pages stay pinned, by the tag
+   * passed to readPage() and allocPage().  Enabling it again starts afresh.
+   *
+   * @param enabled True to enable the profile
+   */
+  void setPinTracking(bool enabled);
+
+  /**
+   * Returns the pin profile, or null if it is disabled.  Safe to query from
+   * any thread while the buffer manager is in use.
+   */
+  const PinTracker* getPinTracker() const { return pinTracker.get(); }
+
+  /**
+   * Default number of pool sizes and of sampled pages of the miss ratio
+   * curve.
+   */
+  static const std::uint32_t MRC_POINTS = 64;
+  static const std::uint32_t MRC_MAX_SAMPLES = 8192;
+
+  /**
+   * Enables or disables estimating the hit ratio this pool would have at
+   * other sizes, from the pages requested with readPage().  Uses SHARDS
+   * sampling, so its memory is bounded by maxSamples and a request for a
+   * page outside the sample costs a hash.  Enabling it again starts afresh.
+   *
+   * @param enabled    True to enable the estimate
+   * @param maxFrames  Largest pool size estimated; 0 for four times the
+   *                   current size
+   * @param points     Number of pool sizes estimated up to maxFrames
+   * @param maxSamples Most pages tracked at once
+   */
+  void setMissRatioCurve(bool enabled, std::uint32_t maxFrames = 0,
+                         std::uint32_t points = MRC_POINTS,
+                         std::uint32_t maxSamples = MRC_MAX_SAMPLES);
+
+  /**
+   * Returns the miss ratio curve estimate, or null if it is disabled.
+   * Safe to query from any thread while the buffer manager is in use.
+   */
+  const MissRatioCurve* getMissRatioCurve() const {
+    return missRatioCurve.get();
+  }
+
+  /**
+   * Returns what access tracking has recorded, or null if it is disabled.
+   * Safe to query from any thread while the buffer manager is in use.
+   */
+  const AccessHeatmap* getAccessHeatmap() const { return heatmap.get(); }
+
+  /**
+   * Returns the current occupancy and cumulative counters of the pool.  Safe
+   * to call from any thread while the buffer manager is in use, and does not
+   * scan the pool.
+   */
+  MetricsSample sampleMetrics() const;
+
+  /**
+   * Starts a background thread which samples the pool's metrics at a fixed
+   * interval and writes them to a rotating CSV or JSON-lines log and/or a
+   * Prometheus textfile.  A sampler already running is replaced.
+   *
+   * @param options Where and how often to write samples
+   */
+  void startMetricsSampler(const MetricsSamplerOptions& options);
+
+  /**
+   * Stops the metrics sampler after a last sample.  Does nothing if it is
+   * not running.
+   */
+  void stopMetricsSampler() { sampler.reset(); }
+
+  /**
+   * Returns true while the metrics sampler is running.
+   */
+  bool isSamplingMetrics() const { return sampler != nullptr; }
+
+  /**
+   * Default number of records the ring of an access trace holds.
+   */
+  static const std::uint32_t TRACE_RING_RECORDS = 1 << 16;
+
+  /**
+   * Starts recording every readPage(), allocPage(), unPinPage(),
+   * disposePage() and flushFile() to a binary trace file, which
+   * bufmgr_replay can replay against a pool of any size.  Requests are
+   * appended to a ring in memory which a background thread drains; if it
+   * falls behind, requests are dropped rather than waited for.  A trace
+   * already running is stopped first.
+   *
+   * @param path     File to write the trace to
+   * @param capacity Records the ring holds
+   */
+  void startAccessTrace(const std::string& path,
+                        std::uint32_t capacity = TRACE_RING_RECORDS);
+
+  /**
+   * Stops the access trace once every recorded request is written.  Does
+   * nothing if no trace is running.
+   */
+  void stopAccessTrace() { trace.reset(); }
+
+  /**
+   * Returns the running access trace, or null.
+   */
+  const AccessTraceWriter* getAccessTrace() const { return trace.get(); }
+
+  /**
+   * Print member variable values.  Prints every frame; use sampleMetrics()
+   * or the metrics sampler for anything but small pools.
    */
   void printSelf();
 
   /**
-   * Get buffer pool usage statistics
+   * Get a snapshot of the buffer pool usage statistics.  Safe to call from
+   * any thread while the buffer manager is in use.
    */
-  BufStats& getBufStats() { return bufStats; }
+  BufStats getBufStats() const;
 
   /**
    * Clear buffer pool usage statistics
    */
-  void clearBufStats() { bufStats.clear(); }
+  void clearBufStats() { bufStats.reset(); }
 };
 
 }  // namespace badgerdb
@@ -0,0 +1,220 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "crc32c.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define BADGERDB_CRC32C_SSE42 1
+#endif
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Reflected CRC32C polynomial.
+ */
+const std::uint32_t POLYNOMIAL = 0x82F63B78u;
+
+/**
+ * @brief Lookup tables for the software implementation.  Table k holds the
+ * checksum of a byte followed by k zero bytes.
+ */
+struct Crc32cTables {
+  std::uint32_t table[8][256];
+
+  Crc32cTables() {
+    for (std::uint32_t i = 0; i < 256; ++i) {
+      std::uint32_t crc = i;
+      for (int bit = 0; bit < 8; ++bit) {
+        crc = (crc >> 1) ^ (POLYNOMIAL & (0u - (crc & 1)));
+      }
+      table[0][i] = crc;
+    }
+    for (std::uint32_t i = 0; i < 256; ++i) {
+      for (int k = 1; k < 8; ++k) {
+        table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+      }
+    }
+  }
+};
+
+const Crc32cTables tables;
+
+std::uint32_t crc32cSoftware(const unsigned char *p, std::size_t length,
+                             std::uint32_t crc) {
+  // Slicing-by-8: fold eight bytes into the checksum per step.
+  while (length >= 8) {
+    std::uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    word ^= crc;
+    crc = tables.table[7][word & 0xFF] ^ tables.table[6][(word >> 8) & 0xFF] ^
+          tables.table[5][(word >> 16) & 0xFF] ^
+          tables.table[4][(word >> 24) & 0xFF] ^
+          tables.table[3][(word >> 32) & 0xFF] ^
+          tables.table[2][(word >> 40) & 0xFF] ^
+          tables.table[1][(word >> 48) & 0xFF] ^ tables.table[0][word >> 56];
+    p += 8;
+    length -= 8;
+  }
+  while (length-- > 0) {
+    crc = (crc >> 8) ^ tables.table[0][(crc ^ *p++) & 0xFF];
+  }
+  return crc;
+}
+
+#ifdef BADGERDB_CRC32C_SSE42
+/**
+ * Block sizes, in bytes, for which the hardware implementation checksums
+ * three blocks at once.  Both must be powers of two.
+ */
+const std::size_t LONG_BLOCK = 1024;
+const std::size_t SHORT_BLOCK = 128;
+
+/**
+ * @brief Tables which shift a checksum over a block of zero bytes, used to
+ * combine the checksums of blocks computed in parallel.
+ */
+struct Crc32cShiftTables {
+  std::uint32_t longShift[4][256];
+  std::uint32_t shortShift[4][256];
+
+  Crc32cShiftTables() {
+    build(longShift, LONG_BLOCK);
+    build(shortShift, SHORT_BLOCK);
+  }
+
+  static std::uint32_t multiply(const std::uint32_t *matrix,
+                                std::uint32_t vector) {
+    std::uint32_t sum = 0;
+    for (; vector != 0; vector >>= 1, ++matrix) {
+      if (vector & 1) sum ^= *matrix;
+    }
+    return sum;
+  }
+
+  static void square(std::uint32_t *result, const std::uint32_t *matrix) {
+    for (int n = 0; n < 32; ++n) {
+      result[n] = multiply(matrix, matrix[n]);
+    }
+  }
+
+  static void build(std::uint32_t shift[4][256], std::size_t length) {
+    // Operator for one zero bit, squared up to one for length zero bytes.
+    std::uint32_t even[32];
+    std::uint32_t odd[32];
+    odd[0] = POLYNOMIAL;
+    for (int n = 1; n < 32; ++n) {
+      odd[n] = 1u << (n - 1);
+    }
+    square(even, odd);
+    square(odd, even);
+    const std::uint32_t *op = odd;
+    while (true) {
+      square(even, odd);
+      op = even;
+      length >>= 1;
+      if (length == 0) break;
+      square(odd, even);
+      op = odd;
+      length >>= 1;
+      if (length == 0) break;
+    }
+    for (std::uint32_t n = 0; n < 256; ++n) {
+      for (int k = 0; k < 4; ++k) {
+        shift[k][n] = multiply(op, n << (8 * k));
+      }
+    }
+  }
+};
+
+const Crc32cShiftTables shiftTables;
+
+std::uint32_t shift(const std::uint32_t table[4][256], std::uint32_t crc) {
+  return table[0][crc & 0xFF] ^ table[1][(crc >> 8) & 0xFF] ^
+         table[2][(crc >> 16) & 0xFF] ^ table[3][crc >> 24];
+}
+
+/**
+ * Checksums three consecutive blocks of the given size at a time, so that
+ * the latency of the crc32 instruction is hidden, and combines them.
+ */
+__attribute__((target("sse4.2"))) std::uint64_t crc32cSse42Blocks(
+    const unsigned char *&p, std::size_t &length, std::uint64_t crc0,
+    const std::size_t block, const std::uint32_t table[4][256]) {
+  while (length >= 3 * block) {
+    std::uint64_t crc1 = 0;
+    std::uint64_t crc2 = 0;
+    const unsigned char *end = p + block;
+    do {
+      std::uint64_t word0, word1, word2;
+      std::memcpy(&word0, p, sizeof(word0));
+      std::memcpy(&word1, p + block, sizeof(word1));
+      std::memcpy(&word2, p + 2 * block, sizeof(word2));
+      crc0 = _mm_crc32_u64(crc0, word0);
+      crc1 = _mm_crc32_u64(crc1, word1);
+      crc2 = _mm_crc32_u64(crc2, word2);
+      p += 8;
+    } while (p < end);
+    crc0 = shift(table, static_cast<std::uint32_t>(crc0)) ^ crc1;
+    crc0 = shift(table, static_cast<std::uint32_t>(crc0)) ^ crc2;
+    p += 2 * block;
+    length -= 3 * block;
+  }
+  return crc0;
+}
+
+__attribute__((target("sse4.2"))) std::uint32_t crc32cSse42(
+    const unsigned char *p, std::size_t length, std::uint32_t crc) {
+  std::uint64_t crc64 = crc;
+  crc64 = crc32cSse42Blocks(p, length, crc64, LONG_BLOCK,
+                            shiftTables.longShift);
+  crc64 = crc32cSse42Blocks(p, length, crc64, SHORT_BLOCK,
+                            shiftTables.shortShift);
+  while (length >= 8) {
+    std::uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    crc64 = _mm_crc32_u64(crc64, word);
+    p += 8;
+    length -= 8;
+  }
+  crc = static_cast<std::uint32_t>(crc64);
+  while (length-- > 0) {
+    crc = _mm_crc32_u8(crc, *p++);
+  }
+  return crc;
+}
+
+const bool hasSse42 = __builtin_cpu_supports("sse4.2");
+#endif
+
+}  // namespace
+
+std::uint32_t crc32c(const void *data, std::size_t length, std::uint32_t crc) {
+  const unsigned char *p = static_cast<const unsigned char *>(data);
+  crc = ~crc;
+#ifdef BADGERDB_CRC32C_SSE42
+  if (hasSse42) {
+    return ~crc32cSse42(p, length, crc);
+  }
+#endif
+  return ~crc32cSoftware(p, length, crc);
+}
+
+bool crc32cHardware() {
+#ifdef BADGERDB_CRC32C_SSE42
+  return hasSse42;
+#else
+  return false;
+#endif
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,37 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace badgerdb {
+
+/**
+ * Computes the CRC32C (Castagnoli) checksum of a buffer, continuing from a
+ * previous checksum so that a buffer can be checksummed in pieces.
+ *
+ * Uses the SSE4.2 crc32 instruction when the CPU has it, which checksums a
+ * page in well under a microsecond, and a table-driven implementation
+ * processing eight bytes at a time otherwise.
+ *
+ * @param data    Bytes to checksum.
+ * @param length  Number of bytes.
+ * @param crc     Checksum of the preceding bytes, or 0 to start.
+ * @return  Checksum of all bytes so far.
+ */
+std::uint32_t crc32c(const void *data, std::size_t length,
+                     std::uint32_t crc = 0);
+
+/**
+ * Returns true if crc32c() uses the hardware instruction on this CPU.
+ */
+bool crc32cHardware();
+
+}  // namespace badgerdb
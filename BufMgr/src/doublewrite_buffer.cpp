@@ -0,0 +1,174 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "doublewrite_buffer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <map>
+
+#include "crc32c.h"
+#include "exceptions/checksum_mismatch_exception.h"
+#include "exceptions/doublewrite_exception.h"
+#include "exceptions/file_not_found_exception.h"
+
+namespace badgerdb {
+
+namespace {
+
+const char DOUBLEWRITE_MAGIC[8] = {'B', 'D', 'B', 'D', 'W', 'B', '0', '1'};
+
+}  // namespace
+
+DoublewriteBuffer::DoublewriteBuffer(const std::string &path)
+    : path_(path), fd_(-1) {
+  fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) {
+    throw DoublewriteException(path_, std::strerror(errno));
+  }
+}
+
+DoublewriteBuffer::~DoublewriteBuffer() { ::close(fd_); }
+
+std::size_t DoublewriteBuffer::imageOffset(const std::size_t directoryLength) {
+  const std::size_t end = sizeof(BatchHeader) + directoryLength;
+  return (end + Page::SIZE - 1) / Page::SIZE * Page::SIZE;
+}
+
+void DoublewriteBuffer::write(
+    const std::vector<std::pair<File *, const Page *>> &pages) {
+  for (auto first = pages.begin(); first != pages.end();) {
+    auto last = first;
+    for (std::uint32_t n = 0; n < MAX_BATCH_PAGES && last != pages.end(); ++n) {
+      ++last;
+    }
+    writeBatch(first, last);
+    first = last;
+  }
+}
+
+void DoublewriteBuffer::writeBatch(
+    std::vector<std::pair<File *, const Page *>>::const_iterator first,
+    std::vector<std::pair<File *, const Page *>>::const_iterator last) {
+  std::string directory;
+  for (auto it = first; it != last; ++it) {
+    const DirectoryEntry entry = {it->second->page_number(),
+                                  static_cast<std::uint32_t>(
+                                      it->first->filename().size())};
+    directory.append(reinterpret_cast<const char *>(&entry), sizeof(entry));
+  }
+  for (auto it = first; it != last; ++it) {
+    directory.append(it->first->filename());
+  }
+
+  BatchHeader header;
+  std::memcpy(header.magic, DOUBLEWRITE_MAGIC, sizeof(header.magic));
+  header.count = last - first;
+  header.directoryLength = directory.size();
+  header.directoryChecksum = crc32c(directory.data(), directory.size());
+  header.reserved = 0;
+
+  // The images are built exactly as they will be written in place.
+  const std::size_t offset = imageOffset(directory.size());
+  std::vector<char> batch(offset + header.count * Page::SIZE);
+  std::memcpy(&batch[0], &header, sizeof(header));
+  std::memcpy(&batch[sizeof(header)], directory.data(), directory.size());
+  char *image = &batch[offset];
+  for (auto it = first; it != last; ++it, image += Page::SIZE) {
+    it->first->pageImage(*it->second, image);
+  }
+
+  // One sequential write, made durable before any page is touched in place.
+  if (pwrite(fd_, batch.data(), batch.size(), 0) !=
+          static_cast<ssize_t>(batch.size()) ||
+      fdatasync(fd_) != 0) {
+    throw DoublewriteException(path_, std::strerror(errno));
+  }
+
+  image = &batch[offset];
+  std::map<std::string, File *> written;
+  for (auto it = first; it != last; ++it, image += Page::SIZE) {
+    it->first->writePageImage(it->second->page_number(), image);
+    written[it->first->filename()] = it->first;
+  }
+
+  // The next batch overwrites these copies, so the pages must be on disk.
+  for (const auto &file : written) {
+    file.second->sync();
+  }
+}
+
+std::uint32_t DoublewriteBuffer::recover() {
+  BatchHeader header;
+  if (pread(fd_, &header, sizeof(header), 0) != sizeof(header) ||
+      std::memcmp(header.magic, DOUBLEWRITE_MAGIC, sizeof(header.magic)) !=
+          0 ||
+      header.count > MAX_BATCH_PAGES) {
+    return 0;
+  }
+  std::string directory(header.directoryLength, '\0');
+  if (pread(fd_, &directory[0], directory.size(), sizeof(header)) !=
+          static_cast<ssize_t>(directory.size()) ||
+      crc32c(directory.data(), directory.size()) != header.directoryChecksum ||
+      directory.size() < header.count * sizeof(DirectoryEntry)) {
+    // Torn while the batch itself was written; nothing was written in place.
+    return 0;
+  }
+
+  std::map<std::string, File> files;
+  std::uint32_t repaired = 0;
+  std::size_t nameOffset = header.count * sizeof(DirectoryEntry);
+  std::vector<char> image(Page::SIZE);
+  for (std::uint32_t i = 0; i < header.count; ++i) {
+    DirectoryEntry entry;
+    std::memcpy(&entry, &directory[i * sizeof(entry)], sizeof(entry));
+    if (nameOffset + entry.nameLength > directory.size()) break;
+    const std::string name = directory.substr(nameOffset, entry.nameLength);
+    nameOffset += entry.nameLength;
+
+    // A copy torn in the double-write file means its page was never
+    // written in place.
+    if (pread(fd_, image.data(), Page::SIZE,
+              imageOffset(header.directoryLength) + i * Page::SIZE) !=
+        static_cast<ssize_t>(Page::SIZE)) {
+      continue;
+    }
+    Page copy;
+    copy.readImage(image.data());
+    if (!copy.hasValidChecksum()) continue;
+
+    auto file = files.find(name);
+    if (file == files.end()) {
+      try {
+        file = files.emplace(name, File::open(name)).first;
+      } catch (const FileNotFoundException &) {
+        continue;
+      }
+    }
+    if (entry.pageNo >= file->second.readHeader().num_pages) continue;
+
+    bool intact;
+    try {
+      intact = file->second.readPage(entry.pageNo, true /* allow_free */)
+                   .hasValidChecksum();
+    } catch (const ChecksumMismatchException &) {
+      intact = false;
+    }
+    if (intact) continue;
+
+    file->second.writePageImage(entry.pageNo, image.data());
+    file->second.sync();
+    ++repaired;
+  }
+  return repaired;
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,128 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "file.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Protects page writes against being torn by a crash.
+ *
+ * A page write interrupted by a crash can leave a page on disk that is half
+ * old and half new, which no log of page images can be applied to safely
+ * once the checksum no longer matches.  A double-write buffer avoids this:
+ * each batch of pages is first written with a single sequential write to a
+ * separate file and synced, and only then written in place.  If a crash tears
+ * an in-place write, the intact copy survives in the double-write file, and
+ * recover() puts it back.
+ *
+ * The cost over writing in place is one sequential write and sync per batch,
+ * plus a sync of each data file before the next batch reuses the buffer.
+ *
+ * @warning This class is not threadsafe.
+ */
+class DoublewriteBuffer {
+ public:
+  /**
+   * Largest number of pages written as one batch.  Longer lists are split.
+   */
+  static const std::uint32_t MAX_BATCH_PAGES = 128;
+
+  /**
+   * Opens the double-write file at the given path, creating it if it does
+   * not exist.  Call recover() before writing anything if the previous run
+   * may have crashed.
+   *
+   * @param path  Path of the double-write file.
+   * @throws  DoublewriteException  If the file cannot be opened.
+   */
+  explicit DoublewriteBuffer(const std::string &path);
+
+  /**
+   * Closes the double-write file.
+   */
+  ~DoublewriteBuffer();
+
+  DoublewriteBuffer(const DoublewriteBuffer &) = delete;
+  DoublewriteBuffer &operator=(const DoublewriteBuffer &) = delete;
+
+  /**
+   * Writes pages back to their files, as File::writePage() would, through
+   * the double-write file.  When this returns the pages are durable.
+   *
+   * @param pages   File and page for each page to write.
+   * @throws  DoublewriteException  If the double-write file cannot be
+   *                                written.
+   */
+  void write(const std::vector<std::pair<File *, const Page *>> &pages);
+
+  /**
+   * Repairs pages torn by a crash during the last batch: every page in the
+   * double-write file whose copy in place fails its checksum is overwritten
+   * with the intact copy.  Call before LogManager::recover(), which needs
+   * intact pages to compare LSNs against, and before any buffer manager
+   * touches the files.
+   *
+   * @return  Number of pages repaired.
+   */
+  std::uint32_t recover();
+
+  /**
+   * Returns the path of the double-write file.
+   */
+  const std::string &path() const { return path_; }
+
+ private:
+  /**
+   * @brief Header of the batch in the double-write file.  A directory of
+   * (page number, file name length) pairs followed by the file names comes
+   * next, then the page images from the next page-aligned offset.
+   */
+  struct BatchHeader {
+    char magic[8];
+    std::uint32_t count;
+    std::uint32_t directoryLength;
+    std::uint32_t directoryChecksum;
+    std::uint32_t reserved;
+  };
+
+  /**
+   * @brief Directory entry for one page of a batch.
+   */
+  struct DirectoryEntry {
+    PageId pageNo;
+    std::uint32_t nameLength;
+  };
+
+  /**
+   * Offset of the first page image for a directory of the given length.
+   */
+  static std::size_t imageOffset(const std::size_t directoryLength);
+
+  /**
+   * Writes one batch of at most MAX_BATCH_PAGES pages.
+   */
+  void writeBatch(
+      std::vector<std::pair<File *, const Page *>>::const_iterator first,
+      std::vector<std::pair<File *, const Page *>>::const_iterator last);
+
+  /**
+   * Path of the double-write file and its descriptor.
+   */
+  std::string path_;
+  int fd_;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,27 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "checksum_mismatch_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+ChecksumMismatchException::ChecksumMismatchException(
+    const std::string &file, const PageId page_number,
+    const std::uint32_t stored, const std::uint32_t computed)
+    : BadgerDbException(""), filename_(file), page_number_(page_number) {
+  std::stringstream ss;
+  ss << "Checksum mismatch on page " << page_number_ << " of file '"
+     << filename_ << "': stored " << std::hex << stored << ", computed "
+     << computed;
+  message_.assign(ss.str());
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,24 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "doublewrite_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+DoublewriteException::DoublewriteException(const std::string &path,
+                                           const std::string &reason)
+    : BadgerDbException(""), path_(path) {
+  std::stringstream ss;
+  ss << "Double-write buffer " << path_ << ": " << reason;
+  message_.assign(ss.str());
+}
+
+}  // namespace badgerdb
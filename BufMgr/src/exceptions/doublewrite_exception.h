@@ -0,0 +1,44 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when the double-write buffer cannot be
+ *        opened or written.
+ */
+class DoublewriteException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a double-write exception for the given buffer file.
+   *
+   * @param path    Path of the double-write file.
+   * @param reason  Description of what went wrong.
+   */
+  explicit DoublewriteException(const std::string &path,
+                                const std::string &reason);
+
+  /**
+   * Returns the path of the double-write file that caused this exception.
+   */
+  virtual const std::string &path() const { return path_; }
+
+ protected:
+  /**
+   * Path of the double-write file that caused this exception.
+   */
+  std::string path_;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,43 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when the write-ahead log cannot be read
+ *        or written.
+ */
+class LogException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a log exception for the given log file.
+   *
+   * @param path    Path of the log file.
+   * @param reason  Description of what went wrong.
+   */
+  explicit LogException(const std::string &path, const std::string &reason);
+
+  /**
+   * Returns the path of the log file that caused this exception.
+   */
+  virtual const std::string &path() const { return path_; }
+
+ protected:
+  /**
+   * Path of the log file that caused this exception.
+   */
+  std::string path_;
+};
+
+}  // namespace badgerdb
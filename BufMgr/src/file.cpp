@@ -8,29 +8,54 @@
 
 #include "file.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <cassert>
 #include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <string>
 
+#include "exceptions/checksum_mismatch_exception.h"
 #include "exceptions/file_exists_exception.h"
 #include "exceptions/file_not_found_exception.h"
 #include "exceptions/file_open_exception.h"
 #include "exceptions/invalid_page_exception.h"
 #include "file_iterator.h"
+#include "latency_histogram.h"
+#include "lz_codec.h"
 #include "page.h"
+#include "probes.h"
 
 namespace badgerdb {
 
 File::StreamMap File::open_streams_;
 File::CountMap File::open_counts_;
+File::PageMapMap File::open_page_maps_;
+std::atomic<bool> File::verify_checksums_(true);
+std::map<std::string, std::shared_ptr<File::IoCounters>> File::io_counters_;
+std::mutex File::io_counters_mutex_;
+
+std::uint64_t FileIoStats::*const FileIoStats::FIELDS[NUM_COUNTERS] = {
+    &FileIoStats::seeks,          &FileIoStats::readCalls,
+    &FileIoStats::writeCalls,     &FileIoStats::flushes,
+    &FileIoStats::fsyncs,         &FileIoStats::bytesRead,
+    &FileIoStats::bytesWritten,   &FileIoStats::pageReads,
+    &FileIoStats::pageWrites,     &FileIoStats::headerReads,
+    &FileIoStats::headerWrites,   &FileIoStats::pageHeaderReads,
+    &FileIoStats::listWalkReads};
 
 File File::create(const std::string &filename) {
   return File(filename, true /* create_new */);
 }
 
+File File::createCompressed(const std::string &filename) {
+  return File(filename, true /* create_new */, true /* compressed */);
+}
+
 File File::open(const std::string &filename) {
   return File(filename, false /* create_new */);
 }
@@ -43,6 +68,7 @@ void File::remove(const std::string &filename) {
     throw FileOpenException(filename);
   }
   std::remove(filename.c_str());
+  std::remove(PageMap::mapPath(filename).c_str());
 }
 
 bool File::isOpen(const std::string &filename) {
@@ -65,6 +91,8 @@ bool File::exists(const std::string &filename) {
 File::File(const File &other)
     : filename_(other.filename_),
       stream_(open_streams_[filename_]),
+      page_map_(other.page_map_),
+      io_(other.io_),
       valid_(other.valid_) {
   ++open_counts_[filename_];
 }
@@ -156,18 +184,44 @@ Page File::readPage(const PageId page_number) const {
 }
 
 Page File::readPage(const PageId page_number, const bool allow_free) const {
+  LatencyTimer timer(LatencyOp::FILE_READ);
+  const std::uint64_t probe_start = probeStart(BADGERDB_PROBE_ENABLED(file_read));
+  countIo(FileIoStats::PAGE_READS);
   Page page;
-  stream_->seekg(pagePosition(page_number), std::ios::beg);
-  stream_->read(reinterpret_cast<char *>(&page.header_), sizeof(page.header_));
-  stream_->read(&page.data_[0], Page::DATA_SIZE);
+  if (page_map_) {
+    char image[Page::SIZE];
+    readPageImage(page_number, image);
+    page.readImage(image);
+  } else {
+    stream_->seekg(pagePosition(page_number), std::ios::beg);
+    stream_->read(reinterpret_cast<char *>(&page.header_),
+                  sizeof(page.header_));
+    stream_->read(&page.data_[0], Page::DATA_SIZE);
+    countIo(FileIoStats::SEEKS);
+    countIo(FileIoStats::READ_CALLS, 2);
+    countIo(FileIoStats::BYTES_READ, Page::SIZE);
+  }
+  if (verify_checksums_ && !page.hasValidChecksum()) {
+    throw ChecksumMismatchException(
+        filename_, page_number, page.header_.checksum,
+        Page::computeChecksum(page.header_, page.data_.data()));
+  }
   if (!allow_free && !page.isUsed()) {
     throw InvalidPageException(page_number, filename_);
   }
 
+  BADGERDB_PROBE3(file_read, filename_.c_str(), page_number,
+                  probeElapsed(probe_start));
   return page;
 }
 
 void File::writePage(const Page &new_page) {
+  char image[Page::SIZE];
+  pageImage(new_page, image);
+  writePageImage(new_page.page_number(), image);
+}
+
+void File::pageImage(const Page &new_page, char *image) const {
   PageHeader header = readPageHeader(new_page.page_number());
   if (header.current_page_number == Page::INVALID_NUMBER) {
     // Page has been deleted since it was read.
@@ -179,7 +233,28 @@ void File::writePage(const Page &new_page) {
   const PageId next_page_number = header.next_page_number;
   header = new_page.header_;
   header.next_page_number = next_page_number;
-  writePage(new_page.page_number(), header, new_page);
+  header.checksum = Page::computeChecksum(header, new_page.data_.data());
+  std::memcpy(image, &header, sizeof(header));
+  std::memcpy(image + sizeof(header), new_page.data_.data(), Page::DATA_SIZE);
+}
+
+void File::sync() const {
+  stream_->flush();
+  countIo(FileIoStats::FLUSHES);
+  if (page_map_) {
+    // Syncs the data file before the map.
+    page_map_->sync();
+    countIo(FileIoStats::FSYNCS, 2);
+    return;
+  }
+  // The stream has no descriptor of its own to sync, but syncing any
+  // descriptor of the file flushes all of its data.
+  const int fd = ::open(filename_.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    fdatasync(fd);
+    ::close(fd);
+    countIo(FileIoStats::FSYNCS);
+  }
 }
 
 void File::deletePage(const PageId page_number) {
@@ -219,15 +294,22 @@ FileIterator File::begin() {
 
 FileIterator File::end() { return FileIterator(this, Page::INVALID_NUMBER); }
 
-File::File(const std::string &name, const bool create_new)
+File::File(const std::string &name, const bool create_new,
+           const bool compressed)
     : filename_(name), valid_(true) {
   openIfNeeded(create_new);
 
   if (create_new) {
     // File starts with 1 page (the header).
     FileHeader header = {1 /* num_pages */, 0 /* first_used_page */,
-                         0 /* num_free_pages */, 0 /* first_free_page */};
+                         0 /* num_free_pages */, 0 /* first_free_page */,
+                         compressed ? FileHeader::COMPRESSED : 0 /* flags */};
     writeHeader(header);
+    if (compressed) {
+      page_map_.reset(new PageMap(filename_, true /* create */,
+                                  PageMap::SLOT_ALIGNMENT));
+      open_page_maps_[filename_] = page_map_;
+    }
   }
 }
 
@@ -236,6 +318,8 @@ void File::openIfNeeded(const bool create_new) {
       open_counts_.end()) {  // exists an entry already
     ++open_counts_[filename_];
     stream_ = open_streams_[filename_];
+    page_map_ = open_page_maps_[filename_];
+    io_ = ioCounters(filename_);
   } else {
     std::ios_base::openmode mode =
         std::fstream::in | std::fstream::out | std::fstream::binary;
@@ -257,15 +341,30 @@ void File::openIfNeeded(const bool create_new) {
     stream_.reset(new std::fstream(filename_, mode));
     open_streams_[filename_] = stream_;
     open_counts_[filename_] = 1;
+    io_ = ioCounters(filename_);
+
+    // The header says whether pages are found through a page-location map.
+    page_map_.reset();
+    if (!create_new) {
+      const FileHeader header = readHeader();
+      if (!stream_->fail() && (header.flags & FileHeader::COMPRESSED)) {
+        page_map_.reset(new PageMap(filename_, false /* create */,
+                                    PageMap::SLOT_ALIGNMENT));
+      }
+      stream_->clear();
+    }
+    open_page_maps_[filename_] = page_map_;
   }
 }
 
 void File::close() {
   --open_counts_[filename_];
   stream_.reset();
+  page_map_.reset();
   if (open_counts_[filename_] == 0) {
     open_streams_.erase(filename_);
     open_counts_.erase(filename_);
+    open_page_maps_.erase(filename_);
   }
 }
 
@@ -275,16 +374,100 @@ void File::writePage(const PageId page_number, const Page &new_page) {
 
 void File::writePage(const PageId page_number, const PageHeader &header,
                      const Page &new_page) {
+  PageHeader summed = header;
+  summed.checksum = Page::computeChecksum(header, new_page.data_.data());
+  char image[Page::SIZE];
+  std::memcpy(image, &summed, sizeof(summed));
+  std::memcpy(image + sizeof(summed), new_page.data_.data(), Page::DATA_SIZE);
+  writePageImage(page_number, image);
+}
+
+void File::readPageImage(const PageId page_number, char *image) const {
+  if (!page_map_) {
+    stream_->seekg(pagePosition(page_number), std::ios::beg);
+    stream_->read(image, Page::SIZE);
+    countIo(FileIoStats::SEEKS);
+    countIo(FileIoStats::READ_CALLS);
+    countIo(FileIoStats::BYTES_READ, Page::SIZE);
+    return;
+  }
+
+  const PageMap::Location location = page_map_->find(page_number);
+  if (location.length == 0) {
+    // Never written, like the hole an uncompressed file would have.
+    std::memset(image, 0, Page::SIZE);
+    return;
+  }
+  countIo(FileIoStats::SEEKS);
+  countIo(FileIoStats::READ_CALLS);
+  countIo(FileIoStats::BYTES_READ, location.length);
+  if (location.length == Page::SIZE) {
+    stream_->seekg(location.offset, std::ios::beg);
+    stream_->read(image, Page::SIZE);
+    return;
+  }
+  char compressed[Page::SIZE];
+  stream_->seekg(location.offset, std::ios::beg);
+  stream_->read(compressed, location.length);
+  if (!lzDecompress(compressed, location.length, image, Page::SIZE)) {
+    // Leave a page whose checksum cannot match.
+    std::memset(image, 0xFF, Page::SIZE);
+  }
+}
+
+void File::writePageImage(const PageId page_number, const char *image) {
+  LatencyTimer timer(LatencyOp::FILE_WRITE);
+  const std::uint64_t probe_start = probeStart(BADGERDB_PROBE_ENABLED(file_write));
+  countIo(FileIoStats::PAGE_WRITES);
+  if (page_map_) {
+    // Pages which do not shrink by at least a slot's worth are stored as is.
+    char compressed[Page::SIZE];
+    std::size_t length = lzCompress(image, Page::SIZE, compressed,
+                                    Page::SIZE - PageMap::SLOT_ALIGNMENT);
+    const char *stored = compressed;
+    if (length == 0) {
+      length = Page::SIZE;
+      stored = image;
+    }
+
+    // The slot is written before the map points at it.
+    const PageMap::Location location =
+        page_map_->reserve(page_number, length);
+    stream_->seekp(location.offset, std::ios::beg);
+    stream_->write(stored, length);
+    stream_->flush();
+    page_map_->commit(page_number, location);
+    // The map entry is one more write of its own.
+    countIo(FileIoStats::SEEKS);
+    countIo(FileIoStats::WRITE_CALLS, 2);
+    countIo(FileIoStats::FLUSHES);
+    countIo(FileIoStats::BYTES_WRITTEN, length + sizeof(PageMap::Location));
+    BADGERDB_PROBE3(file_write, filename_.c_str(), page_number,
+                    probeElapsed(probe_start));
+    return;
+  }
+
+  // A single write, so the page reaches the file in one piece as far as the
+  // stream is concerned; the double-write buffer covers torn writes below.
   stream_->seekp(pagePosition(page_number), std::ios::beg);
-  stream_->write(reinterpret_cast<const char *>(&header), sizeof(header));
-  stream_->write(&new_page.data_[0], Page::DATA_SIZE);
+  stream_->write(image, Page::SIZE);
   stream_->flush();
+  countIo(FileIoStats::SEEKS);
+  countIo(FileIoStats::WRITE_CALLS);
+  countIo(FileIoStats::FLUSHES);
+  countIo(FileIoStats::BYTES_WRITTEN, Page::SIZE);
+  BADGERDB_PROBE3(file_write, filename_.c_str(), page_number,
+                  probeElapsed(probe_start));
 }
 
 FileHeader File::readHeader() const {
   FileHeader header;
   stream_->seekg(0 /* pos */, std::ios::beg);
   stream_->read(reinterpret_cast<char *>(&header), sizeof(header));
+  countIo(FileIoStats::HEADER_READS);
+  countIo(FileIoStats::SEEKS);
+  countIo(FileIoStats::READ_CALLS);
+  countIo(FileIoStats::BYTES_READ, sizeof(header));
 
   return header;
 }
@@ -293,14 +476,87 @@ void File::writeHeader(const FileHeader &header) {
   stream_->seekp(0 /* pos */, std::ios::beg);
   stream_->write(reinterpret_cast<const char *>(&header), sizeof(header));
   stream_->flush();
+  countIo(FileIoStats::HEADER_WRITES);
+  countIo(FileIoStats::SEEKS);
+  countIo(FileIoStats::WRITE_CALLS);
+  countIo(FileIoStats::FLUSHES);
+  countIo(FileIoStats::BYTES_WRITTEN, sizeof(header));
 }
 
 PageHeader File::readPageHeader(PageId page_number) const {
+  countIo(FileIoStats::PAGE_HEADER_READS);
   PageHeader header;
+  if (page_map_) {
+    char image[Page::SIZE];
+    readPageImage(page_number, image);
+    std::memcpy(&header, image, sizeof(header));
+    return header;
+  }
   stream_->seekg(pagePosition(page_number), std::ios::beg);
   stream_->read(reinterpret_cast<char *>(&header), sizeof(header));
+  countIo(FileIoStats::SEEKS);
+  countIo(FileIoStats::READ_CALLS);
+  countIo(FileIoStats::BYTES_READ, sizeof(header));
 
   return header;
 }
 
+std::shared_ptr<File::IoCounters> File::ioCounters(
+    const std::string &filename) {
+  std::lock_guard<std::mutex> lock(io_counters_mutex_);
+  std::shared_ptr<IoCounters> &counters = io_counters_[filename];
+  if (!counters) counters = std::make_shared<IoCounters>();
+  return counters;
+}
+
+namespace {
+
+/**
+ * Returns a snapshot of a file's I/O counters.
+ */
+template <typename Counters>
+FileIoStats snapshot(const Counters &counters) {
+  FileIoStats stats;
+  for (int i = 0; i < FileIoStats::NUM_COUNTERS; ++i) {
+    stats.*FileIoStats::FIELDS[i] =
+        counters.values[i].load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+}  // namespace
+
+FileIoStats File::ioStats(const std::string &filename) {
+  std::lock_guard<std::mutex> lock(io_counters_mutex_);
+  const auto counters = io_counters_.find(filename);
+  return counters == io_counters_.end() ? FileIoStats()
+                                        : snapshot(*counters->second);
+}
+
+std::map<std::string, FileIoStats> File::allIoStats() {
+  std::lock_guard<std::mutex> lock(io_counters_mutex_);
+  std::map<std::string, FileIoStats> stats;
+  for (const auto &counters : io_counters_) {
+    stats[counters.first] = snapshot(*counters.second);
+  }
+  return stats;
+}
+
+FileIoStats File::globalIoStats() {
+  FileIoStats total;
+  for (const auto &stats : allIoStats()) {
+    total += stats.second;
+  }
+  return total;
+}
+
+void File::resetIoStats() {
+  std::lock_guard<std::mutex> lock(io_counters_mutex_);
+  for (const auto &counters : io_counters_) {
+    for (std::atomic<std::uint64_t> &value : counters.second->values) {
+      value.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
 }  // namespace badgerdb
@@ -8,12 +8,15 @@
 
 #pragma once
 
+#include <atomic>
 #include <fstream>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 
 #include "page.h"
+#include "page_map.h"
 
 namespace badgerdb {
 
@@ -43,6 +46,17 @@ struct FileHeader {
    */
   PageId first_free_page;
 
+  /**
+   * Format flags of the file.
+   */
+  std::uint32_t flags;
+
+  /**
+   * Flag set for files whose pages are compressed and located through a
+   * PageMap.
+   */
+  static const std::uint32_t COMPRESSED = 1;
+
   /**
    * Returns true if this file header is equal to the other.
    *
@@ -52,10 +66,124 @@ struct FileHeader {
   bool operator==(const FileHeader &rhs) const {
     return num_pages == rhs.num_pages && num_free_pages == rhs.num_free_pages &&
            first_used_page == rhs.first_used_page &&
-           first_free_page == rhs.first_free_page;
+           first_free_page == rhs.first_free_page && flags == rhs.flags;
   }
 };
 
+/**
+ * @brief Counts of the I/O a file has done: stream operations, bytes moved
+ * and what the pages read were for.  File keeps a set of these counters per
+ * file name; a FileIoStats is a snapshot of them.
+ */
+struct FileIoStats {
+  /**
+   * Indices of the counters, one per field below.
+   */
+  enum Counter {
+    SEEKS,
+    READ_CALLS,
+    WRITE_CALLS,
+    FLUSHES,
+    FSYNCS,
+    BYTES_READ,
+    BYTES_WRITTEN,
+    PAGE_READS,
+    PAGE_WRITES,
+    HEADER_READS,
+    HEADER_WRITES,
+    PAGE_HEADER_READS,
+    LIST_WALK_READS,
+    NUM_COUNTERS
+  };
+
+  /**
+   * Seeks, reads and writes issued on the file's stream or descriptors, and
+   * stream flushes and syncs to disk.
+   */
+  std::uint64_t seeks;
+  std::uint64_t readCalls;
+  std::uint64_t writeCalls;
+  std::uint64_t flushes;
+  std::uint64_t fsyncs;
+
+  /**
+   * Bytes read from and written to the file.
+   */
+  std::uint64_t bytesRead;
+  std::uint64_t bytesWritten;
+
+  /**
+   * Whole pages read and written.
+   */
+  std::uint64_t pageReads;
+  std::uint64_t pageWrites;
+
+  /**
+   * Reads and writes of the file header, and reads of just a page header.
+   */
+  std::uint64_t headerReads;
+  std::uint64_t headerWrites;
+  std::uint64_t pageHeaderReads;
+
+  /**
+   * Pages and page headers read while walking the list of used pages, by
+   * allocatePage(), deletePage() or a FileIterator.  These are also counted
+   * as page or page header reads.
+   */
+  std::uint64_t listWalkReads;
+
+  FileIoStats() { clear(); }
+
+  /**
+   * Sets every count to 0.
+   */
+  void clear() {
+    for (std::uint64_t FileIoStats::*field : FIELDS) this->*field = 0;
+  }
+
+  /**
+   * Returns the number of system calls the operations counted amount to:
+   * every seek, read, write and sync is one, as every write is flushed
+   * before the stream is used again.
+   */
+  std::uint64_t syscalls() const {
+    return seeks + readCalls + writeCalls + fsyncs;
+  }
+
+  /**
+   * Returns the number of reads done for metadata rather than data pages:
+   * file header and page header reads, and whole pages read only to walk
+   * the list of used pages.
+   */
+  std::uint64_t metadataReads() const {
+    return headerReads + pageHeaderReads + listWalkReads;
+  }
+
+  /**
+   * Adds another snapshot's counts to this one.
+   */
+  FileIoStats &operator+=(const FileIoStats &other) {
+    for (std::uint64_t FileIoStats::*field : FIELDS)
+      this->*field += other.*field;
+    return *this;
+  }
+
+  /**
+   * Returns the I/O done between an earlier snapshot and this one.
+   */
+  FileIoStats operator-(const FileIoStats &earlier) const {
+    FileIoStats diff;
+    for (std::uint64_t FileIoStats::*field : FIELDS)
+      diff.*field = this->*field - earlier.*field;
+    return diff;
+  }
+
+  /**
+   * Fields in the order of the Counter indices.
+   */
+  static std::uint64_t FileIoStats::*const FIELDS[NUM_COUNTERS];
+};
+
 /**
  * @brief Class which represents a file in the filesystem containing database
  *        pages.
@@ -68,6 +196,8 @@ struct FileHeader {
  * File class detects this (by looking in the open_streams_ map) and just
  * returns a file object with the already created stream for the file without
  * actually opening the UNIX file again.
+ * Files made by createCompressed() store each page compressed in a slot of
+ * its own size instead of at a fixed position; see PageMap.
  *
  * @warning This class is not threadsafe.
  */
@@ -81,6 +211,18 @@ class File {
    */
   static File create(const std::string &filename);
 
+  /**
+   * Creates a new compressed file.  Its pages are compressed when written
+   * and packed into variable-size slots found through a page-location map
+   * kept in a side file (see PageMap), and decompressed when read.  Apart
+   * from its footprint it behaves exactly like a file made by create().
+   *
+   * @param filename  Name of the file.
+   * @throws  FileExistsException   If the requested file already exists.
+   * @return  File object representing the new file.
+   */
+  static File createCompressed(const std::string &filename);
+
   /**
    * Opens the file named fileName and returns the corresponding File object.
    * It first checks if the file is already open. If so, then the new File
@@ -119,6 +261,49 @@ class File {
    */
   static bool exists(const std::string &filename);
 
+  /**
+   * Turns verification of page checksums on read on or off for all files.
+   * Pages are always written with a checksum; verification is on by default.
+   *
+   * @param verify  Whether readPage() verifies checksums.
+   */
+  static void setVerifyChecksums(const bool verify) {
+    verify_checksums_ = verify;
+  }
+
+  /**
+   * Returns true if readPage() verifies page checksums.
+   */
+  static bool verifyChecksums() { return verify_checksums_; }
+
+  /**
+   * Returns the I/O done on this file so far, by any File object for it.
+   */
+  FileIoStats ioStats() const { return ioStats(filename_); }
+
+  /**
+   * Returns the I/O done on the named file so far, including while it was
+   * open earlier.  All zero if it has never been opened.
+   *
+   * @param filename  Name of the file.
+   */
+  static FileIoStats ioStats(const std::string &filename);
+
+  /**
+   * Returns the I/O done on every file opened so far, by file name.
+   */
+  static std::map<std::string, FileIoStats> allIoStats();
+
+  /**
+   * Returns the I/O done on all files together.
+   */
+  static FileIoStats globalIoStats();
+
+  /**
+   * Sets the I/O counts of every file back to 0.
+   */
+  static void resetIoStats();
+
   /**
    * Copy constructor.
    *
@@ -169,6 +354,8 @@ class File {
    * @return  The page.
    * @throws  InvalidPageException  If the page doesn't exist in the file or is
    *                                not currently used.
+   * @throws  ChecksumMismatchException  If checksums are verified and the page
+   *                                     is corrupt or torn.
    */
   Page readPage(const PageId page_number) const;
 
@@ -181,6 +368,11 @@ class File {
    */
   void writePage(const Page &new_page);
 
+  /**
+   * Forces every page written to the file so far to stable storage.
+   */
+  void sync() const;
+
   /**
    * Deletes a page from the file.
    *
@@ -195,6 +387,11 @@ class File {
    */
   const std::string &filename() const { return filename_; }
 
+  /**
+   * Returns true if the pages of this file are stored compressed.
+   */
+  bool isCompressed() const { return page_map_ != nullptr; }
+
   /**
    * Returns an iterator at the first page in the file.
    *
@@ -235,12 +432,14 @@ class File {
    * @see File::open()
    * @param name        Name of file.
    * @param create_new  Whether to create a new file.
+   * @param compressed  Whether a new file stores its pages compressed.
    * @throws  FileExistsException     If the underlying file exists and
    *                                  create_new is true.
    * @throws  FileNotFoundException   If the underlying file doesn't exist and
    *                                  create_new is false.
    */
-  explicit File(const std::string &name, const bool create_new);
+  explicit File(const std::string &name, const bool create_new,
+                const bool compressed = false);
 
   /**
    * Returns the position of the page with the given number in the file (as an
@@ -285,6 +484,8 @@ class File {
    * @return  The page.
    * @throws  InvalidPageException  If the page is free (unused) and
    *                                allow_free is false.
+   * @throws  ChecksumMismatchException  If checksums are verified and the page
+   *                                     is corrupt or torn.
    */
   Page readPage(const PageId page_number, const bool allow_free) const;
 
@@ -301,7 +502,8 @@ class File {
   /**
    * Writes a page into the file at the given page number with the given header.
    * This does not ensure that the number in the header equals the position on
-   * disk.  No bounds checking is performed.
+   * disk.  No bounds checking is performed.  The page is stored with the
+   * checksum of the header and data written.
    *
    * @param page_number Number of page whose contents to replace.
    * @param header      Header of page to write.
@@ -310,6 +512,36 @@ class File {
   void writePage(const PageId page_number, const PageHeader &header,
                  const Page &new_page);
 
+  /**
+   * Reads the image of a page of Page::SIZE bytes as stored in the file,
+   * decompressing it if the file is compressed.  No bounds checking is
+   * performed.
+   *
+   * @param page_number Number of page to read.
+   * @param image       Buffer of Page::SIZE bytes receiving the image.
+   */
+  void readPageImage(const PageId page_number, char *image) const;
+
+  /**
+   * Builds the exact image writePage(new_page) stores: the page with the
+   * next page pointer currently on disk and a fresh checksum.
+   *
+   * @param new_page  Page to be written.
+   * @param image     Buffer of Page::SIZE bytes receiving the image.
+   * @throws  InvalidPageException  If the page has been deleted.
+   */
+  void pageImage(const Page &new_page, char *image) const;
+
+  /**
+   * Writes a page image of Page::SIZE bytes into the file at the given page
+   * number with a single write, compressing it if the file is compressed.
+   * No bounds checking is performed.
+   *
+   * @param page_number Number of page whose contents to replace.
+   * @param image       Page image, as built by pageImage().
+   */
+  void writePageImage(const PageId page_number, const char *image);
+
   /**
    * Reads the header for this file from disk.
    *
@@ -333,8 +565,33 @@ class File {
    */
   PageHeader readPageHeader(const PageId page_number) const;
 
+  /**
+   * @brief I/O counters of one file, updated with relaxed atomics so that
+   * background readers may count too.
+   */
+  struct IoCounters {
+    std::atomic<std::uint64_t> values[FileIoStats::NUM_COUNTERS];
+    IoCounters() {
+      for (std::atomic<std::uint64_t> &value : values) value = 0;
+    }
+  };
+
+  /**
+   * Returns the I/O counters of the named file, creating them if needed.
+   */
+  static std::shared_ptr<IoCounters> ioCounters(const std::string &filename);
+
+  /**
+   * Adds to one of this file's I/O counters.
+   */
+  void countIo(const FileIoStats::Counter counter,
+               const std::uint64_t n = 1) const {
+    if (io_) io_->values[counter].fetch_add(n, std::memory_order_relaxed);
+  }
+
   typedef std::map<std::string, std::shared_ptr<std::fstream>> StreamMap;
   typedef std::map<std::string, int> CountMap;
+  typedef std::map<std::string, std::shared_ptr<PageMap>> PageMapMap;
 
   /**
    * Streams for opened files.
@@ -346,6 +603,23 @@ class File {
    */
   static CountMap open_counts_;
 
+  /**
+   * Page-location maps for opened compressed files.
+   */
+  static PageMapMap open_page_maps_;
+
+  /**
+   * Whether readPage() verifies page checksums.
+   */
+  static std::atomic<bool> verify_checksums_;
+
+  /**
+   * I/O counters of every file opened so far, which outlive the file's
+   * streams so that its totals survive closing it, and their lock.
+   */
+  static std::map<std::string, std::shared_ptr<IoCounters>> io_counters_;
+  static std::mutex io_counters_mutex_;
+
   /**
    * Name of the file this object represents.
    */
@@ -356,13 +630,26 @@ class File {
    */
   std::shared_ptr<std::fstream> stream_;
 
+  /**
+   * Page-location map if the file is compressed, otherwise null.
+   */
+  std::shared_ptr<PageMap> page_map_;
+
+  /**
+   * I/O counters of the file, or null for an empty File object.
+   */
+  std::shared_ptr<IoCounters> io_;
+
   /**
    * Whether this file is valid.
    */
   bool valid_;
 
+  friend class BufWarmup;
+  friend class DoublewriteBuffer;
   friend class FileIterator;
   friend class FileTest;
+  friend class LogManager;
 };
 
 }  // namespace badgerdb
@@ -56,6 +56,7 @@ class FileIterator {
    */
   inline FileIterator &operator++() {
     assert(file_ != NULL);
+    file_->countIo(FileIoStats::LIST_WALK_READS);
     const PageHeader &header = file_->readPageHeader(current_page_number_);
     current_page_number_ = header.next_page_number;
 
@@ -67,6 +68,7 @@ class FileIterator {
     FileIterator tmp = *this;  // copy ourselves
 
     assert(file_ != NULL);
+    file_->countIo(FileIoStats::LIST_WALK_READS);
     const PageHeader &header = file_->readPageHeader(current_page_number_);
     current_page_number_ = header.next_page_number;
 
@@ -96,6 +98,7 @@ class FileIterator {
    * @return  Page in file.
    */
   inline Page operator*() const {
+    file_->countIo(FileIoStats::LIST_WALK_READS);
     return file_->readPage(current_page_number_);
   }
 
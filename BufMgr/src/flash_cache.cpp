@@ -0,0 +1,228 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "flash_cache.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "crc32c.h"
+#include "exceptions/file_not_found_exception.h"
+
+namespace badgerdb {
+
+FlashCache::FlashCache(const std::string &path, const std::uint32_t capacity)
+    : path_(path),
+      fd_(-1),
+      slots_(capacity > 0 ? capacity : 1),
+      hand_(0),
+      filled_(0),
+      nextSeq_(0),
+      writing_(false),
+      hits_(0),
+      misses_(0),
+      stopping_(false) {
+  // Whatever an earlier run left in the file is meaningless without its
+  // index, so the cache always starts empty.
+  fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd_ < 0) {
+    throw FileNotFoundException(path_);
+  }
+  for (Slot &slot : slots_) {
+    slot.used = false;
+    slot.refbit = false;
+  }
+  writer_ = std::thread(&FlashCache::work, this);
+}
+
+FlashCache::~FlashCache() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  queued_.notify_all();
+  writer_.join();
+  ::close(fd_);
+}
+
+void FlashCache::insert(const File &file, const Page &page) {
+  const Key key(file.filename(), page.page_number());
+  std::string image(Page::SIZE, '\0');
+  page.writeImage(&image[0]);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (index_.count(key) || pending_.size() >= MAX_PENDING_PAGES ||
+      !admit(key)) {
+    return;
+  }
+  const std::uint64_t seq = nextSeq_++;
+  pending_[key] = Pending{seq, std::move(image)};
+  queue_.emplace_back(key, seq);
+  queued_.notify_one();
+}
+
+bool FlashCache::admit(const Key &key) {
+  if (filled_ < slots_.size() || ghosts_.erase(key)) {
+    return true;
+  }
+  ghosts_.insert(key);
+  ghostOrder_.push_back(key);
+  while (ghostOrder_.size() > slots_.size()) {
+    ghosts_.erase(ghostOrder_.front());
+    ghostOrder_.pop_front();
+  }
+  return false;
+}
+
+bool FlashCache::lookup(const File &file, const PageId pageNo, Page &page) {
+  const Key key(file.filename(), pageNo);
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // A page still queued is served from memory.
+  const auto pending = pending_.find(key);
+  if (pending != pending_.end()) {
+    page.readImage(pending->second.image.data());
+    ++hits_;
+    return true;
+  }
+
+  const auto entry = index_.find(key);
+  if (entry == index_.end()) {
+    ++misses_;
+    return false;
+  }
+  // The writer never reuses an indexed slot, so reading under the mutex is
+  // safe; it only holds the mutex briefly itself.
+  Slot &slot = slots_[entry->second];
+  char image[Page::SIZE];
+  if (pread(fd_, image, Page::SIZE,
+            static_cast<off_t>(entry->second) * Page::SIZE) != Page::SIZE ||
+      crc32c(image, Page::SIZE) != slot.checksum) {
+    slot.used = false;
+    index_.erase(entry);
+    ++misses_;
+    return false;
+  }
+  slot.refbit = true;
+  page.readImage(image);
+  ++hits_;
+  return true;
+}
+
+void FlashCache::invalidate(const File &file, const PageId pageNo) {
+  const Key key(file.filename(), pageNo);
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_.erase(key);
+  const auto entry = index_.find(key);
+  if (entry != index_.end()) {
+    slots_[entry->second].used = false;
+    index_.erase(entry);
+  }
+}
+
+void FlashCache::invalidate(const File &file) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const Key first(file.filename(), 0);
+  for (auto it = pending_.lower_bound(first);
+       it != pending_.end() && it->first.first == file.filename();) {
+    it = pending_.erase(it);
+  }
+  for (auto it = index_.lower_bound(first);
+       it != index_.end() && it->first.first == file.filename();) {
+    slots_[it->second].used = false;
+    it = index_.erase(it);
+  }
+}
+
+void FlashCache::drain() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  written_.wait(lock, [this] { return queue_.empty() && !writing_; });
+}
+
+std::size_t FlashCache::getPageCount() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return index_.size();
+}
+
+std::uint64_t FlashCache::getHits() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return hits_;
+}
+
+std::uint64_t FlashCache::getMisses() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return misses_;
+}
+
+std::uint32_t FlashCache::chooseSlot() {
+  // Slots never used yet come first, then freed ones, then the clock.
+  if (filled_ < slots_.size()) {
+    return filled_++;
+  }
+  while (true) {
+    Slot &slot = slots_[hand_];
+    const std::uint32_t current = hand_;
+    hand_ = (hand_ + 1) % slots_.size();
+    if (slot.used && slot.refbit) {
+      slot.refbit = false;
+      continue;
+    }
+    if (slot.used) {
+      index_.erase(slot.key);
+      slot.used = false;
+    }
+    return current;
+  }
+}
+
+void FlashCache::work() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    queued_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+    if (stopping_) {
+      break;
+    }
+
+    const std::pair<Key, std::uint64_t> next = queue_.front();
+    queue_.pop_front();
+    const auto pending = pending_.find(next.first);
+    if (pending == pending_.end() || pending->second.seq != next.second) {
+      // Invalidated or replaced by a later copy while it waited.
+      written_.notify_all();
+      continue;
+    }
+    const std::string image = pending->second.image;
+    const std::uint32_t slotNo = chooseSlot();
+    writing_ = true;
+    lock.unlock();
+
+    const bool ok = pwrite(fd_, image.data(), Page::SIZE,
+                           static_cast<off_t>(slotNo) * Page::SIZE) ==
+                    static_cast<ssize_t>(Page::SIZE);
+    const std::uint32_t checksum = crc32c(image.data(), Page::SIZE);
+
+    lock.lock();
+    writing_ = false;
+    // Publish only if the page was not invalidated during the write.
+    const auto still = pending_.find(next.first);
+    if (ok && still != pending_.end() && still->second.seq == next.second) {
+      Slot &slot = slots_[slotNo];
+      slot.key = next.first;
+      slot.checksum = checksum;
+      slot.used = true;
+      slot.refbit = false;
+      index_[next.first] = slotNo;
+    }
+    if (still != pending_.end() && still->second.seq == next.second) {
+      pending_.erase(still);
+    }
+    written_.notify_all();
+  }
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,207 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "file.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Second-level page cache in a file on fast local storage.
+ *
+ * Meant for data files on slow network volumes with a local SSD to spare.
+ * Pages evicted from the buffer pool, once clean, are handed to insert(),
+ * which queues them; a background thread writes them into fixed-size slots
+ * of the cache file with pwrite() and only then adds them to the index of
+ * (file, page) to slot.  A miss in the buffer pool calls lookup() before
+ * reading from the data file.
+ *
+ * Admission: while the cache has free slots every page is admitted.  Once it
+ * is full, a page is only admitted the second time it is evicted within the
+ * window of a ghost list as long as the cache, so pages read once by a scan
+ * do not flush out pages which keep coming back.  Eviction: a clock over the
+ * slots, whose reference bit lookup() sets.
+ *
+ * The index is held in memory only and the cache file is truncated when
+ * opened, so the cache is always safe to discard across a restart.  Every
+ * slot carries a checksum which lookup() verifies.  The buffer manager
+ * invalidates a page whenever it writes the page back or deletes it, since
+ * the cached copy is stale from then on.
+ *
+ * This class is threadsafe.
+ */
+class FlashCache {
+ public:
+  /**
+   * Number of queued pages at which insert() starts dropping pages instead
+   * of queueing them.
+   */
+  static const std::size_t MAX_PENDING_PAGES = 256;
+
+  /**
+   * Creates a cache of the given number of pages in a file at the given
+   * path, replacing whatever the file held.
+   *
+   * @param path      Path of the cache file.
+   * @param capacity  Number of pages the cache holds.
+   * @throws  FileNotFoundException  If the cache file cannot be created.
+   */
+  FlashCache(const std::string &path, const std::uint32_t capacity);
+
+  /**
+   * Stops the writer thread and closes the cache file.  The file is left
+   * behind for the next run to overwrite.
+   */
+  ~FlashCache();
+
+  FlashCache(const FlashCache &) = delete;
+  FlashCache &operator=(const FlashCache &) = delete;
+
+  /**
+   * Offers an evicted page to the cache.  If it is admitted, it is queued
+   * to be written by the background thread; this never waits for I/O.
+   *
+   * @param file  File the page belongs to.
+   * @param page  Page, which must be clean.
+   */
+  void insert(const File &file, const Page &page);
+
+  /**
+   * Reads a page from the cache if it is there.
+   *
+   * @param file    File the page belongs to.
+   * @param pageNo  Page number.
+   * @param page    Cached page, returned by reference.
+   * @return  True if the page was cached.
+   */
+  bool lookup(const File &file, const PageId pageNo, Page &page);
+
+  /**
+   * Drops a page from the cache, including a queued copy of it.
+   */
+  void invalidate(const File &file, const PageId pageNo);
+
+  /**
+   * Drops every page of a file from the cache.
+   */
+  void invalidate(const File &file);
+
+  /**
+   * Waits until every queued page has been written.
+   */
+  void drain();
+
+  /**
+   * Returns the number of pages in the cache file.
+   */
+  std::size_t getPageCount();
+
+  /**
+   * Returns the number of lookups which found their page, and which did not.
+   */
+  std::uint64_t getHits();
+  std::uint64_t getMisses();
+
+ private:
+  typedef std::pair<std::string, PageId> Key;
+
+  /**
+   * @brief A slot of the cache file.
+   */
+  struct Slot {
+    Key key;
+    std::uint32_t checksum;
+    bool used;
+    bool refbit;
+  };
+
+  /**
+   * @brief A page waiting to be written.  Its sequence number tells whether
+   * it has been replaced or invalidated while it waited.
+   */
+  struct Pending {
+    std::uint64_t seq;
+    std::string image;
+  };
+
+  /**
+   * Body of the writer thread.
+   */
+  void work();
+
+  /**
+   * Picks the slot to write the next page into and removes its page from
+   * the index.  Mutex must be held.
+   */
+  std::uint32_t chooseSlot();
+
+  /**
+   * Returns true if a page is admitted, remembering it in the ghost list
+   * otherwise.  Mutex must be held.
+   */
+  bool admit(const Key &key);
+
+  /**
+   * Path and descriptor of the cache file.
+   */
+  std::string path_;
+  int fd_;
+
+  /**
+   * Protects the members below.
+   */
+  std::mutex mutex_;
+  std::condition_variable queued_;
+  std::condition_variable written_;
+
+  /**
+   * Slots, the clock hand over them and the number of slots ever used.
+   */
+  std::vector<Slot> slots_;
+  std::uint32_t hand_;
+  std::uint32_t filled_;
+
+  /**
+   * Slot holding each cached page.
+   */
+  std::map<Key, std::uint32_t> index_;
+
+  /**
+   * Pages waiting to be written, in order, and their images.
+   */
+  std::deque<std::pair<Key, std::uint64_t>> queue_;
+  std::map<Key, Pending> pending_;
+  std::uint64_t nextSeq_;
+  bool writing_;
+
+  /**
+   * Pages evicted once recently, oldest first.
+   */
+  std::deque<Key> ghostOrder_;
+  std::set<Key> ghosts_;
+
+  std::uint64_t hits_;
+  std::uint64_t misses_;
+
+  bool stopping_;
+  std::thread writer_;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,23 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "frame_pool.h"
+
+namespace badgerdb {
+
+Page &FramePool::materialize(const FrameId frameNo) {
+  frames_[frameNo].reset(new Page());
+  return *frames_[frameNo];
+}
+
+Page &FramePool::materialize(const FrameId frameNo, Page &&page) {
+  frames_[frameNo].reset(new Page(std::move(page)));
+  return *frames_[frameNo];
+}
+
+}  // namespace badgerdb
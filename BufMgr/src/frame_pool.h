@@ -0,0 +1,124 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Array of buffer pool frames which are materialized on first use.
+ *
+ * Constructing a Page zero-fills its data, so building every frame up front
+ * makes a large pool slow to construct and commits all of its memory at once.
+ * A FramePool only reserves one pointer per frame; the Page behind a frame is
+ * created the first time the frame is accessed.  Memory is therefore
+ * committed as the pool warms up.
+ *
+ * Each Page is allocated separately, so growing or shrinking the pool never
+ * moves the pages of other frames.
+ *
+ * @warning This class is not threadsafe.
+ */
+class FramePool {
+ public:
+  /**
+   * Constructs a pool of the given number of frames, none of them
+   * materialized.
+   *
+   * @param size  Number of frames.
+   */
+  explicit FramePool(const std::uint32_t size) : frames_(size) {}
+
+  /**
+   * Returns the page held in the given frame, materializing an empty page if
+   * the frame has not been used yet.
+   *
+   * @param frameNo Frame number.
+   * @return  Page in the frame.
+   */
+  Page &operator[](const FrameId frameNo) {
+    Page *page = frames_[frameNo].get();
+    return page ? *page : materialize(frameNo);
+  }
+
+  /**
+   * Replaces the page held in the given frame.  A frame which has not been
+   * materialized yet takes over the given page without first being
+   * zero-filled.
+   *
+   * @param frameNo Frame number.
+   * @param page    Page to move into the frame.
+   * @return  Page in the frame.
+   */
+  Page &assign(const FrameId frameNo, Page &&page) {
+    Page *existing = frames_[frameNo].get();
+    if (!existing) {
+      return materialize(frameNo, std::move(page));
+    }
+    *existing = std::move(page);
+    return *existing;
+  }
+
+  /**
+   * Returns the memory held by the page in the given frame.  The frame is
+   * materialized again when it is next used.
+   *
+   * @param frameNo Frame number.
+   */
+  void release(const FrameId frameNo) { frames_[frameNo].reset(); }
+
+  /**
+   * Returns true if the given frame currently holds a page in memory.
+   *
+   * @param frameNo Frame number.
+   */
+  bool isMaterialized(const FrameId frameNo) const {
+    return frames_[frameNo] != nullptr;
+  }
+
+  /**
+   * Adds an unmaterialized frame at the end of the pool.
+   */
+  void emplace_back() { frames_.emplace_back(); }
+
+  /**
+   * Removes the last frame of the pool, releasing its page.
+   */
+  void pop_back() { frames_.pop_back(); }
+
+  /**
+   * Returns the number of frames in the pool.
+   */
+  std::uint32_t size() const { return frames_.size(); }
+
+ private:
+  /**
+   * Creates the page of a frame which has not been materialized, empty or
+   * with the given contents.
+   *
+   * @param frameNo Frame number.
+   * @param page    Initial contents of the frame.
+   * @return  Page in the frame.
+   */
+  Page &materialize(const FrameId frameNo);
+  Page &materialize(const FrameId frameNo, Page &&page);
+
+  /**
+   * Page of each frame, or null if the frame has not been materialized.
+   */
+  std::vector<std::unique_ptr<Page>> frames_;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,82 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "frequency_sketch.h"
+
+#include <algorithm>
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Spreads the bits of a key hash (the splitmix64 finalizer).
+ */
+std::uint64_t mix(std::uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+  return x ^ (x >> 31);
+}
+
+}  // namespace
+
+FrequencySketch::FrequencySketch(const std::uint32_t capacity)
+    : mask_(0), additions_(0) {
+  // A power of two counters per row, at least four per expected key.
+  std::uint32_t width = 64;
+  while (width < 4ull * capacity && width < (1u << 30)) {
+    width <<= 1;
+  }
+  mask_ = width - 1;
+  table_.assign(ROWS * width / 16, 0);
+  sampleSize_ = 10 * width;
+}
+
+std::uint32_t FrequencySketch::index(const std::uint64_t hash,
+                                     const int row) const {
+  // Double hashing derives a counter for each row from one hash.
+  const std::uint64_t h = (hash & 0xFFFFFFFFull) + row * (hash >> 32);
+  return row * (mask_ + 1) + static_cast<std::uint32_t>(h & mask_);
+}
+
+void FrequencySketch::increment(const std::uint64_t key) {
+  const std::uint64_t hash = mix(key);
+  for (int row = 0; row < ROWS; ++row) {
+    const std::uint32_t counter = index(hash, row);
+    std::uint64_t &word = table_[counter / 16];
+    const int shift = (counter % 16) * 4;
+    if (((word >> shift) & 0xF) < MAX_COUNT) {
+      word += 1ull << shift;
+    }
+  }
+  if (++additions_ >= sampleSize_) {
+    age();
+  }
+}
+
+std::uint32_t FrequencySketch::estimate(const std::uint64_t key) const {
+  const std::uint64_t hash = mix(key);
+  std::uint32_t count = MAX_COUNT;
+  for (int row = 0; row < ROWS; ++row) {
+    const std::uint32_t counter = index(hash, row);
+    count = std::min<std::uint32_t>(
+        count, (table_[counter / 16] >> ((counter % 16) * 4)) & 0xF);
+  }
+  return count;
+}
+
+void FrequencySketch::age() {
+  // Halving each 4-bit counter: shift the word and drop the bits which
+  // crossed into the neighbouring counter.
+  for (std::uint64_t &word : table_) {
+    word = (word >> 1) & 0x7777777777777777ull;
+  }
+  additions_ /= 2;
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,84 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace badgerdb {
+
+/**
+ * @brief Approximate access frequencies of pages, for TinyLFU admission.
+ *
+ * A count-min sketch of 4-bit counters: each key is counted in one counter
+ * of each of four rows, and its estimate is the smallest of the four.  To
+ * keep the history recent, all counters are halved once the number of
+ * increments reaches ten times the width of the sketch (aging), so a key
+ * needs to keep being accessed to keep a high estimate.  Memory is half a
+ * byte per counter, four counters per expected entry.
+ *
+ * @warning This class is not threadsafe.
+ */
+class FrequencySketch {
+ public:
+  /**
+   * Largest value a counter reaches.
+   */
+  static const std::uint32_t MAX_COUNT = 15;
+
+  /**
+   * Creates a sketch sized for the given number of distinct keys, such as
+   * the number of frames in the buffer pool.
+   *
+   * @param capacity  Expected number of keys whose frequency matters.
+   */
+  explicit FrequencySketch(const std::uint32_t capacity);
+
+  /**
+   * Counts one access to a key.
+   *
+   * @param key   Hash of the key.
+   */
+  void increment(const std::uint64_t key);
+
+  /**
+   * Returns the estimated number of recent accesses to a key, at most
+   * MAX_COUNT.
+   *
+   * @param key   Hash of the key.
+   */
+  std::uint32_t estimate(const std::uint64_t key) const;
+
+ private:
+  static const int ROWS = 4;
+
+  /**
+   * Returns the counter of the given row a key is counted in.
+   */
+  std::uint32_t index(const std::uint64_t hash, const int row) const;
+
+  /**
+   * Halves every counter.
+   */
+  void age();
+
+  /**
+   * Counters, sixteen to a word, row after row; counters per row minus one.
+   */
+  std::vector<std::uint64_t> table_;
+  std::uint32_t mask_;
+
+  /**
+   * Increments since the last aging, and the number which triggers aging.
+   */
+  std::uint32_t additions_;
+  std::uint32_t sampleSize_;
+};
+
+}  // namespace badgerdb
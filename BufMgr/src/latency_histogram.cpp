@@ -0,0 +1,158 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "latency_histogram.h"
+
+#include <sstream>
+
+namespace badgerdb {
+
+std::atomic<bool> LatencyMetrics::enabled_(false);
+LatencyHistogram
+    LatencyMetrics::histograms_[static_cast<int>(LatencyOp::NUM_OPS)];
+
+std::uint32_t LatencyHistogram::bucketOf(std::uint64_t value) {
+  if (value > MAX_VALUE) value = MAX_VALUE;
+  if (value < SUB_BUCKETS) return static_cast<std::uint32_t>(value);
+
+  // Above SUB_BUCKETS, each power of two [2^m, 2^(m+1)) is split into
+  // SUB_BUCKETS / 2 buckets of width 2^shift.
+  const int msb = 63 - __builtin_clzll(value);
+  const int shift = msb - SUB_BUCKET_BITS + 1;
+  return SUB_BUCKETS + (shift - 1) * (SUB_BUCKETS / 2) +
+         static_cast<std::uint32_t>((value >> shift) - SUB_BUCKETS / 2);
+}
+
+std::uint64_t LatencyHistogram::bucketEnd(std::uint32_t bucket) {
+  if (bucket < SUB_BUCKETS) return bucket;
+  const std::uint32_t k = bucket - SUB_BUCKETS;
+  const int shift = k / (SUB_BUCKETS / 2) + 1;
+  const std::uint64_t start =
+      static_cast<std::uint64_t>(k % (SUB_BUCKETS / 2) + SUB_BUCKETS / 2)
+      << shift;
+  return start + (1ull << shift) - 1;
+}
+
+void LatencyHistogram::record(std::uint64_t nanos) {
+  counts_[bucketOf(nanos)].fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(nanos, std::memory_order_relaxed);
+  std::uint64_t current = max_.load(std::memory_order_relaxed);
+  while (current < nanos &&
+         !max_.compare_exchange_weak(current, nanos,
+                                     std::memory_order_relaxed)) {
+  }
+}
+
+std::uint64_t LatencyHistogram::count() const {
+  std::uint64_t total = 0;
+  for (const std::atomic<std::uint64_t> &count : counts_) {
+    total += count.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+double LatencyHistogram::mean() const {
+  const std::uint64_t total = count();
+  return total == 0
+             ? 0.0
+             : static_cast<double>(sum_.load(std::memory_order_relaxed)) /
+                   total;
+}
+
+std::uint64_t LatencyHistogram::percentile(double percent) const {
+  std::uint64_t counts[NUM_BUCKETS];
+  std::uint64_t total = 0;
+  for (std::uint32_t i = 0; i < NUM_BUCKETS; ++i) {
+    counts[i] = counts_[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+  if (total == 0) return 0;
+
+  // The rank of the value sought, counting from 1.
+  std::uint64_t rank = static_cast<std::uint64_t>(percent / 100.0 * total + 0.5);
+  if (rank < 1) rank = 1;
+  if (rank > total) rank = total;
+
+  std::uint64_t seen = 0;
+  for (std::uint32_t i = 0; i < NUM_BUCKETS; ++i) {
+    seen += counts[i];
+    if (seen >= rank) {
+      // The bucket's end may lie beyond anything actually recorded.
+      const std::uint64_t end = bucketEnd(i);
+      const std::uint64_t highest = max();
+      return end < highest ? end : highest;
+    }
+  }
+  return max();
+}
+
+void LatencyHistogram::reset() {
+  for (std::atomic<std::uint64_t> &count : counts_) {
+    count.store(0, std::memory_order_relaxed);
+  }
+  sum_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+const char *LatencyMetrics::name(LatencyOp op) {
+  switch (op) {
+    case LatencyOp::READ_HIT:
+      return "readPage.hit";
+    case LatencyOp::READ_MISS:
+      return "readPage.miss";
+    case LatencyOp::ALLOC_PAGE:
+      return "allocPage";
+    case LatencyOp::UNPIN:
+      return "unPinPage";
+    case LatencyOp::WRITEBACK:
+      return "writeBack";
+    case LatencyOp::FILE_READ:
+      return "File.readPage";
+    case LatencyOp::FILE_WRITE:
+      return "File.writePage";
+    default:
+      return "unknown";
+  }
+}
+
+void LatencyMetrics::reset() {
+  for (LatencyHistogram &histogram : histograms_) {
+    histogram.reset();
+  }
+}
+
+std::string LatencyMetrics::toText() {
+  std::ostringstream out;
+  for (int i = 0; i < static_cast<int>(LatencyOp::NUM_OPS); ++i) {
+    const LatencyHistogram &h = histograms_[i];
+    out << name(static_cast<LatencyOp>(i)) << " count=" << h.count()
+        << " mean=" << static_cast<std::uint64_t>(h.mean())
+        << "ns p50=" << h.percentile(50) << "ns p99=" << h.percentile(99)
+        << "ns p999=" << h.percentile(99.9) << "ns max=" << h.max() << "ns\n";
+  }
+  return out.str();
+}
+
+std::string LatencyMetrics::toJson() {
+  std::ostringstream out;
+  out << "{";
+  for (int i = 0; i < static_cast<int>(LatencyOp::NUM_OPS); ++i) {
+    const LatencyHistogram &h = histograms_[i];
+    out << (i == 0 ? "" : ",") << "\"" << name(static_cast<LatencyOp>(i))
+        << "\":{\"count\":" << h.count()
+        << ",\"mean_ns\":" << static_cast<std::uint64_t>(h.mean())
+        << ",\"p50_ns\":" << h.percentile(50)
+        << ",\"p99_ns\":" << h.percentile(99)
+        << ",\"p999_ns\":" << h.percentile(99.9) << ",\"max_ns\":" << h.max()
+        << "}";
+  }
+  out << "}";
+  return out.str();
+}
+
+}  // namespace badgerdb
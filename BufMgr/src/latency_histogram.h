@@ -0,0 +1,206 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace badgerdb {
+
+/**
+ * @brief Distribution of latencies in nanoseconds, in log-linear buckets.
+ *
+ * As in HdrHistogram, every power of two is split into a fixed number of
+ * equal buckets, so a recorded value is known to within about 3% from 1ns to
+ * about 18 minutes, in a fixed 10KB.  Recording is one relaxed atomic add,
+ * so any number of threads may record and read concurrently; a percentile
+ * read while values are being recorded may miss the newest of them.
+ *
+ * This class is threadsafe.
+ */
+class LatencyHistogram {
+ public:
+  /**
+   * Largest value recorded exactly; larger values are counted as this.
+   */
+  static const std::uint64_t MAX_VALUE = (1ull << 40) - 1;
+
+  LatencyHistogram() { reset(); }
+
+  LatencyHistogram(const LatencyHistogram &) = delete;
+  LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+  /**
+   * Records one value.
+   *
+   * @param nanos   Latency in nanoseconds.
+   */
+  void record(std::uint64_t nanos);
+
+  /**
+   * Returns the number of values recorded.
+   */
+  std::uint64_t count() const;
+
+  /**
+   * Returns the mean of the values recorded, or 0 if there are none.
+   */
+  double mean() const;
+
+  /**
+   * Returns the largest value recorded.
+   */
+  std::uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+  /**
+   * Returns the value the given percentage of recorded values is at or
+   * below, rounded up to the end of its bucket, or 0 if there are none.
+   *
+   * @param percent Percentile, from 0 to 100.
+   */
+  std::uint64_t percentile(double percent) const;
+
+  /**
+   * Forgets every value recorded.
+   */
+  void reset();
+
+ private:
+  /**
+   * Buckets per power of two are 2^SUB_BUCKET_BITS / 2, except below
+   * 2^SUB_BUCKET_BITS where every value has its own bucket.
+   */
+  static const int SUB_BUCKET_BITS = 6;
+  static const std::uint32_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+  static const std::uint32_t NUM_BUCKETS =
+      SUB_BUCKETS + (40 - SUB_BUCKET_BITS) * (SUB_BUCKETS / 2);
+
+  /**
+   * Returns the bucket a value falls in.
+   */
+  static std::uint32_t bucketOf(std::uint64_t value);
+
+  /**
+   * Returns the largest value falling in a bucket.
+   */
+  static std::uint64_t bucketEnd(std::uint32_t bucket);
+
+  std::atomic<std::uint64_t> counts_[NUM_BUCKETS];
+  std::atomic<std::uint64_t> sum_;
+  std::atomic<std::uint64_t> max_;
+};
+
+/**
+ * Operations whose latency is measured.
+ */
+enum class LatencyOp {
+  READ_HIT,
+  READ_MISS,
+  ALLOC_PAGE,
+  UNPIN,
+  WRITEBACK,
+  FILE_READ,
+  FILE_WRITE,
+  NUM_OPS
+};
+
+/**
+ * @brief Process-wide latency histograms, one per LatencyOp, which the buffer
+ * manager and File record into while enabled.  Disabled by default; a
+ * disabled call site costs one relaxed load.
+ *
+ * This class is threadsafe.
+ */
+class LatencyMetrics {
+ public:
+  /**
+   * Turns recording on or off.
+   */
+  static void setEnabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  /**
+   * Returns true while latencies are recorded.
+   */
+  static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  /**
+   * Returns the histogram of an operation.
+   */
+  static LatencyHistogram &histogram(LatencyOp op) {
+    return histograms_[static_cast<int>(op)];
+  }
+
+  /**
+   * Returns the name an operation is exported under, such as "readPage.hit".
+   */
+  static const char *name(LatencyOp op);
+
+  /**
+   * Forgets every value recorded.
+   */
+  static void reset();
+
+  /**
+   * Returns one line per operation with its count, mean, p50, p99, p999 and
+   * maximum in nanoseconds.
+   */
+  static std::string toText();
+
+  /**
+   * Returns the same as toText() as a JSON object keyed by operation name.
+   */
+  static std::string toJson();
+
+ private:
+  static std::atomic<bool> enabled_;
+  static LatencyHistogram histograms_[static_cast<int>(LatencyOp::NUM_OPS)];
+};
+
+/**
+ * @brief Measures the time from its construction to its destruction and
+ * records it in the histogram of an operation, if recording was enabled when
+ * it was constructed.
+ */
+class LatencyTimer {
+ public:
+  explicit LatencyTimer(LatencyOp op)
+      : op_(op), start_(LatencyMetrics::enabled() ? now() : 0) {}
+
+  ~LatencyTimer() {
+    if (start_ != 0) LatencyMetrics::histogram(op_).record(now() - start_);
+  }
+
+  LatencyTimer(const LatencyTimer &) = delete;
+  LatencyTimer &operator=(const LatencyTimer &) = delete;
+
+  /**
+   * Records the time under another operation, once the kind of operation is
+   * known.
+   */
+  void setOp(LatencyOp op) { op_ = op; }
+
+  /**
+   * Returns the current time in nanoseconds on a monotonic clock.
+   */
+  static std::uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+ private:
+  LatencyOp op_;
+  std::uint64_t start_;
+};
+
+}  // namespace badgerdb
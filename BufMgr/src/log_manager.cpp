@@ -0,0 +1,350 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "log_manager.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+
+#include "exceptions/file_not_found_exception.h"
+#include "exceptions/log_exception.h"
+
+namespace badgerdb {
+
+namespace {
+
+const char LOG_MAGIC[8] = {'B', 'D', 'B', 'W', 'A', 'L', '0', '2'};
+
+/**
+ * Largest file name and record a log may hold; anything longer is
+ * corruption.
+ */
+const std::uint32_t MAX_NAME_LENGTH = 4096;
+const std::uint32_t MAX_RECORD_LENGTH = 1 << 26;
+
+}  // namespace
+
+LogManager::LogManager(const std::string &path)
+    : path_(path),
+      fd_(-1),
+      flushing_(false),
+      redoLsn_(0),
+      startLsn_(FILE_HEADER_SIZE) {
+  fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd_ < 0) {
+    throw LogException(path_, std::strerror(errno));
+  }
+
+  struct stat st;
+  fstat(fd_, &st);
+  char header[FILE_HEADER_SIZE] = {};
+  if (st.st_size == 0) {
+    std::memcpy(header, LOG_MAGIC, sizeof(LOG_MAGIC));
+    std::memcpy(header + START_LSN_OFFSET, &startLsn_, sizeof(startLsn_));
+    if (pwrite(fd_, header, sizeof(header), 0) != sizeof(header) ||
+        fdatasync(fd_) != 0) {
+      ::close(fd_);
+      throw LogException(path_, std::strerror(errno));
+    }
+    st.st_size = sizeof(header);
+  } else if (pread(fd_, header, sizeof(header), 0) != sizeof(header) ||
+             std::memcmp(header, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0) {
+    ::close(fd_);
+    throw LogException(path_, "not a write-ahead log");
+  }
+  std::memcpy(&redoLsn_, header + REDO_LSN_OFFSET, sizeof(redoLsn_));
+  std::memcpy(&startLsn_, header + START_LSN_OFFSET, sizeof(startLsn_));
+
+  // Find the end of the log, cutting off a torn last record.  Checkpoints
+  // drop the records before their redo LSN, so only the records since the
+  // last one are scanned.
+  RecordHeader record;
+  std::string name;
+  std::string payload;
+  Lsn lsn = getRedoLsn();
+  while (readRecord(lsn, record, name, payload)) {
+    lsn = record.lsn;
+  }
+  if (static_cast<Lsn>(st.st_size) > fileOffset(lsn)) {
+    if (ftruncate(fd_, fileOffset(lsn)) != 0) {
+      ::close(fd_);
+      throw LogException(path_, std::strerror(errno));
+    }
+  }
+  bufferStart_ = endLsn_ = flushedLsn_ = lsn;
+}
+
+LogManager::~LogManager() {
+  try {
+    commit();
+  } catch (const LogException &) {
+  }
+  ::close(fd_);
+}
+
+std::uint32_t LogManager::checksum(const char *record,
+                                   const std::size_t length) {
+  // FNV-1a over everything after the checksum field.
+  std::uint32_t h = 2166136261u;
+  for (std::size_t i = sizeof(std::uint32_t); i < length; ++i) {
+    h = (h ^ static_cast<unsigned char>(record[i])) * 16777619u;
+  }
+  return h;
+}
+
+Lsn LogManager::append(RecordHeader &header, const std::string &name,
+                       const char *payload, const std::size_t payloadLength) {
+  header.length = sizeof(header) + name.size() + payloadLength;
+  header.nameLength = name.size();
+  header.reserved = 0;
+  header.lsn = endLsn_ + header.length;
+
+  const std::size_t start = buffer_.size();
+  buffer_.append(reinterpret_cast<const char *>(&header), sizeof(header));
+  buffer_.append(name);
+  buffer_.append(payload, payloadLength);
+  header.checksum = checksum(&buffer_[start], header.length);
+  std::memcpy(&buffer_[start], &header.checksum, sizeof(header.checksum));
+
+  endLsn_ = header.lsn;
+  return endLsn_;
+}
+
+Lsn LogManager::logPage(const File &file, Page &page) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  RecordHeader header;
+  header.type = PAGE_IMAGE;
+  header.pageNo = page.page_number();
+
+  // The image carries its own LSN, which is known before it is appended.
+  page.set_page_lsn(endLsn_ + sizeof(header) + file.filename().size() +
+                    Page::SIZE);
+  char image[Page::SIZE];
+  page.writeImage(image);
+  return append(header, file.filename(), image, sizeof(image));
+}
+
+Lsn LogManager::commit() {
+  Lsn target;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    target = endLsn_;
+  }
+  flush(target);
+  return target;
+}
+
+void LogManager::flush(const Lsn lsn) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (flushedLsn_ < lsn) {
+    if (flushing_) {
+      // Another thread is syncing; its sync may well cover this LSN too.
+      flushed_.wait(lock);
+      continue;
+    }
+
+    // Become the leader and sync everything appended so far.
+    flushing_ = true;
+    std::string batch;
+    batch.swap(buffer_);
+    const Lsn start = bufferStart_;
+    const Lsn target = endLsn_;
+    const Lsn position = fileOffset(start);
+    bufferStart_ = endLsn_;
+    lock.unlock();
+
+    bool ok = pwrite(fd_, batch.data(), batch.size(), position) ==
+                  static_cast<ssize_t>(batch.size()) &&
+              fdatasync(fd_) == 0;
+    const int error = errno;
+
+    lock.lock();
+    flushing_ = false;
+    if (ok) {
+      flushedLsn_ = target;
+    } else {
+      // Put the records back so a later flush can retry them.
+      buffer_.insert(0, batch);
+      bufferStart_ = start;
+    }
+    flushed_.notify_all();
+    if (!ok) {
+      throw LogException(path_, std::strerror(error));
+    }
+  }
+}
+
+Lsn LogManager::getFlushedLsn() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return flushedLsn_;
+}
+
+Lsn LogManager::getEndLsn() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return endLsn_;
+}
+
+bool LogManager::readRecord(const Lsn lsn, RecordHeader &header,
+                            std::string &name, std::string &payload) {
+  if (lsn < startLsn_ ||
+      pread(fd_, &header, sizeof(header), fileOffset(lsn)) != sizeof(header) ||
+      header.length < sizeof(header) + header.nameLength ||
+      header.nameLength > MAX_NAME_LENGTH ||
+      header.length > MAX_RECORD_LENGTH ||
+      header.lsn != lsn + header.length) {
+    return false;
+  }
+
+  std::string record(header.length, '\0');
+  if (pread(fd_, &record[0], record.size(), fileOffset(lsn)) !=
+          static_cast<ssize_t>(record.size()) ||
+      checksum(record.data(), record.size()) != header.checksum) {
+    return false;
+  }
+  name = record.substr(sizeof(header), header.nameLength);
+  payload = record.substr(sizeof(header) + header.nameLength);
+  return true;
+}
+
+Lsn LogManager::logCheckpointBegin(
+    const std::vector<std::tuple<std::string, PageId, Lsn>> &pages) {
+  // Payload: for each page its number, recovery LSN, name length and name.
+  std::string payload;
+  for (const auto &page : pages) {
+    const PageId pageNo = std::get<1>(page);
+    const Lsn recLsn = std::get<2>(page);
+    const std::uint32_t nameLength = std::get<0>(page).size();
+    payload.append(reinterpret_cast<const char *>(&pageNo), sizeof(pageNo));
+    payload.append(reinterpret_cast<const char *>(&recLsn), sizeof(recLsn));
+    payload.append(reinterpret_cast<const char *>(&nameLength),
+                   sizeof(nameLength));
+    payload.append(std::get<0>(page));
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  RecordHeader header;
+  header.type = CHECKPOINT_BEGIN;
+  header.pageNo = Page::INVALID_NUMBER;
+  return append(header, "", payload.data(), payload.size());
+}
+
+void LogManager::logCheckpointEnd(const Lsn redoLsn) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    RecordHeader header;
+    header.type = CHECKPOINT_END;
+    header.pageNo = Page::INVALID_NUMBER;
+    append(header, "", reinterpret_cast<const char *>(&redoLsn),
+           sizeof(redoLsn));
+  }
+  commit();
+
+  // Only once the end record is durable may recovery skip what precedes it.
+  std::unique_lock<std::mutex> lock(mutex_);
+  flushed_.wait(lock, [this] { return !flushing_; });
+  recycle(std::max(redoLsn, startLsn_));
+}
+
+void LogManager::recycle(const Lsn redoLsn) {
+  // The records recovery still needs are copied into a new log whose header
+  // holds the redo LSN, which then replaces the old one.  Until the rename
+  // is durable a crash leaves the old log, whose earlier redo LSN is still
+  // correct.
+  char header[FILE_HEADER_SIZE] = {};
+  std::memcpy(header, LOG_MAGIC, sizeof(LOG_MAGIC));
+  std::memcpy(header + REDO_LSN_OFFSET, &redoLsn, sizeof(redoLsn));
+  std::memcpy(header + START_LSN_OFFSET, &redoLsn, sizeof(redoLsn));
+  std::string records(bufferStart_ - redoLsn, '\0');
+
+  const std::string tmpPath = path_ + ".tmp";
+  const int fd = ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  const bool ok =
+      fd >= 0 &&
+      pread(fd_, &records[0], records.size(), fileOffset(redoLsn)) ==
+          static_cast<ssize_t>(records.size()) &&
+      pwrite(fd, header, sizeof(header), 0) == sizeof(header) &&
+      pwrite(fd, records.data(), records.size(), FILE_HEADER_SIZE) ==
+          static_cast<ssize_t>(records.size()) &&
+      fdatasync(fd) == 0 && std::rename(tmpPath.c_str(), path_.c_str()) == 0;
+  const int error = errno;
+  if (!ok) {
+    if (fd >= 0) {
+      ::close(fd);
+      ::unlink(tmpPath.c_str());
+    }
+    throw LogException(path_, std::strerror(error));
+  }
+
+  ::close(fd_);
+  fd_ = fd;
+  redoLsn_ = startLsn_ = redoLsn;
+}
+
+Lsn LogManager::getRedoLsn() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return std::max(redoLsn_, startLsn_);
+}
+
+std::uint32_t LogManager::recover() {
+  commit();
+
+  // Each file's page count, read again only for a page past it.
+  struct RecoveredFile {
+    File file;
+    PageId numPages;
+  };
+  std::map<std::string, RecoveredFile> files;
+  std::uint32_t redone = 0;
+  RecordHeader record;
+  std::string name;
+  std::string payload;
+  for (Lsn lsn = getRedoLsn();
+       readRecord(lsn, record, name, payload); lsn = record.lsn) {
+    if (record.type != PAGE_IMAGE || payload.size() != Page::SIZE) continue;
+
+    auto file = files.find(name);
+    if (file == files.end()) {
+      try {
+        file = files.emplace(name, RecoveredFile{File::open(name), 0}).first;
+      } catch (const FileNotFoundException &) {
+        // The file has been removed since; nothing to redo.
+        continue;
+      }
+    }
+    RecoveredFile &recovered = file->second;
+    if (record.pageNo >= recovered.numPages) {
+      recovered.numPages = recovered.file.readHeader().num_pages;
+      if (record.pageNo >= recovered.numPages) continue;
+    }
+
+    // Only redo changes the page on disk does not have yet, and none to a
+    // page deleted since it was logged.
+    const PageHeader onDisk = recovered.file.readPageHeader(record.pageNo);
+    if (onDisk.current_page_number == Page::INVALID_NUMBER ||
+        onDisk.lsn >= record.lsn) {
+      continue;
+    }
+    // The file relinks pages without logging them, so the next page pointer
+    // on disk is newer than the logged one and is kept, as writePage() does.
+    Page page;
+    page.readImage(payload.data());
+    recovered.file.writePage(page);
+    ++redone;
+  }
+  return redone;
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,292 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "file.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Append-only write-ahead log of page after-images.
+ *
+ * Every change to a page that the buffer manager is told about (an unpin with
+ * the dirty flag set) is appended to the log as a full image of the page,
+ * and the page is stamped with the record's log sequence number (LSN).  An
+ * LSN is the byte offset in the log just past the end of its record, counting
+ * the records dropped from the log too, so LSNs grow monotonically and a
+ * record is durable once the log has been synced up to its LSN.
+ *
+ * Records are buffered in memory until flush() or commit() writes them with a
+ * single sequential write and fdatasync().  Concurrent callers are batched
+ * into one sync (group commit): while one thread syncs, the others wait and
+ * are covered by the next sync if the current one did not reach their LSN.
+ *
+ * BufMgr enforces the log-before-data rule by flushing the log up to a page's
+ * LSN before writing the page back.  After a crash, recover() replays every
+ * durable image that is newer than the page on disk, starting at the redo LSN
+ * of the last checkpoint BufMgr completed.  Completing a checkpoint drops the
+ * records before its redo LSN, so the log, and the scan for its end when it
+ * is opened, only grow with the changes made since.  There is no undo pass,
+ * so changes logged before a crash are redone whether or not they were ever
+ * committed.
+ *
+ * This class is threadsafe.
+ */
+class LogManager {
+ public:
+  /**
+   * Opens the log at the given path, creating it if it does not exist.  A
+   * torn record at the end of the log, left by a crash during a write, is
+   * cut off.
+   *
+   * @param path  Path of the log file.
+   * @throws  LogException  If the log cannot be opened or is not a log.
+   */
+  explicit LogManager(const std::string &path);
+
+  /**
+   * Flushes everything appended so far and closes the log.
+   */
+  ~LogManager();
+
+  LogManager(const LogManager &) = delete;
+  LogManager &operator=(const LogManager &) = delete;
+
+  /**
+   * Appends an after-image of the page and stamps the page with the LSN of
+   * the new record.  The record is not durable until the log is flushed.
+   *
+   * @param file  File the page belongs to.
+   * @param page  Page whose current contents are logged.
+   * @return  LSN of the new record.
+   */
+  Lsn logPage(const File &file, Page &page);
+
+  /**
+   * Makes every record appended so far durable.  Returns once the log has
+   * been synced, possibly together with records appended by other threads.
+   *
+   * @return  LSN up to which the log is now durable.
+   */
+  Lsn commit();
+
+  /**
+   * Makes every record up to the given LSN durable.  Does nothing if the log
+   * is already durable that far.
+   *
+   * @param lsn   LSN that must be durable on return.
+   * @throws  LogException  If the log cannot be written.
+   */
+  void flush(const Lsn lsn);
+
+  /**
+   * Returns the LSN up to which the log is durable.
+   */
+  Lsn getFlushedLsn();
+
+  /**
+   * Returns the LSN the next record will end past.
+   */
+  Lsn getEndLsn();
+
+  /**
+   * Appends a record marking the start of a checkpoint, holding the dirty
+   * page table at that point.
+   *
+   * @param pages   Dirty page table: file name, page number and the LSN of
+   *                the first change not yet written, for each dirty page.
+   * @return  LSN of the new record.
+   */
+  Lsn logCheckpointBegin(
+      const std::vector<std::tuple<std::string, PageId, Lsn>> &pages);
+
+  /**
+   * Appends a record marking the end of a checkpoint, makes it durable and
+   * records in the log header that recovery may start at the given LSN.  The
+   * records before it are dropped from the log, which copies the ones after
+   * it into a new log file while appends wait.
+   *
+   * @param redoLsn   LSN before which every change is known to be on disk.
+   */
+  void logCheckpointEnd(const Lsn redoLsn);
+
+  /**
+   * Returns the LSN recovery starts at: the redo LSN of the last completed
+   * checkpoint, or the start of the log.
+   */
+  Lsn getRedoLsn();
+
+  /**
+   * Replays the log from the last completed checkpoint: every page image
+   * newer than the page on disk is written to its file, keeping the page's
+   * link in the file's page list as it is on disk.  Pages deleted since they
+   * were logged are left deleted.  Call before any buffer manager touches
+   * the files.
+   *
+   * @return  Number of pages redone.
+   */
+  std::uint32_t recover();
+
+  /**
+   * Returns the path of the log file.
+   */
+  const std::string &path() const { return path_; }
+
+ private:
+  /**
+   * @brief Fixed-size prefix of every log record.  The record's file name
+   * and payload follow it.
+   */
+  struct RecordHeader {
+    /**
+     * Checksum of the record, excluding this field.
+     */
+    std::uint32_t checksum;
+
+    /**
+     * Total length of the record including this header.
+     */
+    std::uint32_t length;
+
+    /**
+     * Kind of record.
+     */
+    std::uint32_t type;
+
+    /**
+     * Length of the file name following the header.
+     */
+    std::uint32_t nameLength;
+
+    /**
+     * Page the record describes.
+     */
+    PageId pageNo;
+
+    std::uint32_t reserved;
+
+    /**
+     * LSN of this record.
+     */
+    Lsn lsn;
+  };
+
+  /**
+   * Record types.
+   */
+  static const std::uint32_t PAGE_IMAGE = 1;
+  static const std::uint32_t CHECKPOINT_BEGIN = 2;
+  static const std::uint32_t CHECKPOINT_END = 3;
+
+  /**
+   * Size of the header at the start of the log file: a magic number followed
+   * by the redo LSN of the last completed checkpoint and the LSN of the first
+   * record kept in the file.
+   */
+  static const Lsn FILE_HEADER_SIZE = 24;
+
+  /**
+   * Offsets of the redo LSN and of the first LSN within the log file header.
+   */
+  static const Lsn REDO_LSN_OFFSET = 8;
+  static const Lsn START_LSN_OFFSET = 16;
+
+  /**
+   * Computes the checksum of a record whose checksum field is in place.
+   */
+  static std::uint32_t checksum(const char *record, const std::size_t length);
+
+  /**
+   * Appends an encoded record to the log buffer.  Mutex must be held.
+   *
+   * @return  LSN of the record.
+   */
+  Lsn append(RecordHeader &header, const std::string &name,
+             const char *payload, const std::size_t payloadLength);
+
+  /**
+   * Reads the record starting at the given LSN.
+   *
+   * @return  False at the end of the log or at a torn, corrupt or dropped
+   *          record.
+   */
+  bool readRecord(const Lsn lsn, RecordHeader &header, std::string &name,
+                  std::string &payload);
+
+  /**
+   * Replaces the log file by one holding only the records from the given
+   * redo LSN on, and records the redo LSN in its header.  Mutex must be held
+   * and no sync may be in progress.
+   *
+   * @throws  LogException  If the new log cannot be written.
+   */
+  void recycle(const Lsn redoLsn);
+
+  /**
+   * Returns the offset in the log file of the byte at the given LSN.
+   */
+  Lsn fileOffset(const Lsn lsn) const {
+    return lsn - startLsn_ + FILE_HEADER_SIZE;
+  }
+
+  /**
+   * Path of the log file and its descriptor.
+   */
+  std::string path_;
+  int fd_;
+
+  /**
+   * Protects the members below.
+   */
+  std::mutex mutex_;
+
+  /**
+   * Signalled whenever a sync finishes.
+   */
+  std::condition_variable flushed_;
+
+  /**
+   * Records appended but not yet written, which start at offset
+   * bufferStart_ of the log.
+   */
+  std::string buffer_;
+  Lsn bufferStart_;
+
+  /**
+   * End of the last appended record and of the last durable one.
+   */
+  Lsn endLsn_;
+  Lsn flushedLsn_;
+
+  /**
+   * True while a thread is writing and syncing the log.
+   */
+  bool flushing_;
+
+  /**
+   * Redo LSN of the last completed checkpoint, or 0.
+   */
+  Lsn redoLsn_;
+
+  /**
+   * LSN of the first record kept in the log file, which starts right after
+   * the file header.
+   */
+  Lsn startLsn_;
+};
+
+}  // namespace badgerdb
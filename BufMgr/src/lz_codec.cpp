@@ -0,0 +1,188 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "lz_codec.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Shortest match encoded, and the number of bytes at the end of the input
+ * which are always literals.  As in LZ4, no match starts within the last
+ * MATCH_LIMIT bytes.
+ */
+const std::size_t MIN_MATCH = 4;
+const std::size_t LAST_LITERALS = 5;
+const std::size_t MATCH_LIMIT = 12;
+
+/**
+ * Longest distance a match may reach back.
+ */
+const std::size_t MAX_OFFSET = 65535;
+
+const int HASH_BITS = 12;
+
+std::uint32_t read32(const char *p) {
+  std::uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+std::uint32_t hash(std::uint32_t sequence) {
+  return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/**
+ * @brief Output buffer which refuses to write past its end.
+ */
+class Output {
+ public:
+  Output(char *dst, std::size_t capacity)
+      : dst_(dst), length_(0), capacity_(capacity), overflow_(false) {}
+
+  void put(unsigned char byte) {
+    if (length_ >= capacity_) {
+      overflow_ = true;
+      return;
+    }
+    dst_[length_++] = static_cast<char>(byte);
+  }
+
+  void write(const char *src, std::size_t length) {
+    if (length > capacity_ - length_) {
+      overflow_ = true;
+      return;
+    }
+    std::memcpy(dst_ + length_, src, length);
+    length_ += length;
+  }
+
+  /**
+   * Writes the remainder of a length whose first 15 went into a token.
+   */
+  void putLength(std::size_t length) {
+    for (; length >= 255; length -= 255) put(255);
+    put(static_cast<unsigned char>(length));
+  }
+
+  std::size_t length() const { return overflow_ ? 0 : length_; }
+  bool overflow() const { return overflow_; }
+
+ private:
+  char *dst_;
+  std::size_t length_;
+  std::size_t capacity_;
+  bool overflow_;
+};
+
+/**
+ * Emits a sequence: literals followed by a match, or by nothing at the end.
+ */
+void emit(Output &out, const char *literals, std::size_t literalLength,
+          std::size_t offset, std::size_t matchLength) {
+  const std::size_t matchCode = matchLength ? matchLength - MIN_MATCH : 0;
+  out.put(static_cast<unsigned char>(
+      ((literalLength < 15 ? literalLength : 15) << 4) |
+      (matchCode < 15 ? matchCode : 15)));
+  if (literalLength >= 15) out.putLength(literalLength - 15);
+  out.write(literals, literalLength);
+  if (matchLength == 0) return;
+  out.put(static_cast<unsigned char>(offset & 0xFF));
+  out.put(static_cast<unsigned char>(offset >> 8));
+  if (matchCode >= 15) out.putLength(matchCode - 15);
+}
+
+}  // namespace
+
+std::size_t lzCompress(const char *src, std::size_t srcLength, char *dst,
+                       std::size_t dstCapacity) {
+  Output out(dst, dstCapacity);
+  std::int32_t table[1 << HASH_BITS];
+  std::memset(table, -1, sizeof(table));
+
+  std::size_t ip = 0;
+  std::size_t anchor = 0;
+  if (srcLength > MATCH_LIMIT) {
+    const std::size_t limit = srcLength - MATCH_LIMIT;
+    while (ip <= limit && !out.overflow()) {
+      const std::uint32_t sequence = read32(src + ip);
+      const std::uint32_t h = hash(sequence);
+      const std::int32_t ref = table[h];
+      table[h] = static_cast<std::int32_t>(ip);
+      if (ref < 0 || ip - ref > MAX_OFFSET || read32(src + ref) != sequence) {
+        ++ip;
+        continue;
+      }
+
+      std::size_t matchLength = MIN_MATCH;
+      const std::size_t maxMatch = srcLength - LAST_LITERALS - ip;
+      while (matchLength < maxMatch &&
+             src[ref + matchLength] == src[ip + matchLength]) {
+        ++matchLength;
+      }
+      emit(out, src + anchor, ip - anchor, ip - ref, matchLength);
+      ip += matchLength;
+      anchor = ip;
+    }
+  }
+  emit(out, src + anchor, srcLength - anchor, 0, 0);
+  return out.length();
+}
+
+bool lzDecompress(const char *src, std::size_t srcLength, char *dst,
+                  std::size_t dstLength) {
+  const unsigned char *in = reinterpret_cast<const unsigned char *>(src);
+  std::size_t sp = 0;
+  std::size_t dp = 0;
+
+  // Reads the remainder of a length whose first 15 came from a token.
+  auto readLength = [&](std::size_t &length) {
+    unsigned char byte;
+    do {
+      if (sp >= srcLength) return false;
+      byte = in[sp++];
+      length += byte;
+    } while (byte == 255);
+    return true;
+  };
+
+  while (sp < srcLength) {
+    const unsigned char token = in[sp++];
+    std::size_t literalLength = token >> 4;
+    if (literalLength == 15 && !readLength(literalLength)) return false;
+    if (literalLength > srcLength - sp || literalLength > dstLength - dp) {
+      return false;
+    }
+    std::memcpy(dst + dp, src + sp, literalLength);
+    sp += literalLength;
+    dp += literalLength;
+    if (sp == srcLength) break;
+
+    if (srcLength - sp < 2) return false;
+    const std::size_t offset = in[sp] | (in[sp + 1] << 8);
+    sp += 2;
+    if (offset == 0 || offset > dp) return false;
+
+    std::size_t matchLength = token & 15;
+    if (matchLength == 15 && !readLength(matchLength)) return false;
+    matchLength += MIN_MATCH;
+    if (matchLength > dstLength - dp) return false;
+
+    // Byte by byte, since a match may overlap the bytes it produces.
+    for (std::size_t i = 0; i < matchLength; ++i, ++dp) {
+      dst[dp] = dst[dp - offset];
+    }
+  }
+  return dp == dstLength;
+}
+
+}  // namespace badgerdb
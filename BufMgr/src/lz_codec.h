@@ -0,0 +1,43 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace badgerdb {
+
+/**
+ * Compresses a buffer with a byte-oriented LZ77 codec using the LZ4 block
+ * format: sequences of a token, literals, a two-byte match offset and
+ * extended lengths.  Fast enough to run on every page write; text records
+ * typically shrink to a third or less.
+ *
+ * @param src           Bytes to compress.
+ * @param srcLength     Number of bytes to compress, at most 64 KB.
+ * @param dst           Buffer receiving the compressed bytes.
+ * @param dstCapacity   Size of the buffer.
+ * @return  Number of compressed bytes, or 0 if they do not fit in the buffer.
+ */
+std::size_t lzCompress(const char *src, std::size_t srcLength, char *dst,
+                       std::size_t dstCapacity);
+
+/**
+ * Decompresses a buffer produced by lzCompress().  Corrupt input is
+ * detected rather than read or written out of bounds.
+ *
+ * @param src         Compressed bytes.
+ * @param srcLength   Number of compressed bytes.
+ * @param dst         Buffer receiving the decompressed bytes.
+ * @param dstLength   Expected number of decompressed bytes.
+ * @return  True if the input decompressed to exactly dstLength bytes.
+ */
+bool lzDecompress(const char *src, std::size_t srcLength, char *dst,
+                  std::size_t dstLength);
+
+}  // namespace badgerdb
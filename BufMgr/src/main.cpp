@@ -1,20 +1,40 @@
+#include <limits.h>
 #include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include <iostream>
 //#include <stdio.h>
+#include <atomic>
 #include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
 #include <memory>
 #include <optional>
+#include <thread>
 
 #include "buffer.h"
+#include "crc32c.h"
+#include "doublewrite_buffer.h"
+#include "flash_cache.h"
 #include "exceptions/buffer_exceeded_exception.h"
+#include "exceptions/checksum_mismatch_exception.h"
 #include "exceptions/file_not_found_exception.h"
 #include "exceptions/invalid_page_exception.h"
 #include "exceptions/page_not_pinned_exception.h"
 #include "exceptions/page_pinned_exception.h"
+#include "exceptions/shared_pool_exception.h"
 #include "file_iterator.h"
+#include "latency_histogram.h"
 #include "page.h"
 #include "page_iterator.h"
+#include "probes.h"
+#include "log_manager.h"
+#include "memory_pressure.h"
+#include "shared_buffer.h"
+#include "victim_cache.h"
 
 #define PRINT_ERROR(str)                            \
   {                                                 \
@@ -40,6 +60,35 @@ void test3(File &file4);
 void test4(File &file4);
 void test5(File &file4);
 void test6(File &file1);
+void test7(File &file1);
+void test8(File &file1);
+void test9(File &file1);
+void test10(File &file1);
+void test11(File &file1);
+void test12(File &file1);
+void test13(File &file1);
+void test14(File &file1);
+void test15();
+void test16(File &file1);
+void test17(File &file1);
+void test18(File &file1);
+void test19(File &file1);
+void test20(File &file1);
+void test21(File &file1);
+void test22(File &file1);
+void test23(File &file1);
+void test24();
+void test25(File &file1);
+void test26(File &file1);
+void test27(File &file1);
+void test28(File &file1);
+void test29(File &file1);
+void test30();
+void test31(File &file1);
+void test32();
+void test33(File &file1);
+void test34(File &file1);
+void test35(File &file1);
 // Calls the above tests
 void testBufMgr();
 
@@ -140,6 +189,35 @@ void testBufMgr() {
     test4(file4);
     test5(file5);
     test6(file1);
+    test7(file1);
+    test8(file1);
+    test9(file1);
+    test10(file1);
+    test11(file1);
+    test12(file1);
+    test13(file1);
+    test14(file1);
+    test15();
+    test16(file1);
+    test17(file1);
+    test18(file1);
+    test19(file1);
+    test20(file1);
+    test21(file1);
+    test22(file1);
+    test23(file1);
+    test24();
+    test25(file1);
+    test26(file1);
+    test27(file1);
+    test28(file1);
+    test29(file1);
+    test30();
+    test31(file1);
+    test32();
+    test33(file1);
+    test34(file1);
+    test35(file1);
 
     // Close the files by going out of scope
   }
@@ -324,3 +402,1418 @@ void test6(File &file1) {
 
   bufMgr->flushFile(file1);
 }
+
+void test7(File &file1) {
+  // Following a swip pins the page and swizzles the swip; flushing the file
+  // evicts the frame and must unswizzle it again
+  Swip swip(pid[0]);
+  bufMgr->readPage(file1, swip, page);
+  if (!swip.isSwizzled() || swip.pageId() != pid[0]) {
+    PRINT_ERROR("ERROR :: Swip was not swizzled after reading its page.");
+  }
+
+  // A second hop through the swizzled swip returns the same frame
+  bufMgr->readPage(file1, swip, page2);
+  if (page != page2) {
+    PRINT_ERROR("ERROR :: Swizzled swip returned a different frame.");
+  }
+
+  // A swizzled swip only leads to its page in the file it was read from
+  {
+    File other = File::create("test.7");
+    try {
+      bufMgr->readPage(other, swip, page2);
+      PRINT_ERROR(
+          "ERROR :: Swip followed in another file. Exception should have been "
+          "thrown before execution reaches this point.");
+    } catch (const InvalidPageException &e) {
+    }
+  }
+  File::remove("test.7");
+  bufMgr->unPinPage(file1, swip, false);
+  bufMgr->unPinPage(file1, swip, false);
+
+  bufMgr->flushFile(file1);
+  if (swip.isSwizzled() || swip.pageId() != pid[0]) {
+    PRINT_ERROR("ERROR :: Swip was not unswizzled when its frame was evicted.");
+  }
+
+  std::cout << "Test 7 passed"
+            << "\n";
+}
+
+void test8(File &file1) {
+  // Two shared pool clients see the same frames; a client that dies while
+  // holding a pin must not keep the page pinned forever
+  const std::string poolName = "/badgerdb_test8";
+  SharedBufMgr::destroy(poolName);
+  {
+    SharedBufMgr pool1(poolName, 10);
+    pool1.readPage(file1, pid[1], page);
+    rid2 = page->insertRecord("test.8 shared record");
+    pool1.unPinPage(file1, pid[1], true);
+
+    SharedBufMgr pool2(poolName, 10);
+    pool2.readPage(file1, pid[1], page2);
+    if (page2->getRecord(rid2) != "test.8 shared record") {
+      PRINT_ERROR("ERROR :: Shared pool client did not see the other's page.");
+    }
+    pool2.unPinPage(file1, pid[1], false);
+
+    std::cout.flush();
+    const pid_t child = fork();
+    if (child == 0) {
+      SharedBufMgr crashing(poolName, 10);
+      crashing.readPage(file1, pid[1], page3);
+      _exit(0);  // exit without unpinning or detaching
+    }
+    waitpid(child, nullptr, 0);
+
+    try {
+      pool1.flushFile(file1);
+      PRINT_ERROR(
+          "ERROR :: Page pinned by another client. Exception should have been "
+          "thrown before execution reaches this point.");
+    } catch (const PagePinnedException &e) {
+    }
+    if (pool1.reapDeadClients() != 1) {
+      PRINT_ERROR("ERROR :: Dead shared pool client was not reaped.");
+    }
+    pool1.flushFile(file1);
+  }
+  SharedBufMgr::destroy(poolName);
+
+  bufMgr->readPage(file1, pid[1], page);
+  if (page->getRecord(rid2) != "test.8 shared record") {
+    PRINT_ERROR("ERROR :: Shared pool did not write back the dirty page.");
+  }
+  bufMgr->unPinPage(file1, pid[1], false);
+  bufMgr->flushFile(file1);
+
+  std::cout << "Test 8 passed"
+            << "\n";
+}
+
+void test9(File &file1) {
+  // Shrinking the pool keeps pinned pages in place and releases their frames
+  // once they are unpinned
+  Page *pinned[20];
+  for (i = 0; i < 20; i++) {
+    bufMgr->readPage(file1, i + 1, pinned[i]);
+  }
+
+  bufMgr->resize(5);
+  if (bufMgr->getNumBufs() != 5 || bufMgr->getPoolSize() < 20) {
+    PRINT_ERROR("ERROR :: Shrinking the pool released pinned frames.");
+  }
+  for (i = 0; i < 20; i++) {
+    if (pinned[i]->page_number() != i + 1) {
+      PRINT_ERROR("ERROR :: Pinned page moved while the pool was shrunk.");
+    }
+  }
+
+  for (i = 0; i < 20; i++) {
+    bufMgr->unPinPage(file1, i + 1, false);
+  }
+  if (bufMgr->getPoolSize() != 5) {
+    PRINT_ERROR("ERROR :: Unpinned frames were not released after a shrink.");
+  }
+
+  bufMgr->requestResize(num);
+  bufMgr->readPage(file1, 1, page);
+  bufMgr->unPinPage(file1, 1, false);
+  if (bufMgr->getPoolSize() != num) {
+    PRINT_ERROR("ERROR :: Requested resize was not applied.");
+  }
+  bufMgr->flushFile(file1);
+
+  std::cout << "Test 9 passed"
+            << "\n";
+}
+
+int countResidentPages(const std::string &dumpName) {
+  bufMgr->dumpResidentPages(dumpName);
+  std::ifstream dump(dumpName);
+  std::string line;
+  int pages = 0;
+  while (std::getline(dump, line)) {
+    if (!line.empty() && line[0] != '#') pages++;
+  }
+  return pages;
+}
+
+void test10(File &file1) {
+  // Pages dumped before a flush are brought back by a background load
+  const std::string dumpName = "test.dump";
+  for (i = 1; i <= 30; i++) {
+    bufMgr->readPage(file1, i, page);
+    bufMgr->unPinPage(file1, i, false);
+  }
+  bufMgr->dumpResidentPages(dumpName);
+  bufMgr->flushFile(file1);
+  if (countResidentPages(dumpName + ".check") != 0) {
+    PRINT_ERROR("ERROR :: Flushed pages are still resident.");
+  }
+
+  bufMgr->loadResidentPages(dumpName);
+  for (int tries = 0; bufMgr->isLoadingResidentPages() && tries < 1000;
+       tries++) {
+    bufMgr->pollResidentPageLoad();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  if (bufMgr->isLoadingResidentPages() ||
+      countResidentPages(dumpName + ".check") != 30) {
+    PRINT_ERROR("ERROR :: Dumped pages were not loaded back.");
+  }
+
+  bufMgr->readPage(file1, 7, page);
+  if (page->page_number() != 7) {
+    PRINT_ERROR("ERROR :: Warmed-up frame holds the wrong page.");
+  }
+  bufMgr->unPinPage(file1, 7, false);
+  bufMgr->flushFile(file1);
+  std::remove(dumpName.c_str());
+  std::remove((dumpName + ".check").c_str());
+
+  std::cout << "Test 10 passed"
+            << "\n";
+}
+
+void test11(File &file1) {
+  // A committed change that never reached the data file is redone from the
+  // write-ahead log
+  const std::string logName = "test.log";
+  std::remove(logName.c_str());
+  {
+    LogManager log(logName);
+    bufMgr->setLogManager(&log);
+    bufMgr->readPage(file1, pid[2], page);
+    rid2 = page->insertRecord("test.11 logged record");
+    bufMgr->unPinPage(file1, pid[2], true);
+    log.commit();
+
+    // The page is still only dirty in the pool
+    Page onDisk = file1.readPage(pid[2]);
+    if (onDisk.page_lsn() >= page->page_lsn()) {
+      PRINT_ERROR("ERROR :: Page was written back at commit.");
+    }
+
+    // Replaying the log as after a crash brings the page on disk up to date
+    LogManager restarted(logName);
+    if (restarted.recover() != 1) {
+      PRINT_ERROR("ERROR :: Logged page was not redone.");
+    }
+    onDisk = file1.readPage(pid[2]);
+    if (onDisk.getRecord(rid2) != "test.11 logged record") {
+      PRINT_ERROR("ERROR :: Redone page does not hold the logged record.");
+    }
+
+    bufMgr->flushFile(file1);
+    bufMgr->setLogManager(nullptr);
+  }
+  std::remove(logName.c_str());
+
+  std::cout << "Test 11 passed"
+            << "\n";
+}
+
+void test12(File &file1) {
+  // A fuzzy checkpoint writes out the pages dirty when it began, even if
+  // they are pinned, so recovery only redoes changes made after it
+  const std::string logName = "test.log";
+  std::remove(logName.c_str());
+  {
+    LogManager log(logName);
+    bufMgr->setLogManager(&log);
+    for (int i = 0; i < 4; i++) {
+      bufMgr->readPage(file1, pid[i], page);
+      page->insertRecord("test.12 before checkpoint");
+      bufMgr->unPinPage(file1, pid[i], true);
+    }
+    bufMgr->readPage(file1, pid[0], page);
+
+    if (bufMgr->getDirtyPageTable().size() != 4) {
+      PRINT_ERROR("ERROR :: Dirty page table does not list the dirty pages.");
+    }
+    if (bufMgr->beginCheckpoint() != 4) {
+      PRINT_ERROR("ERROR :: Checkpoint does not cover the dirty pages.");
+    }
+    while (bufMgr->checkpointStep(1) > 0) {
+    }
+    if (bufMgr->isCheckpointing() || !bufMgr->getDirtyPageTable().empty()) {
+      PRINT_ERROR("ERROR :: Checkpoint left dirty pages behind.");
+    }
+    bufMgr->unPinPage(file1, pid[0], false);
+
+    // Only the change made after the checkpoint needs redoing
+    bufMgr->readPage(file1, pid[1], page);
+    rid2 = page->insertRecord("test.12 after checkpoint");
+    bufMgr->unPinPage(file1, pid[1], true);
+    log.commit();
+
+    LogManager restarted(logName);
+    if (restarted.recover() != 1) {
+      PRINT_ERROR("ERROR :: Recovery did not start at the checkpoint.");
+    }
+    if (file1.readPage(pid[1]).getRecord(rid2) != "test.12 after checkpoint") {
+      PRINT_ERROR("ERROR :: Change after the checkpoint was not redone.");
+    }
+
+    bufMgr->flushFile(file1);
+    bufMgr->setLogManager(nullptr);
+  }
+  std::remove(logName.c_str());
+
+  std::cout << "Test 12 passed"
+            << "\n";
+}
+
+void test13(File &file1) {
+  // A page corrupted on disk is caught by its checksum when read back
+  if (badgerdb::crc32c("123456789", 9) != 0xE3069283u) {
+    PRINT_ERROR("ERROR :: CRC32C of the check string is wrong.");
+  }
+
+  {
+    std::fstream raw(file1.filename(),
+                     std::ios::in | std::ios::out | std::ios::binary);
+    raw.seekp(sizeof(FileHeader) + (pid[3] - 1) * Page::SIZE + Page::SIZE / 2);
+    raw.put('\x5a');
+  }
+
+  bufMgr->clearBufStats();
+  try {
+    bufMgr->readPage(file1, pid[3], page);
+    PRINT_ERROR("ERROR :: Corrupt page was read without complaint.");
+  } catch (const ChecksumMismatchException &e) {
+  }
+  if (bufMgr->getBufStats().checksumFailures != 1) {
+    PRINT_ERROR("ERROR :: Checksum failure was not counted.");
+  }
+
+  // With verification off the page reads as it is, and writing it back
+  // stores a fresh checksum
+  File::setVerifyChecksums(false);
+  Page corrupt = file1.readPage(pid[3]);
+  File::setVerifyChecksums(true);
+  file1.writePage(corrupt);
+  bufMgr->readPage(file1, pid[3], page);
+  bufMgr->unPinPage(file1, pid[3], false);
+  bufMgr->flushFile(file1);
+
+  std::cout << "Test 13 passed"
+            << "\n";
+}
+
+void test14(File &file1) {
+  // Pages flushed through the double-write buffer survive a torn write
+  const std::string dwbName = "test.dwb";
+  std::remove(dwbName.c_str());
+  {
+    DoublewriteBuffer doublewrite(dwbName);
+    bufMgr->setDoublewriteBuffer(&doublewrite);
+    for (int i = 0; i < 3; i++) {
+      bufMgr->readPage(file1, pid[i], page);
+      rid[i] = page->insertRecord("test.14 double-written");
+      bufMgr->unPinPage(file1, pid[i], true);
+    }
+    bufMgr->flushFile(file1);
+    bufMgr->setDoublewriteBuffer(nullptr);
+
+    // Tear the second page as a crash halfway through its write would
+    {
+      std::fstream raw(file1.filename(),
+                       std::ios::in | std::ios::out | std::ios::binary);
+      raw.seekp(sizeof(FileHeader) + (pid[1] - 1) * Page::SIZE + Page::SIZE / 2);
+      const std::string zeros(Page::SIZE / 2, '\0');
+      raw.write(zeros.data(), zeros.size());
+    }
+
+    if (doublewrite.recover() != 1) {
+      PRINT_ERROR("ERROR :: Torn page was not repaired.");
+    }
+    if (file1.readPage(pid[1]).getRecord(rid[1]) != "test.14 double-written") {
+      PRINT_ERROR("ERROR :: Repaired page does not hold its record.");
+    }
+  }
+  std::remove(dwbName.c_str());
+
+  std::cout << "Test 14 passed"
+            << "\n";
+}
+
+void test15() {
+  // Pages of a compressed file take a fraction of the space on disk and read
+  // back unchanged, including after being rewritten larger
+  const std::string compressedName = "test.z";
+  std::remove(compressedName.c_str());
+  std::remove((compressedName + ".pmap").c_str());
+  const int pages = 20;
+  PageId zpid[pages];
+  RecordId zrid[pages];
+  {
+    File zfile = File::createCompressed(compressedName);
+    for (int i = 0; i < pages; i++) {
+      bufMgr->allocPage(zfile, zpid[i], page);
+      for (int r = 0; r < 50; r++) {
+        zrid[i] = page->insertRecord("test.15 compressible record text " +
+                                     std::to_string(i));
+      }
+      bufMgr->unPinPage(zfile, zpid[i], true);
+    }
+    bufMgr->flushFile(zfile);
+
+    bufMgr->readPage(zfile, zpid[3], page);
+    for (int r = 0; r < 100; r++) {
+      page->insertRecord(std::to_string(r * 7919) + " grows the page");
+    }
+    bufMgr->unPinPage(zfile, zpid[3], true);
+    bufMgr->flushFile(zfile);
+  }
+
+  {
+    std::ifstream onDisk(compressedName, std::ios::binary | std::ios::ate);
+    if (onDisk.tellg() > static_cast<std::streamoff>(pages * Page::SIZE / 2)) {
+      PRINT_ERROR("ERROR :: Compressed file is not smaller.");
+    }
+  }
+
+  {
+    File zfile = File::open(compressedName);
+    if (!zfile.isCompressed()) {
+      PRINT_ERROR("ERROR :: Reopened file is not compressed.");
+    }
+    for (int i = 0; i < pages; i++) {
+      bufMgr->readPage(zfile, zpid[i], page);
+      if (page->getRecord(zrid[i]) !=
+          "test.15 compressible record text " + std::to_string(i)) {
+        PRINT_ERROR("ERROR :: Compressed page did not read back.");
+      }
+      bufMgr->unPinPage(zfile, zpid[i], false);
+    }
+    bufMgr->flushFile(zfile);
+  }
+  File::remove(compressedName);
+
+  std::cout << "Test 15 passed"
+            << "\n";
+}
+
+void test16(File &file1) {
+  // Pages evicted from a small pool come back from the compressed victim
+  // tier instead of the file
+  VictimCache victims(64 * 1024);
+  {
+    BufMgr smallPool(4);
+    smallPool.setVictimCache(&victims);
+    for (int i = 0; i < 8; i++) {
+      smallPool.readPage(file1, pid[i], page);
+      smallPool.unPinPage(file1, pid[i], false);
+    }
+    if (victims.getPageCount() != 4 || victims.getBytes() > 4 * Page::SIZE) {
+      PRINT_ERROR("ERROR :: Evicted pages were not kept compressed.");
+    }
+
+    smallPool.readPage(file1, pid[0], page);
+    if (victims.getHits() != 1 ||
+        page->getRecord(rid[0]) != "test.14 double-written") {
+      PRINT_ERROR("ERROR :: Evicted page did not come back from the tier.");
+    }
+    smallPool.unPinPage(file1, pid[0], false);
+
+    smallPool.flushFile(file1);
+    if (victims.getPageCount() != 0) {
+      PRINT_ERROR("ERROR :: Flushed file left pages in the tier.");
+    }
+  }
+
+  std::cout << "Test 16 passed"
+            << "\n";
+}
+
+void test17(File &file1) {
+  // Pages evicted from a small pool are written to the flash cache in the
+  // background and read back from there
+  const std::string cacheName = "test.flash";
+  {
+    FlashCache flash(cacheName, 16);
+    BufMgr smallPool(4);
+    smallPool.setFlashCache(&flash);
+    for (int i = 0; i < 8; i++) {
+      smallPool.readPage(file1, pid[i], page);
+      smallPool.unPinPage(file1, pid[i], false);
+    }
+    flash.drain();
+    if (flash.getPageCount() != 4) {
+      PRINT_ERROR("ERROR :: Evicted pages were not written to flash.");
+    }
+
+    smallPool.readPage(file1, pid[1], page);
+    if (flash.getHits() != 1 ||
+        page->getRecord(rid[1]) != "test.14 double-written") {
+      PRINT_ERROR("ERROR :: Page did not come back from flash.");
+    }
+
+    // Writing the page back makes the flash copy stale
+    page->insertRecord("test.17 newer than flash");
+    smallPool.unPinPage(file1, pid[1], true);
+    smallPool.flushFile(file1);
+    if (flash.getPageCount() != 0) {
+      PRINT_ERROR("ERROR :: Stale pages were left in flash.");
+    }
+  }
+  std::remove(cacheName.c_str());
+
+  std::cout << "Test 17 passed"
+            << "\n";
+}
+
+void test18(File &file1) {
+  // A scan through a small pool with the admission filter enabled goes
+  // through the bypass frame and leaves the frequently read pages resident
+  const std::string dumpName = "test.admission";
+  {
+    BufMgr smallPool(8);
+    smallPool.setAdmissionFilter(true);
+    for (int round = 0; round < 4; round++) {
+      for (int j = 0; j < 6; j++) {
+        smallPool.readPage(file1, pid[j], page);
+        smallPool.unPinPage(file1, pid[j], false);
+      }
+    }
+    for (int j = 20; j < 60; j++) {
+      smallPool.readPage(file1, pid[j], page);
+      sprintf(tmpbuf, "test.1 Page %u %7.1f", pid[j], (float)pid[j]);
+      if (strncmp(page->getRecord(rid[j]).c_str(), tmpbuf, strlen(tmpbuf)) !=
+          0) {
+        PRINT_ERROR("ERROR :: Bypassed page has the wrong contents.");
+      }
+      smallPool.unPinPage(file1, pid[j], false);
+    }
+    if (smallPool.getBufStats().bypassed < 30) {
+      PRINT_ERROR("ERROR :: Scanned pages were not turned away.");
+    }
+
+    smallPool.dumpResidentPages(dumpName);
+    std::ifstream dump(dumpName);
+    std::string line;
+    int hot = 0;
+    while (std::getline(dump, line)) {
+      if (line.empty() || line[0] == '#') continue;
+      const PageId pageNo = std::stoul(line);
+      for (int j = 0; j < 6; j++) {
+        if (pageNo == pid[j]) hot++;
+      }
+    }
+    if (hot != 6) {
+      PRINT_ERROR("ERROR :: The scan evicted frequently read pages.");
+    }
+  }
+  std::remove(dumpName.c_str());
+
+  std::cout << "Test 18 passed"
+            << "\n";
+}
+
+void test19(File &file1) {
+  // With a clean-first window, a miss evicts the clean page rather than the
+  // dirty ones the clock reaches first
+  {
+    BufMgr smallPool(4);
+    smallPool.setCleanFirstWindow(4);
+    for (int j = 0; j < 4; j++) {
+      smallPool.readPage(file1, pid[j], page);
+      smallPool.unPinPage(file1, pid[j], j < 3);
+    }
+    smallPool.readPage(file1, pid[4], page);
+    smallPool.unPinPage(file1, pid[4], false);
+    if (smallPool.getDirtyPageTable().size() != 3) {
+      PRINT_ERROR("ERROR :: A dirty page was evicted before a clean one.");
+    }
+
+    // Without clean pages in the window the dirty victim is written back
+    smallPool.setCleanFirstWindow(1);
+    smallPool.readPage(file1, pid[5], page);
+    smallPool.unPinPage(file1, pid[5], false);
+    if (smallPool.getDirtyPageTable().size() != 2) {
+      PRINT_ERROR("ERROR :: The dirty victim was not evicted.");
+    }
+    smallPool.flushFile(file1);
+  }
+
+  std::cout << "Test 19 passed"
+            << "\n";
+}
+
+void test20(File &file1) {
+  // A bulk load is held to its group's quota and cannot take the frames
+  // reserved for another file
+  const std::string scanName = "test.scan";
+  try {
+    File::remove(scanName);
+  } catch (const FileNotFoundException &) {
+  }
+  {
+    File scanFile = File::create(scanName);
+    BufMgr smallPool(6);
+    smallPool.setFrameQuota(file1.filename(), 2, 0);
+    smallPool.setFrameQuota("bulk", 0, 3);
+    smallPool.setFileGroup(scanName, "bulk");
+    for (int j = 0; j < 2; j++) {
+      smallPool.readPage(file1, pid[j], page);
+      smallPool.unPinPage(file1, pid[j], false);
+    }
+
+    PageId scanPage;
+    for (int j = 0; j < 10; j++) {
+      smallPool.allocPage(scanFile, scanPage, page);
+      smallPool.unPinPage(scanFile, scanPage, true);
+    }
+    std::map<std::string, GroupOccupancy> occupancy =
+        smallPool.getGroupOccupancy();
+    if (occupancy["bulk"].frames != 3 || occupancy["bulk"].quota != 3 ||
+        occupancy[file1.filename()].frames != 2) {
+      PRINT_ERROR("ERROR :: Group exceeded its frame quota.");
+    }
+
+    // Without a quota the load takes every frame but the reserved ones
+    smallPool.clearFrameQuota("bulk");
+    for (int j = 0; j < 10; j++) {
+      smallPool.allocPage(scanFile, scanPage, page);
+      smallPool.unPinPage(scanFile, scanPage, true);
+    }
+    occupancy = smallPool.getGroupOccupancy();
+    if (occupancy["bulk"].frames != 4 ||
+        occupancy[file1.filename()].frames != 2) {
+      PRINT_ERROR("ERROR :: Reserved frames were taken by another group.");
+    }
+    smallPool.flushFile(scanFile);
+  }
+  File::remove(scanName);
+
+  std::cout << "Test 20 passed"
+            << "\n";
+}
+
+void test21(File &file1) {
+  // Hits, misses, evictions and write-backs are counted, and snapshots can
+  // be subtracted
+  {
+    BufMgr smallPool(2);
+    for (int j = 0; j < 2; j++) {
+      smallPool.readPage(file1, pid[j], page);
+      smallPool.unPinPage(file1, pid[j], true);
+    }
+    const BufStats before = smallPool.getBufStats();
+    smallPool.readPage(file1, pid[0], page);
+    smallPool.unPinPage(file1, pid[0], false);
+    smallPool.readPage(file1, pid[2], page);
+
+    const BufStats diff = smallPool.getBufStats() - before;
+    if (diff.accesses != 2 || diff.hits != 1 || diff.misses != 1 ||
+        diff.diskreads != 1 || diff.dirtyEvictions != 1 ||
+        diff.cleanEvictions != 0 || diff.diskwrites != 1 ||
+        diff.allocations != 1 || diff.clockSteps < 2) {
+      PRINT_ERROR("ERROR :: Buffer statistics are wrong.");
+    }
+
+    // With every frame pinned the clock waits on each and fails
+    smallPool.readPage(file1, pid[1], page);
+    try {
+      smallPool.readPage(file1, pid[3], page);
+      PRINT_ERROR("ERROR :: Allocation succeeded with every frame pinned.");
+    } catch (const BufferExceededException &) {
+    }
+    const BufStats stats = smallPool.getBufStats();
+    if (stats.allocFailures != 1 || stats.pinWaits < 4 ||
+        stats.hitRatio() <= 0.0) {
+      PRINT_ERROR("ERROR :: Failed allocation was not counted.");
+    }
+    smallPool.unPinPage(file1, pid[1], false);
+    smallPool.unPinPage(file1, pid[2], false);
+    smallPool.clearBufStats();
+    if (smallPool.getBufStats().accesses != 0) {
+      PRINT_ERROR("ERROR :: Statistics were not cleared.");
+    }
+    smallPool.flushFile(file1);
+  }
+
+  std::cout << "Test 21 passed"
+            << "\n";
+}
+
+void test22(File &file1) {
+  // Percentiles are accurate to a bucket, and buffer operations are timed
+  // only while recording is enabled
+  LatencyHistogram histogram;
+  for (std::uint64_t v = 1; v <= 1000; v++) histogram.record(v * 1000);
+  const std::uint64_t p50 = histogram.percentile(50);
+  if (histogram.count() != 1000 || p50 < 500000 || p50 > 500000 * 1.04 ||
+      histogram.max() != 1000000 || histogram.percentile(100) != 1000000) {
+    PRINT_ERROR("ERROR :: Histogram percentiles are wrong.");
+  }
+
+  LatencyMetrics::reset();
+  bufMgr->readPage(file1, pid[0], page);
+  bufMgr->unPinPage(file1, pid[0], false);
+  if (LatencyMetrics::histogram(LatencyOp::UNPIN).count() != 0) {
+    PRINT_ERROR("ERROR :: Latency was recorded while disabled.");
+  }
+  LatencyMetrics::setEnabled(true);
+  bufMgr->readPage(file1, pid[0], page);
+  bufMgr->unPinPage(file1, pid[0], false);
+  bufMgr->flushFile(file1);
+  bufMgr->readPage(file1, pid[0], page);
+  bufMgr->unPinPage(file1, pid[0], false);
+  LatencyMetrics::setEnabled(false);
+  bufMgr->flushFile(file1);
+  if (LatencyMetrics::histogram(LatencyOp::READ_HIT).count() != 1 ||
+      LatencyMetrics::histogram(LatencyOp::READ_MISS).count() != 1 ||
+      LatencyMetrics::histogram(LatencyOp::FILE_READ).count() != 1 ||
+      LatencyMetrics::histogram(LatencyOp::UNPIN).count() != 2) {
+    PRINT_ERROR("ERROR :: Buffer operations were not timed.");
+  }
+  if (LatencyMetrics::toText().find("readPage.miss count=1 ") ==
+          std::string::npos ||
+      LatencyMetrics::toJson().find("\"readPage.hit\":{\"count\":1,") ==
+          std::string::npos) {
+    PRINT_ERROR("ERROR :: Latencies were not exported.");
+  }
+  LatencyMetrics::reset();
+
+  std::cout << "Test 22 passed"
+            << "\n";
+}
+
+void test23(File &file1) {
+  // Occupancy is tracked without scanning the pool, and the sampler writes
+  // it to a rotating log and a Prometheus textfile
+  const std::string logName = "test.metrics";
+  const std::string promName = "test.prom";
+  {
+    BufMgr smallPool(4);
+    smallPool.readPage(file1, pid[0], page);
+    smallPool.readPage(file1, pid[1], page);
+    smallPool.unPinPage(file1, pid[1], true);
+    smallPool.readPage(file1, pid[2], page);
+    smallPool.unPinPage(file1, pid[2], false);
+    MetricsSample sample = smallPool.sampleMetrics();
+    if (sample.frames != 4 || sample.validFrames != 3 ||
+        sample.dirtyFrames != 1 || sample.pinnedFrames != 1 ||
+        sample.misses != 3) {
+      PRINT_ERROR("ERROR :: Pool occupancy gauges are wrong.");
+    }
+
+    MetricsSamplerOptions options;
+    options.intervalMs = 1;
+    options.path = logName;
+    options.format = MetricsSamplerOptions::JSON_LINES;
+    options.maxFileBytes = 1024;
+    options.keepFiles = 1;
+    options.prometheusPath = promName;
+    smallPool.startMetricsSampler(options);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    smallPool.stopMetricsSampler();
+
+    std::ifstream prom(promName);
+    std::string text((std::istreambuf_iterator<char>(prom)),
+                     std::istreambuf_iterator<char>());
+    if (text.find("badgerdb_buffer_frames{state=\"dirty\"} 1\n") ==
+        std::string::npos) {
+      PRINT_ERROR("ERROR :: Prometheus textfile is wrong.");
+    }
+    std::ifstream log(logName);
+    std::ifstream rotated(logName + ".1");
+    std::string line;
+    if (!std::getline(log, line) || line.find("\"valid\":3,") ==
+                                         std::string::npos ||
+        !rotated) {
+      PRINT_ERROR("ERROR :: Metrics log was not written and rotated.");
+    }
+
+    smallPool.unPinPage(file1, pid[0], false);
+    smallPool.flushFile(file1);
+    sample = smallPool.sampleMetrics();
+    if (sample.validFrames != 0 || sample.dirtyFrames != 0 ||
+        sample.pinnedFrames != 0) {
+      PRINT_ERROR("ERROR :: Flushed frames are still counted.");
+    }
+  }
+  std::remove(logName.c_str());
+  std::remove((logName + ".1").c_str());
+  std::remove(promName.c_str());
+
+  // Counters cleared between two samples count as restarted from zero
+  // rather than as a huge rate
+  {
+    std::atomic<int> calls(0);
+    MetricsSamplerOptions options;
+    options.intervalMs = 1;
+    options.path = logName;
+    options.format = MetricsSamplerOptions::JSON_LINES;
+    {
+      MetricsSampler sampler(options, [&calls]() {
+        MetricsSample sample = MetricsSample();
+        sample.hits = sample.diskreads = calls++ == 0 ? 1000000 : 1;
+        return sample;
+      });
+      while (sampler.getSampleCount() < 3) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+    std::ifstream log(logName);
+    std::string line;
+    while (std::getline(log, line)) {
+      const std::size_t rate = line.find("\"reads_per_s\":");
+      if (rate == std::string::npos ||
+          std::stod(line.substr(rate + 14)) > 1e12) {
+        PRINT_ERROR("ERROR :: Reset counters gave a bogus rate.");
+      }
+    }
+  }
+  std::remove(logName.c_str());
+
+  std::cout << "Test 23 passed"
+            << "\n";
+}
+
+void test24() {
+  // File I/O is counted per file, separating metadata reads from data pages
+  const std::string fileName = "test.io";
+  try {
+    File::remove(fileName);
+  } catch (const FileNotFoundException &) {
+  }
+  {
+    File file = File::create(fileName);
+    for (int j = 0; j < 4; j++) file.allocatePage();
+
+    const FileIoStats before = file.ioStats();
+    if (before.headerWrites != 5 || before.pageWrites < 4 ||
+        before.bytesWritten < 4 * Page::SIZE) {
+      PRINT_ERROR("ERROR :: Allocation writes were not counted.");
+    }
+
+    // Appending a page walks the whole used list to find its tail: each of
+    // the 4 pages is read, the tail twice, and followed to the next but the
+    // tail
+    file.allocatePage();
+    FileIoStats diff = file.ioStats() - before;
+    if (diff.listWalkReads != 8 || diff.headerReads < 2 ||
+        diff.metadataReads() <= diff.listWalkReads) {
+      PRINT_ERROR("ERROR :: List walk reads were not counted.");
+    }
+
+    const FileIoStats beforeRead = file.ioStats();
+    file.readPage(2);
+    diff = file.ioStats() - beforeRead;
+    if (diff.pageReads != 1 || diff.headerReads != 1 ||
+        diff.bytesRead != Page::SIZE + sizeof(FileHeader) ||
+        diff.syscalls() != 2 + 3) {
+      PRINT_ERROR("ERROR :: Page read I/O was counted wrong.");
+    }
+  }
+
+  // Totals survive closing the file, and are part of the global totals
+  const FileIoStats closed = File::ioStats(fileName);
+  if (closed.pageReads == 0 || File::allIoStats().count(fileName) != 1 ||
+      File::globalIoStats().pageReads < closed.pageReads) {
+    PRINT_ERROR("ERROR :: I/O totals were lost.");
+  }
+  File::resetIoStats();
+  if (File::ioStats(fileName).pageReads != 0) {
+    PRINT_ERROR("ERROR :: I/O counts were not reset.");
+  }
+  File::remove(fileName);
+
+  std::cout << "Test 24 passed"
+            << "\n";
+}
+
+void test25(File &file1) {
+  // Sampled access tracking finds the hot page and the hot page range
+  const std::string dumpName = "test.heat";
+  {
+    BufMgr smallPool(8);
+    smallPool.setAccessTracking(true, 1, 8, 2);
+    for (int round = 0; round < 40; round++) {
+      smallPool.readPage(file1, pid[1], page);
+      smallPool.unPinPage(file1, pid[1], false);
+      smallPool.readPage(file1, pid[20 + round], page);
+      smallPool.unPinPage(file1, pid[20 + round], false);
+    }
+    const AccessHeatmap *heat = smallPool.getAccessHeatmap();
+    const std::vector<AccessHeatmap::HotPage> top = heat->topPages();
+    if (top.empty() || top[0].pageNo != pid[1] || top[0].count != 40) {
+      PRINT_ERROR("ERROR :: The hottest page was not found.");
+    }
+    AccessHeatmap::FileHeat fileHeat = heat->files()[file1.filename()];
+    if (fileHeat.hits + fileHeat.misses != 80 ||
+        fileHeat.buckets[pid[1] / 8] < 40) {
+      PRINT_ERROR("ERROR :: Per-file heat is wrong.");
+    }
+
+    heat->dump(dumpName);
+    std::ifstream dump(dumpName);
+    std::string line;
+    int tops = 0;
+    while (std::getline(dump, line)) {
+      if (line.compare(0, 4, "top\t") == 0) tops++;
+    }
+    if (tops != 2) {
+      PRINT_ERROR("ERROR :: Heatmap dump is wrong.");
+    }
+    smallPool.flushFile(file1);
+  }
+  std::remove(dumpName.c_str());
+
+  // A page far into a file only adds the range it falls in
+  AccessHeatmap far(1, 1, 4);
+  far.record(file1.filename(), 0xfffffff0, false);
+  const std::map<std::string, AccessHeatmap::FileHeat> farHeat = far.files();
+  if (farHeat.at(file1.filename()).buckets.size() != 1) {
+    PRINT_ERROR("ERROR :: Heatmap allocated ranges that were not requested.");
+  }
+
+  std::cout << "Test 25 passed"
+            << "\n";
+}
+
+void test26(File &file1) {
+  // A trace records each request in order and reads back the same
+  const std::string traceName = "test.trace";
+  PageId newPageNo;
+  {
+    BufMgr smallPool(4);
+    smallPool.startAccessTrace(traceName, 64);
+    smallPool.readPage(file1, pid[1], page);
+    smallPool.unPinPage(file1, pid[1], false);
+    smallPool.readPage(file1, pid[1], page);
+    smallPool.unPinPage(file1, pid[1], true);
+    smallPool.allocPage(file1, newPageNo, page);
+    smallPool.unPinPage(file1, newPageNo, false);
+    smallPool.disposePage(file1, newPageNo);
+    smallPool.flushFile(file1);
+    smallPool.stopAccessTrace();
+    if (smallPool.getAccessTrace() != nullptr) {
+      PRINT_ERROR("ERROR :: Access trace did not stop.");
+    }
+  }
+
+  const TraceRecord::Op ops[] = {
+      TraceRecord::READ,  TraceRecord::UNPIN, TraceRecord::READ,
+      TraceRecord::UNPIN, TraceRecord::ALLOC, TraceRecord::UNPIN,
+      TraceRecord::DISPOSE, TraceRecord::FLUSH_FILE};
+  const PageId pages[] = {pid[1],    pid[1],    pid[1],    pid[1],
+                          newPageNo, newPageNo, newPageNo,
+                          Page::INVALID_NUMBER};
+  const std::uint8_t flags[] = {0, 0, TraceRecord::HIT, TraceRecord::DIRTY,
+                                0, 0, 0, 0};
+  AccessTraceReader reader(traceName);
+  TraceRecord record;
+  std::size_t count = 0;
+  std::uint64_t lastTimestamp = 0;
+  while (reader.good() && reader.next(record)) {
+    if (count < 8 && (record.op != ops[count] ||
+                      record.pageNo != pages[count] ||
+                      record.flags != flags[count] ||
+                      record.timestampNs < lastTimestamp ||
+                      reader.files().at(record.fileId) != file1.filename())) {
+      PRINT_ERROR("ERROR :: Access trace record is wrong.");
+    }
+    lastTimestamp = record.timestampNs;
+    count++;
+  }
+  if (count != 8) {
+    PRINT_ERROR("ERROR :: Access trace has the wrong number of records.");
+  }
+  std::remove(traceName.c_str());
+
+  std::cout << "Test 26 passed"
+            << "\n";
+}
+
+void test27(File &file1) {
+  // A loop over 20 pages hits in a pool of 20 frames and never in fewer
+  {
+    BufMgr smallPool(8);
+    smallPool.setMissRatioCurve(true, 64, 16);
+    for (int round = 0; round < 10; round++) {
+      for (int i = 1; i <= 20; i++) {
+        smallPool.readPage(file1, pid[i], page);
+        smallPool.unPinPage(file1, pid[i], false);
+      }
+    }
+    const MissRatioCurve *mrc = smallPool.getMissRatioCurve();
+    if (mrc->getSampledCount() != 200 || mrc->hitRatio(16) != 0.0 ||
+        std::abs(mrc->hitRatio(20) - 0.9) > 1e-9 ||
+        std::abs(mrc->hitRatio(64) - 0.9) > 1e-9) {
+      PRINT_ERROR("ERROR :: Miss ratio curve is wrong.");
+    }
+    const std::vector<MissRatioCurve::Point> curve = mrc->curve();
+    if (curve.size() != 16 || curve.back().frames != 64) {
+      PRINT_ERROR("ERROR :: Miss ratio curve has the wrong pool sizes.");
+    }
+    smallPool.flushFile(file1);
+  }
+
+  // Sampling a loop over 4000 pages with 256 tracked finds the knee to
+  // within the error of so small a sample
+  MissRatioCurve sampled(8000, 80, 256);
+  for (int round = 0; round < 5; round++) {
+    for (std::uint64_t key = 0; key < 4000; key++) sampled.record(key);
+  }
+  if (sampled.samplingRate() > 0.1 || sampled.hitRatio(3400) > 0.1 ||
+      sampled.hitRatio(4400) < 0.7) {
+    PRINT_ERROR("ERROR :: Sampled miss ratio curve is wrong.");
+  }
+
+  std::cout << "Test 27 passed"
+            << "\n";
+}
+
+void test28(File &file1) {
+  // Pins are profiled by tag, and a pin still held is listed as outstanding
+  {
+    BufMgr smallPool(4);
+    smallPool.setPinTracking(true);
+    const char *const scanTag = "scan";
+    for (int i = 1; i <= 3; i++) {
+      smallPool.readPage(file1, pid[i], page, scanTag);
+      smallPool.unPinPage(file1, pid[i], false);
+    }
+    smallPool.readPage(file1, pid[1], page, BADGERDB_HERE);
+    smallPool.readPage(file1, pid[1], page);
+    smallPool.unPinPage(file1, pid[1], false);
+
+    const PinTracker *pins = smallPool.getPinTracker();
+    const LatencyHistogram *scan = pins->histogram(scanTag);
+    const LatencyHistogram *untagged = pins->histogram(PinTracker::UNTAGGED);
+    if (scan == nullptr || scan->count() != 3 || untagged == nullptr ||
+        untagged->count() != 1 || pins->tags().size() != 2) {
+      PRINT_ERROR("ERROR :: Pin durations are not profiled by tag.");
+    }
+    const std::vector<PinTracker::OutstandingPin> held = pins->outstanding(0);
+    if (held.size() != 1 || held[0].pageNo != pid[1] ||
+        held[0].tag.find("main.cpp:") == std::string::npos ||
+        pins->toText(0).find("outstanding\t" + held[0].tag) ==
+            std::string::npos) {
+      PRINT_ERROR("ERROR :: Outstanding pin is not listed.");
+    }
+    smallPool.unPinPage(file1, pid[1], false);
+    if (!pins->outstanding(0).empty()) {
+      PRINT_ERROR("ERROR :: Released pin is still outstanding.");
+    }
+    smallPool.flushFile(file1);
+  }
+
+  std::cout << "Test 28 passed"
+            << "\n";
+}
+
+void test29(File &file1) {
+  // Work is attributed to the innermost open query scope only
+  QueryScope::resetTotals();
+  {
+    BufMgr smallPool(2);
+    {
+      QueryScope scan("scan");
+      for (int i = 1; i <= 3; i++) {
+        smallPool.readPage(file1, pid[i], page);
+        smallPool.unPinPage(file1, pid[i], true);
+      }
+      smallPool.readPage(file1, pid[3], page);
+      smallPool.unPinPage(file1, pid[3], false);
+      {
+        QueryScope lookup("lookup");
+        smallPool.readPage(file1, pid[3], page);
+        smallPool.unPinPage(file1, pid[3], false);
+        if (QueryScope::current() != &lookup.stats()) {
+          PRINT_ERROR("ERROR :: Inner query scope is not current.");
+        }
+      }
+      // the third read evicted the dirty first page
+      const QueryStats &stats = scan.stats();
+      if (stats.hits != 1 || stats.misses != 3 || stats.diskReads != 3 ||
+          stats.bytesRead != 3 * Page::SIZE || stats.dirtied != 3 ||
+          stats.writebacks != 1 || stats.bytesWritten != Page::SIZE) {
+        PRINT_ERROR("ERROR :: Query scope counts are wrong.");
+      }
+    }
+    smallPool.readPage(file1, pid[3], page);
+    smallPool.unPinPage(file1, pid[3], false);
+    smallPool.flushFile(file1);
+  }
+  if (QueryScope::current() != nullptr) {
+    PRINT_ERROR("ERROR :: Query scope was left open.");
+  }
+
+  const std::map<std::string, QueryStats> totals = QueryScope::totals();
+  if (totals.size() != 2 || totals.at("lookup").hits != 1 ||
+      totals.at("lookup").misses != 0 || totals.at("scan").hits != 1) {
+    PRINT_ERROR("ERROR :: Query totals are wrong.");
+  }
+  if (QueryScope::report().find("scan\tBuffers: hit=1 read=3 dirtied=3 "
+                                "written=1") == std::string::npos) {
+    PRINT_ERROR("ERROR :: Query report is wrong.");
+  }
+  QueryScope::resetTotals();
+
+  std::cout << "Test 29 passed"
+            << "\n";
+}
+
+void test30() {
+  // With no tracer attached, probes are off and measure no latency
+  if (BADGERDB_PROBE_ENABLED(read_miss) || BADGERDB_PROBE_ENABLED(writeback)) {
+    PRINT_ERROR("ERROR :: Probe is enabled without a tracer.");
+  }
+  const std::uint64_t start =
+      probeStart(BADGERDB_PROBE_ENABLED(read_hit));
+  if (start != 0 || probeElapsed(start) != 0) {
+    PRINT_ERROR("ERROR :: Disabled probe measured latency.");
+  }
+  BADGERDB_PROBE3(flush_file, "test", 0, probeElapsed(start));
+  if (probeElapsed(probeStart(true)) > 1000000000ull) {
+    PRINT_ERROR("ERROR :: Probe latency is wrong.");
+  }
+
+  std::cout << "Test 30 passed"
+            << "\n";
+}
+
+void test31(File &file1) {
+  // The controller shrinks the pool under pressure and grows it when relaxed
+  BufMgr smallPool(4);
+  double pressure = 0;
+  double usage = 0.5;
+  MemoryPressurePolicy policy(2, 64);
+  policy.growStep = 3.0;
+  policy.pressureReader = [&pressure](double &avg10) {
+    avg10 = pressure;
+    return true;
+  };
+  policy.usageReader = [&usage](double &used) {
+    used = usage;
+    return true;
+  };
+  MemoryPressureController controller(smallPool, policy);
+
+  for (int i = 1; i <= 3; i++) {
+    smallPool.readPage(file1, pid[i], page);
+    smallPool.unPinPage(file1, pid[i], false);
+  }
+  pressure = 20;
+  if (controller.poll() != 3) {
+    PRINT_ERROR("ERROR :: Pool was not shrunk under memory pressure.");
+  }
+  pressure = 0;
+  usage = 0.95;
+  if (controller.poll() != 2) {
+    PRINT_ERROR("ERROR :: Pool was not shrunk near the cgroup limit.");
+  }
+  usage = 0.5;
+  if (controller.poll() != 8 || controller.poll() != 32) {
+    PRINT_ERROR("ERROR :: Pool was not grown without memory pressure.");
+  }
+
+  // The resize is applied by the next unpin, growing the pool eightfold and
+  // the hash table with it; the pages still cached must still be found
+  smallPool.readPage(file1, pid[3], page);
+  smallPool.unPinPage(file1, pid[3], false);
+  if (smallPool.getNumBufs() != 32) {
+    PRINT_ERROR("ERROR :: Requested pool size was not applied.");
+  }
+  const std::uint64_t hits = smallPool.getBufStats().hits;
+  smallPool.readPage(file1, pid[2], page);
+  smallPool.unPinPage(file1, pid[2], false);
+  smallPool.readPage(file1, pid[3], page);
+  smallPool.unPinPage(file1, pid[3], false);
+  if (smallPool.getBufStats().hits != hits + 2) {
+    PRINT_ERROR("ERROR :: Cached pages were lost when the pool grew.");
+  }
+  for (int i = 4; i <= 30; i++) {
+    smallPool.readPage(file1, pid[i], page);
+    smallPool.unPinPage(file1, pid[i], false);
+  }
+  smallPool.readPage(file1, pid[4], page);
+  smallPool.unPinPage(file1, pid[4], false);
+  if (smallPool.getBufStats().hits != hits + 3) {
+    PRINT_ERROR("ERROR :: Grown pool does not hold its pages.");
+  }
+
+  // Usage is read from the process's own cgroup, not the root one
+  mkdir("test.cgroup", 0755);
+  mkdir("test.cgroup/app", 0755);
+  std::ofstream("test.cgroup/memory.current") << "900\n";
+  std::ofstream("test.cgroup/memory.max") << "1000\n";
+  std::ofstream("test.cgroup/app/memory.current") << "250\n";
+  std::ofstream("test.cgroup/app/memory.max") << "1000\n";
+  std::ofstream("test.cgroup.proc") << "0::/app\n";
+  double used = 0;
+  if (!MemoryPressureController::readCgroupUsage("test.cgroup",
+                                                 "test.cgroup.proc", used) ||
+      used != 0.25) {
+    PRINT_ERROR("ERROR :: Cgroup usage was not read from own cgroup.");
+  }
+  std::remove("test.cgroup.proc");
+  for (const char *path :
+       {"test.cgroup/app/memory.current", "test.cgroup/app/memory.max",
+        "test.cgroup/memory.current", "test.cgroup/memory.max"}) {
+    std::remove(path);
+  }
+  rmdir("test.cgroup/app");
+  rmdir("test.cgroup");
+
+  std::cout << "Test 31 passed"
+            << "\n";
+}
+
+void test32() {
+  // Redo keeps the page lists of the file as they are on disk: a neighbour
+  // deleted after a page was logged stays unlinked, and a page deleted after
+  // it was logged stays deleted
+  const std::string logName = "test.log";
+  const std::string filename = "test.32";
+  std::remove(logName.c_str());
+  try {
+    File::remove(filename);
+  } catch (const FileNotFoundException &) {
+  }
+  {
+    File file = File::create(filename);
+    BufMgr smallPool(8);
+    PageId pageNos[4];
+    for (int i = 0; i < 4; i++) {
+      smallPool.allocPage(file, pageNos[i], page);
+      smallPool.unPinPage(file, pageNos[i], true);
+    }
+    smallPool.flushFile(file);
+
+    LogManager log(logName);
+    smallPool.setLogManager(&log);
+    smallPool.readPage(file, pageNos[0], page);
+    rid2 = page->insertRecord("test.32 logged record");
+    smallPool.unPinPage(file, pageNos[0], true);
+    smallPool.readPage(file, pageNos[2], page);
+    page->insertRecord("test.32 deleted record");
+    smallPool.unPinPage(file, pageNos[2], true);
+    log.commit();
+    smallPool.disposePage(file, pageNos[1]);
+    smallPool.disposePage(file, pageNos[2]);
+
+    // Crash before the first page is written back
+    LogManager restarted(logName);
+    if (restarted.recover() != 1) {
+      PRINT_ERROR("ERROR :: Recovery redid a deleted page.");
+    }
+    if (file.readPage(pageNos[0]).getRecord(rid2) != "test.32 logged record") {
+      PRINT_ERROR("ERROR :: Logged page was not redone.");
+    }
+
+    std::vector<PageId> used;
+    for (FileIterator iter = file.begin(); iter != file.end(); ++iter) {
+      used.push_back((*iter).page_number());
+    }
+    if (used != std::vector<PageId>{pageNos[0], pageNos[3]}) {
+      PRINT_ERROR("ERROR :: Recovery relinked the used page list.");
+    }
+    try {
+      file.readPage(pageNos[2]);
+      PRINT_ERROR("ERROR :: Recovery brought back a deleted page.");
+    } catch (const InvalidPageException &) {
+    }
+
+    // The free list is walked by allocating from it, most recently freed
+    // first, then past the end of the file
+    std::vector<PageId> reused;
+    for (int i = 0; i < 3; i++) {
+      reused.push_back(file.allocatePage().page_number());
+    }
+    if (reused !=
+        std::vector<PageId>{pageNos[2], pageNos[1], PageId(pageNos[3] + 1)}) {
+      PRINT_ERROR("ERROR :: Recovery relinked the free page list.");
+    }
+    smallPool.setLogManager(nullptr);
+  }
+  File::remove(filename);
+  std::remove(logName.c_str());
+
+  std::cout << "Test 32 passed"
+            << "\n";
+}
+
+void test33(File &file1) {
+  // Checkpoints drop the log records before their redo LSN, so neither the
+  // log nor the scan for its end on restart grows with the changes made
+  const std::string logName = "test.log";
+  std::remove(logName.c_str());
+  {
+    LogManager log(logName);
+    bufMgr->setLogManager(&log);
+    off_t firstSize = 0;
+    Lsn firstScan = 0;
+    for (int round = 0; round < 10; round++) {
+      for (int i = 0; i < 4; i++) {
+        bufMgr->readPage(file1, pid[i], page);
+        page->insertRecord("test.33 record");
+        bufMgr->unPinPage(file1, pid[i], true);
+      }
+      log.commit();
+      bufMgr->checkpoint();
+
+      struct stat st;
+      stat(logName.c_str(), &st);
+      LogManager restarted(logName);
+      const Lsn scan = restarted.getEndLsn() - restarted.getRedoLsn();
+      if (restarted.getEndLsn() != log.getEndLsn()) {
+        PRINT_ERROR("ERROR :: Restarted log does not end where it was left.");
+      }
+      if (round == 0) {
+        firstSize = st.st_size;
+        firstScan = scan;
+      } else if (st.st_size != firstSize || scan != firstScan) {
+        PRINT_ERROR("ERROR :: Log grew across checkpoints.");
+      }
+    }
+    if (log.getEndLsn() < 40 * Page::SIZE ||
+        firstSize >= static_cast<off_t>(Page::SIZE)) {
+      PRINT_ERROR("ERROR :: Checkpoint did not drop the logged pages.");
+    }
+
+    // Records after the last checkpoint are still found and redone
+    bufMgr->readPage(file1, pid[1], page);
+    rid2 = page->insertRecord("test.33 after checkpoint");
+    bufMgr->unPinPage(file1, pid[1], true);
+    log.commit();
+    LogManager restarted(logName);
+    if (restarted.recover() != 1 ||
+        file1.readPage(pid[1]).getRecord(rid2) != "test.33 after checkpoint") {
+      PRINT_ERROR("ERROR :: Change after the checkpoint was not redone.");
+    }
+
+    bufMgr->flushFile(file1);
+    bufMgr->setLogManager(nullptr);
+  }
+  std::remove(logName.c_str());
+
+  std::cout << "Test 33 passed"
+            << "\n";
+}
+
+void test34(File &file1) {
+  // Shared pool clients see each other's changes in place, cannot dispose
+  // of pages pinned by others, and name files alike from any directory
+  const std::string poolName = "/badgerdb_test34";
+  SharedBufMgr::destroy(poolName);
+  {
+    SharedBufMgr pool1(poolName, 3);
+    SharedBufMgr pool2(poolName, 3);
+    pool1.readPage(file1, pid[1], page);
+    pool2.readPage(file1, pid[1], page2);
+    pool1.latchPage(file1, pid[1]);
+    rid2 = page->insertRecord("test.34 first writer");
+    pool1.unlatchPage(file1, pid[1]);
+    pool1.unPinPage(file1, pid[1], true);
+    pool2.latchPage(file1, pid[1]);
+    if (page2->getRecord(rid2) != "test.34 first writer") {
+      PRINT_ERROR("ERROR :: Client does not see another client's change.");
+    }
+    pool2.unlatchPage(file1, pid[1]);
+
+    try {
+      pool1.disposePage(file1, pid[1]);
+      PRINT_ERROR(
+          "ERROR :: Page pinned by another client. Exception should have been "
+          "thrown before execution reaches this point.");
+    } catch (const PagePinnedException &e) {
+    }
+    pool2.unPinPage(file1, pid[1], false);
+
+    // A client in another directory finds the page in the pool under the
+    // file's absolute path, and can write it back when it evicts it
+    char cwd[PATH_MAX];
+    const std::string path = std::string(getcwd(cwd, sizeof(cwd))) + "/" +
+                             file1.filename();
+    std::cout.flush();
+    const pid_t child = fork();
+    if (child == 0) {
+      int failed = chdir("/") != 0;
+      {
+        File file = File::open(path);
+        SharedBufMgr pool3(poolName, 3);
+        Page *shared;
+        pool3.readPage(file, pid[1], shared);
+        failed |= shared->getRecord(rid2) != "test.34 first writer";
+        pool3.unPinPage(file, pid[1], false);
+        for (int i = 2; i <= 5; i++) {
+          pool3.readPage(file, pid[i], shared);
+          pool3.unPinPage(file, pid[i], false);
+        }
+      }
+      _exit(failed);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      PRINT_ERROR("ERROR :: Client in another directory missed the page.");
+    }
+    if (file1.readPage(pid[1]).getRecord(rid2) != "test.34 first writer") {
+      PRINT_ERROR("ERROR :: Evicted page was not written back.");
+    }
+    pool1.flushFile(file1);
+
+    File compressed = File::createCompressed("test.34");
+    try {
+      pool1.allocPage(compressed, pageno1, page);
+      PRINT_ERROR(
+          "ERROR :: Compressed file shared. Exception should have been thrown "
+          "before execution reaches this point.");
+    } catch (const SharedPoolException &e) {
+    }
+  }
+  File::remove("test.34");
+  SharedBufMgr::destroy(poolName);
+
+  std::cout << "Test 34 passed"
+            << "\n";
+}
+
+std::uint32_t countMaterializedFrames(const BufMgr &mgr) {
+  std::uint32_t frames = 0;
+  for (FrameId f = 0; f < mgr.getPoolSize(); f++) {
+    if (mgr.isFrameMaterialized(f)) frames++;
+  }
+  return frames;
+}
+
+void test35(File &file1) {
+  // Frames hold no page until one is read or allocated into them, and give
+  // it back when the pool shrinks past them
+  BufMgr pool(10);
+  if (countMaterializedFrames(pool) != 0) {
+    PRINT_ERROR("ERROR :: Frames were materialized before they were used.");
+  }
+
+  pool.readPage(file1, pid[1], page);
+  if (countMaterializedFrames(pool) != 1) {
+    PRINT_ERROR("ERROR :: Reading a page materialized other frames.");
+  }
+  pool.allocPage(file1, pageno1, page2);
+  if (countMaterializedFrames(pool) != 2) {
+    PRINT_ERROR("ERROR :: Allocating a page materialized other frames.");
+  }
+  pool.unPinPage(file1, pid[1], false);
+  pool.unPinPage(file1, pageno1, true);
+
+  pool.resize(1);
+  if (pool.getPoolSize() != 1 || countMaterializedFrames(pool) > 1 ||
+      pool.isFrameMaterialized(1)) {
+    PRINT_ERROR("ERROR :: Shrinking the pool kept the removed frames.");
+  }
+  pool.disposePage(file1, pageno1);
+  pool.flushFile(file1);
+
+  std::cout << "Test 35 passed"
+            << "\n";
+}
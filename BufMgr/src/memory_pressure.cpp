@@ -0,0 +1,184 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "memory_pressure.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include "buffer.h"
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Reads a single unsigned number from a file.  Fails on "max", which cgroups
+ * use for an unlimited value.
+ */
+bool readNumber(const std::string &path, std::uint64_t &value) {
+  std::ifstream in(path);
+  std::string token;
+  if (!(in >> token) || token == "max") {
+    return false;
+  }
+  std::istringstream parse(token);
+  return static_cast<bool>(parse >> value);
+}
+
+/**
+ * Finds the process's cgroup in a membership file such as /proc/self/cgroup,
+ * whose lines read "id:controllers:path": the unified (v2) one, with id 0
+ * and no controllers, and the one of the v1 memory controller.  Either is
+ * left empty if not listed.
+ */
+void readCgroupMembership(const std::string &path, std::string &v2,
+                          std::string &v1) {
+  std::ifstream in(path);
+  std::string line;
+  while (std::getline(in, line)) {
+    const std::size_t first = line.find(':');
+    const std::size_t second = line.find(':', first + 1);
+    if (first == std::string::npos || second == std::string::npos) continue;
+    const std::string id = line.substr(0, first);
+    const std::string controllers = line.substr(first + 1, second - first - 1);
+    const std::string cgroup = line.substr(second + 1);
+    if (id == "0" && controllers.empty()) {
+      v2 = cgroup;
+      continue;
+    }
+    std::istringstream list(controllers);
+    std::string controller;
+    while (std::getline(list, controller, ',')) {
+      if (controller == "memory") v1 = cgroup;
+    }
+  }
+}
+
+}  // namespace
+
+MemoryPressureController::MemoryPressureController(
+    BufMgr &bufMgr, const MemoryPressurePolicy &policy)
+    : bufMgr_(bufMgr),
+      policy_(policy),
+      target_(bufMgr.getNumBufs()),
+      stopping_(false) {}
+
+MemoryPressureController::~MemoryPressureController() { stop(); }
+
+void MemoryPressureController::start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (thread_.joinable()) {
+    return;
+  }
+  stopping_ = false;
+  thread_ = std::thread(&MemoryPressureController::run, this);
+}
+
+void MemoryPressureController::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wakeup_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void MemoryPressureController::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopping_) {
+    lock.unlock();
+    poll();
+    lock.lock();
+    wakeup_.wait_for(lock, policy_.interval, [this] { return stopping_; });
+  }
+}
+
+std::uint32_t MemoryPressureController::poll() {
+  double avg10 = 0;
+  double usage = 0;
+  const bool havePressure = policy_.pressureReader
+                                ? policy_.pressureReader(avg10)
+                                : readPressure(policy_.psiPath, avg10);
+  const bool haveUsage =
+      policy_.usageReader
+          ? policy_.usageReader(usage)
+          : readCgroupUsage(policy_.cgroupPath, policy_.procCgroupPath, usage);
+  if (!havePressure && !haveUsage) {
+    return target_;
+  }
+
+  const bool squeezed = (havePressure && avg10 >= policy_.highPressure) ||
+                        (haveUsage && usage >= policy_.highUsage);
+  const bool relaxed = (!havePressure || avg10 <= policy_.lowPressure) &&
+                       (!haveUsage || usage <= policy_.lowUsage);
+
+  std::uint32_t target = target_;
+  if (squeezed) {
+    const std::uint32_t step =
+        std::max<std::uint32_t>(1, target * policy_.shrinkStep);
+    target = target > step ? target - step : 1;
+  } else if (relaxed) {
+    target += std::max<std::uint32_t>(1, target * policy_.growStep);
+  }
+  target = std::min(std::max(target, policy_.minBufs), policy_.maxBufs);
+
+  if (target != target_) {
+    target_ = target;
+    bufMgr_.requestResize(target_);
+  }
+  return target_;
+}
+
+bool MemoryPressureController::readPressure(const std::string &path,
+                                            double &avg10) {
+  // Format: "some avg10=0.00 avg60=0.00 avg300=0.00 total=0"
+  std::ifstream in(path);
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.compare(0, 5, "some ") != 0) continue;
+    const std::size_t pos = line.find("avg10=");
+    if (pos == std::string::npos) return false;
+    std::istringstream parse(line.substr(pos + 6));
+    return static_cast<bool>(parse >> avg10);
+  }
+  return false;
+}
+
+bool MemoryPressureController::readCgroupUsage(const std::string &root,
+                                               const std::string &procCgroup,
+                                               double &usage) {
+  // The files directly under root belong to the root cgroup, not to ours,
+  // unless we run in a cgroup namespace, where our cgroup reads as "/".
+  std::string v2 = "/";
+  std::string v1 = "/";
+  readCgroupMembership(procCgroup, v2, v1);
+  if (v2.back() != '/') v2 += '/';
+  if (v1.back() != '/') v1 += '/';
+
+  std::uint64_t current = 0;
+  std::uint64_t limit = 0;
+  // cgroup v2 first, then the v1 memory controller.
+  if (!(readNumber(root + v2 + "memory.current", current) &&
+        readNumber(root + v2 + "memory.max", limit)) &&
+      !(readNumber(root + "/memory" + v1 + "memory.usage_in_bytes", current) &&
+        readNumber(root + "/memory" + v1 + "memory.limit_in_bytes", limit))) {
+    return false;
+  }
+  // v1 reports an unlimited group as a huge page-aligned number.
+  if (limit == 0 || limit >= (std::uint64_t(1) << 62)) {
+    return false;
+  }
+  usage = static_cast<double>(current) / limit;
+  return true;
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,184 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace badgerdb {
+
+class BufMgr;
+
+/**
+ * @brief Thresholds and limits used by MemoryPressureController.
+ */
+struct MemoryPressurePolicy {
+  /**
+   * Smallest and largest pool size, in frames, the controller may pick.
+   */
+  std::uint32_t minBufs;
+  std::uint32_t maxBufs;
+
+  /**
+   * PSI "some avg10" percentage above which the pool shrinks and below which
+   * it may grow.
+   */
+  double highPressure;
+  double lowPressure;
+
+  /**
+   * Fraction of the cgroup memory limit in use above which the pool shrinks
+   * and below which it may grow.
+   */
+  double highUsage;
+  double lowUsage;
+
+  /**
+   * Fraction of the current pool size removed or added per adjustment.
+   */
+  double shrinkStep;
+  double growStep;
+
+  /**
+   * Time between two evaluations by the background thread.
+   */
+  std::chrono::milliseconds interval;
+
+  /**
+   * Pressure stall information file to read from, the mount point of the
+   * cgroup hierarchy, and the file naming the process's own cgroup below it.
+   */
+  std::string psiPath;
+  std::string cgroupPath;
+  std::string procCgroupPath;
+
+  /**
+   * When set, called instead of reading psiPath or the cgroup files; each
+   * returns false if it has no value.  Lets other sources be used and
+   * policies be tested.
+   */
+  std::function<bool(double &)> pressureReader;
+  std::function<bool(double &)> usageReader;
+
+  /**
+   * Constructs a policy with conservative defaults for the given bounds.
+   */
+  MemoryPressurePolicy(std::uint32_t minBufsIn, std::uint32_t maxBufsIn)
+      : minBufs(minBufsIn),
+        maxBufs(maxBufsIn),
+        highPressure(10.0),
+        lowPressure(1.0),
+        highUsage(0.90),
+        lowUsage(0.75),
+        shrinkStep(0.10),
+        growStep(0.05),
+        interval(1000),
+        psiPath("/proc/pressure/memory"),
+        cgroupPath("/sys/fs/cgroup"),
+        procCgroupPath("/proc/self/cgroup") {}
+};
+
+/**
+ * @brief Resizes a buffer pool according to the memory pressure of the host.
+ *
+ * Each evaluation reads the Linux pressure stall information for memory and
+ * the usage and limit of the process's memory cgroup (v2, or v1 as a
+ * fallback), as named by /proc/self/cgroup.  If
+ * either shows pressure the pool is shrunk by a step; if both show plenty of
+ * headroom it is grown by a step, always staying within the policy's bounds.
+ * Sources which are missing are ignored.
+ *
+ * The controller never touches the pool itself: it hands the new size to
+ * BufMgr::requestResize(), which the thread using the buffer manager applies.
+ */
+class MemoryPressureController {
+ public:
+  /**
+   * Constructs a controller for the given buffer manager.  Must be called on
+   * the thread that uses the buffer manager.
+   *
+   * @param bufMgr  Buffer manager whose pool is resized.
+   * @param policy  Thresholds and limits to apply.
+   */
+  MemoryPressureController(BufMgr &bufMgr, const MemoryPressurePolicy &policy);
+
+  /**
+   * Stops the background thread if it is running.
+   */
+  ~MemoryPressureController();
+
+  /**
+   * Starts evaluating the memory pressure every policy interval on a
+   * background thread.
+   */
+  void start();
+
+  /**
+   * Stops the background thread and waits for it to exit.
+   */
+  void stop();
+
+  /**
+   * Evaluates the memory pressure once and requests a new pool size if it
+   * should change.
+   *
+   * @return  Pool size the controller is now aiming for.
+   */
+  std::uint32_t poll();
+
+  /**
+   * Reads the "some avg10" value from a pressure stall information file.
+   *
+   * @param path    File to read, normally /proc/pressure/memory.
+   * @param avg10   Percentage of time stalled, returned by reference.
+   * @return  True if the file could be read.
+   */
+  static bool readPressure(const std::string &path, double &avg10);
+
+  /**
+   * Reads the fraction of the process's memory cgroup limit currently in
+   * use.  The cgroup is looked up in procCgroup, the v2 entry ("0::/path")
+   * first and then the v1 memory controller's, and found below root; if
+   * procCgroup cannot be read the root cgroup is used.
+   *
+   * @param root        Mount point of the cgroup hierarchy, normally
+   *                    /sys/fs/cgroup.
+   * @param procCgroup  Cgroup membership file, normally /proc/self/cgroup.
+   * @param usage       Used fraction of the limit, returned by reference.
+   * @return  True if both usage and a finite limit could be read.
+   */
+  static bool readCgroupUsage(const std::string &root,
+                              const std::string &procCgroup, double &usage);
+
+ private:
+  /**
+   * Body of the background thread.
+   */
+  void run();
+
+  BufMgr &bufMgr_;
+  const MemoryPressurePolicy policy_;
+
+  /**
+   * Pool size last requested.
+   */
+  std::uint32_t target_;
+
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable wakeup_;
+  bool stopping_;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,211 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "metrics_sampler.h"
+
+#include <chrono>
+#include <cstdio>
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Returns the change in a cumulative counter.  A counter which went down was
+ * reset in between, e.g. by BufMgr::clearBufStats(), and counted up from 0.
+ */
+std::uint64_t delta(std::uint64_t now, std::uint64_t before) {
+  return now < before ? now : now - before;
+}
+
+/**
+ * Returns the change in a cumulative counter per second.
+ */
+double perSecond(std::uint64_t now, std::uint64_t before, double seconds) {
+  return seconds > 0 ? delta(now, before) / seconds : 0.0;
+}
+
+}  // namespace
+
+MetricsSampler::MetricsSampler(const MetricsSamplerOptions &options,
+                               std::function<MetricsSample()> sample)
+    : options_(options),
+      sample_(std::move(sample)),
+      logBytes_(0),
+      havePrevious_(false),
+      stopping_(false),
+      samples_(0) {
+  if (options_.intervalMs == 0) options_.intervalMs = 1;
+  if (!options_.path.empty()) {
+    log_.open(options_.path, std::ios::app);
+    log_.seekp(0, std::ios::end);
+    logBytes_ = static_cast<std::uint64_t>(log_.tellp());
+  }
+  thread_ = std::thread(&MetricsSampler::run, this);
+}
+
+MetricsSampler::~MetricsSampler() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  thread_.join();
+}
+
+std::uint64_t MetricsSampler::getSampleCount() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return samples_;
+}
+
+void MetricsSampler::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopping_) {
+    wake_.wait_for(lock, std::chrono::milliseconds(options_.intervalMs));
+    lock.unlock();
+    sampleOnce();
+    lock.lock();
+    ++samples_;
+  }
+}
+
+void MetricsSampler::sampleOnce() {
+  MetricsSample sample = sample_();
+  const std::chrono::steady_clock::time_point now =
+      std::chrono::steady_clock::now();
+  sample.timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::system_clock::now().time_since_epoch())
+                           .count();
+
+  // Rates cover the interval since the previous sample, timed by the
+  // monotonic clock so that wall clock adjustments do not skew them; the
+  // first sample reports the ratio since the pool was created.
+  const MetricsSample &base = havePrevious_ ? previous_ : MetricsSample{};
+  const double seconds =
+      havePrevious_
+          ? std::chrono::duration<double>(now - previousTime_).count()
+          : 0.0;
+  const std::uint64_t hits = delta(sample.hits, base.hits);
+  const std::uint64_t requests = hits + delta(sample.misses, base.misses);
+  const double hitRatio =
+      requests == 0 ? 0.0 : static_cast<double>(hits) / requests;
+
+  if (log_.is_open()) {
+    appendToLog(sample, hitRatio,
+                perSecond(sample.diskreads, base.diskreads, seconds),
+                perSecond(sample.diskwrites, base.diskwrites, seconds),
+                perSecond(sample.clockSteps, base.clockSteps, seconds));
+  }
+  if (!options_.prometheusPath.empty()) {
+    writePrometheus(sample, hitRatio);
+  }
+  previous_ = sample;
+  previousTime_ = now;
+  havePrevious_ = true;
+}
+
+void MetricsSampler::appendToLog(const MetricsSample &sample, double hitRatio,
+                                 double readsPerSec, double writesPerSec,
+                                 double clockVelocity) {
+  if (logBytes_ >= options_.maxFileBytes) rotate();
+
+  char line[512];
+  int length;
+  if (options_.format == MetricsSamplerOptions::JSON_LINES) {
+    length = std::snprintf(
+        line, sizeof(line),
+        "{\"timestamp_ms\":%llu,\"frames\":%u,\"valid\":%u,\"dirty\":%u,"
+        "\"pinned\":%u,\"hit_ratio\":%.4f,\"reads_per_s\":%.1f,"
+        "\"writes_per_s\":%.1f,\"clock_frames_per_s\":%.1f,\"hits\":%llu,"
+        "\"misses\":%llu,\"diskreads\":%llu,\"diskwrites\":%llu}\n",
+        static_cast<unsigned long long>(sample.timestampMs), sample.frames,
+        sample.validFrames, sample.dirtyFrames, sample.pinnedFrames, hitRatio,
+        readsPerSec, writesPerSec, clockVelocity,
+        static_cast<unsigned long long>(sample.hits),
+        static_cast<unsigned long long>(sample.misses),
+        static_cast<unsigned long long>(sample.diskreads),
+        static_cast<unsigned long long>(sample.diskwrites));
+  } else {
+    if (logBytes_ == 0) {
+      const char header[] =
+          "timestamp_ms,frames,valid,dirty,pinned,hit_ratio,reads_per_s,"
+          "writes_per_s,clock_frames_per_s,hits,misses,diskreads,"
+          "diskwrites\n";
+      log_ << header;
+      logBytes_ += sizeof(header) - 1;
+    }
+    length = std::snprintf(
+        line, sizeof(line), "%llu,%u,%u,%u,%u,%.4f,%.1f,%.1f,%.1f,%llu,%llu,%llu,%llu\n",
+        static_cast<unsigned long long>(sample.timestampMs), sample.frames,
+        sample.validFrames, sample.dirtyFrames, sample.pinnedFrames, hitRatio,
+        readsPerSec, writesPerSec, clockVelocity,
+        static_cast<unsigned long long>(sample.hits),
+        static_cast<unsigned long long>(sample.misses),
+        static_cast<unsigned long long>(sample.diskreads),
+        static_cast<unsigned long long>(sample.diskwrites));
+  }
+  log_.write(line, length);
+  log_.flush();
+  logBytes_ += length;
+}
+
+void MetricsSampler::rotate() {
+  log_.close();
+  for (std::uint32_t i = options_.keepFiles; i > 1; --i) {
+    std::rename((options_.path + "." + std::to_string(i - 1)).c_str(),
+                (options_.path + "." + std::to_string(i)).c_str());
+  }
+  if (options_.keepFiles > 0) {
+    std::rename(options_.path.c_str(), (options_.path + ".1").c_str());
+  }
+  log_.open(options_.path, std::ios::trunc);
+  logBytes_ = 0;
+}
+
+void MetricsSampler::writePrometheus(const MetricsSample &sample,
+                                     double hitRatio) {
+  // Written beside the target and renamed over it, so the collector only
+  // ever sees a complete file.
+  const std::string tmpPath = options_.prometheusPath + ".tmp";
+  {
+    std::ofstream out(tmpPath, std::ios::trunc);
+    out << "# HELP badgerdb_buffer_frames Frames in the buffer pool by state.\n"
+        << "# TYPE badgerdb_buffer_frames gauge\n"
+        << "badgerdb_buffer_frames{state=\"total\"} " << sample.frames << "\n"
+        << "badgerdb_buffer_frames{state=\"valid\"} " << sample.validFrames
+        << "\n"
+        << "badgerdb_buffer_frames{state=\"dirty\"} " << sample.dirtyFrames
+        << "\n"
+        << "badgerdb_buffer_frames{state=\"pinned\"} " << sample.pinnedFrames
+        << "\n"
+        << "# HELP badgerdb_buffer_hit_ratio Hit ratio over the last sampling "
+           "interval.\n"
+        << "# TYPE badgerdb_buffer_hit_ratio gauge\n"
+        << "badgerdb_buffer_hit_ratio " << hitRatio << "\n"
+        << "# HELP badgerdb_buffer_requests_total Page requests by outcome.\n"
+        << "# TYPE badgerdb_buffer_requests_total counter\n"
+        << "badgerdb_buffer_requests_total{result=\"hit\"} " << sample.hits
+        << "\n"
+        << "badgerdb_buffer_requests_total{result=\"miss\"} " << sample.misses
+        << "\n"
+        << "# HELP badgerdb_buffer_disk_pages_total Pages read from and "
+           "written to disk.\n"
+        << "# TYPE badgerdb_buffer_disk_pages_total counter\n"
+        << "badgerdb_buffer_disk_pages_total{op=\"read\"} " << sample.diskreads
+        << "\n"
+        << "badgerdb_buffer_disk_pages_total{op=\"write\"} "
+        << sample.diskwrites << "\n"
+        << "# HELP badgerdb_buffer_clock_steps_total Frames the clock hand has "
+           "passed.\n"
+        << "# TYPE badgerdb_buffer_clock_steps_total counter\n"
+        << "badgerdb_buffer_clock_steps_total " << sample.clockSteps << "\n";
+  }
+  std::rename(tmpPath.c_str(), options_.prometheusPath.c_str());
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,180 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace badgerdb {
+
+/**
+ * @brief Point-in-time metrics of a buffer pool: occupancy gauges and
+ * cumulative counters.
+ */
+struct MetricsSample {
+  /**
+   * Wall-clock time of the sample, in milliseconds since the epoch
+   */
+  std::uint64_t timestampMs;
+
+  /**
+   * Frames in the pool, and of those the valid, dirty and pinned ones
+   */
+  std::uint32_t frames;
+  std::uint32_t validFrames;
+  std::uint32_t dirtyFrames;
+  std::uint32_t pinnedFrames;
+
+  /**
+   * Cumulative hits, misses, pages read from and written to disk, and frames
+   * the clock has looked at
+   */
+  std::uint64_t hits;
+  std::uint64_t misses;
+  std::uint64_t diskreads;
+  std::uint64_t diskwrites;
+  std::uint64_t clockSteps;
+};
+
+/**
+ * @brief Where and how often MetricsSampler writes its samples.
+ */
+struct MetricsSamplerOptions {
+  /**
+   * Formats of the sample log.
+   */
+  enum Format { CSV, JSON_LINES };
+
+  /**
+   * Time between samples
+   */
+  std::uint32_t intervalMs = 1000;
+
+  /**
+   * File samples are appended to, or empty for none, and its format
+   */
+  std::string path;
+  Format format = CSV;
+
+  /**
+   * Size at which the sample log is rotated to path.1, path.2 and so on,
+   * and the number of rotated files kept
+   */
+  std::uint64_t maxFileBytes = 16 << 20;
+  std::uint32_t keepFiles = 3;
+
+  /**
+   * File rewritten with the latest sample in Prometheus text format, for
+   * node_exporter's textfile collector, or empty for none.  The name should
+   * end in ".prom".
+   */
+  std::string prometheusPath;
+};
+
+/**
+ * @brief Background thread which samples a buffer pool's metrics at a fixed
+ * interval.
+ *
+ * Each sample is appended to a rotating CSV or JSON-lines log together with
+ * the rates since the previous sample: hit ratio, disk reads and writes per
+ * second and the clock hand's velocity in frames per second.  The latest
+ * sample can also be published as a Prometheus textfile, which is replaced
+ * atomically so the collector never reads a partial one.  The work done per
+ * sample is independent of the pool size.
+ *
+ * This class is threadsafe.
+ */
+class MetricsSampler {
+ public:
+  /**
+   * Starts sampling.
+   *
+   * @param options Where and how often to write samples.
+   * @param sample  Takes a sample; called on the sampler thread, so it must
+   *                be safe to call concurrently with the pool's users.
+   */
+  MetricsSampler(const MetricsSamplerOptions &options,
+                 std::function<MetricsSample()> sample);
+
+  /**
+   * Stops sampling, after writing a last sample.
+   */
+  ~MetricsSampler();
+
+  MetricsSampler(const MetricsSampler &) = delete;
+  MetricsSampler &operator=(const MetricsSampler &) = delete;
+
+  /**
+   * Returns the number of samples written so far.
+   */
+  std::uint64_t getSampleCount();
+
+ private:
+  /**
+   * Body of the sampler thread.
+   */
+  void run();
+
+  /**
+   * Takes a sample and writes it out.
+   */
+  void sampleOnce();
+
+  /**
+   * Appends a sample to the log, rotating it first if it is full.
+   */
+  void appendToLog(const MetricsSample &sample, double hitRatio,
+                   double readsPerSec, double writesPerSec,
+                   double clockVelocity);
+
+  /**
+   * Rewrites the Prometheus textfile.
+   */
+  void writePrometheus(const MetricsSample &sample, double hitRatio);
+
+  /**
+   * Rotates the log: path becomes path.1, path.1 becomes path.2 and so on.
+   */
+  void rotate();
+
+  MetricsSamplerOptions options_;
+  std::function<MetricsSample()> sample_;
+
+  /**
+   * Sample log being appended to, and its size
+   */
+  std::ofstream log_;
+  std::uint64_t logBytes_;
+
+  /**
+   * Previous sample, which rates are computed against, if any, and when it
+   * was taken by the monotonic clock
+   */
+  MetricsSample previous_;
+  std::chrono::steady_clock::time_point previousTime_;
+  bool havePrevious_;
+
+  /**
+   * Protects the members below; stopping_ is signalled through wake_.
+   */
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  bool stopping_;
+  std::uint64_t samples_;
+
+  std::thread thread_;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,161 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "miss_ratio_curve.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Number of distinct 32-bit hashes.
+ */
+const double HASH_SPACE = 4294967296.0;
+
+}  // namespace
+
+MissRatioCurve::MissRatioCurve(std::uint32_t maxFrames, std::uint32_t points,
+                               std::uint32_t maxSamples)
+    : bucketFrames_(points > 0 && maxFrames > points
+                        ? (maxFrames + points - 1) / points
+                        : 1),
+      maxSamples_(maxSamples > 0 ? maxSamples : 1),
+      threshold_(UINT32_MAX),
+      tree_(2 * maxSamples_ + 3, 0),
+      keyAt_(2 * maxSamples_ + 2),
+      liveAt_(2 * maxSamples_ + 2, false),
+      now_(0),
+      distances_((maxFrames + bucketFrames_ - 1) / bucketFrames_, 0.0),
+      beyond_(0),
+      total_(0),
+      sampled_(0) {}
+
+void MissRatioCurve::recordSampled(std::uint64_t key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++sampled_;
+  total_ += 1;
+
+  auto found = entries_.find(key);
+  if (found != entries_.end()) {
+    // Every tracked page requested since holds a later time.
+    const std::uint32_t since =
+        entries_.size() - timesUpTo(found->second.time);
+    const double scaled = since * HASH_SPACE / threshold_;
+    const double bucket = scaled / bucketFrames_;
+    if (bucket < distances_.size()) {
+      distances_[static_cast<std::size_t>(bucket)] += 1;
+    } else {
+      beyond_ += 1;
+    }
+    addTime(found->second.time, -1);
+    liveAt_[found->second.time] = false;
+  } else {
+    // A first request misses at every size.
+    beyond_ += 1;
+    const std::uint32_t hash = static_cast<std::uint32_t>(mix(key));
+    found = entries_.emplace(key, Entry{hash, 0}).first;
+    byHash_.insert({hash, key});
+  }
+
+  if (now_ == liveAt_.size()) compactTimes();
+  found->second.time = now_;
+  keyAt_[now_] = key;
+  liveAt_[now_] = true;
+  addTime(now_, 1);
+  ++now_;
+
+  if (entries_.size() > maxSamples_) shrinkSample();
+}
+
+void MissRatioCurve::shrinkSample() {
+  const std::uint32_t oldThreshold = threshold_;
+  std::uint32_t newThreshold = oldThreshold;
+  while (entries_.size() > maxSamples_) {
+    newThreshold = byHash_.rbegin()->first;
+    while (!byHash_.empty() && byHash_.rbegin()->first >= newThreshold) {
+      const auto highest = std::prev(byHash_.end());
+      const Entry &entry = entries_.at(highest->second);
+      addTime(entry.time, -1);
+      liveAt_[entry.time] = false;
+      entries_.erase(highest->second);
+      byHash_.erase(highest);
+    }
+  }
+
+  // Counts so far were taken at the higher rate.
+  const double scale = static_cast<double>(newThreshold) / oldThreshold;
+  for (double &count : distances_) count *= scale;
+  beyond_ *= scale;
+  total_ *= scale;
+  threshold_ = newThreshold;
+}
+
+void MissRatioCurve::compactTimes() {
+  std::fill(tree_.begin(), tree_.end(), 0);
+  std::uint32_t next = 0;
+  for (std::uint32_t time = 0; time < now_; ++time) {
+    if (!liveAt_[time]) continue;
+    liveAt_[time] = false;
+    keyAt_[next] = keyAt_[time];
+    liveAt_[next] = true;
+    entries_.at(keyAt_[next]).time = next;
+    addTime(next, 1);
+    ++next;
+  }
+  now_ = next;
+}
+
+void MissRatioCurve::addTime(std::uint32_t time, int delta) {
+  for (std::size_t i = time + 1; i < tree_.size(); i += i & (~i + 1)) {
+    tree_[i] += delta;
+  }
+}
+
+std::uint32_t MissRatioCurve::timesUpTo(std::uint32_t time) const {
+  std::uint32_t count = 0;
+  for (std::size_t i = time + 1; i > 0; i -= i & (~i + 1)) {
+    count += tree_[i];
+  }
+  return count;
+}
+
+std::vector<MissRatioCurve::Point> MissRatioCurve::curve() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<Point> points;
+  double hits = 0;
+  for (std::size_t i = 0; i < distances_.size(); ++i) {
+    hits += distances_[i];
+    points.push_back({static_cast<std::uint32_t>((i + 1) * bucketFrames_),
+                      total_ > 0 ? hits / total_ : 0.0});
+  }
+  return points;
+}
+
+double MissRatioCurve::hitRatio(std::uint32_t frames) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const std::size_t buckets =
+      std::min<std::size_t>(frames / bucketFrames_, distances_.size());
+  double hits = 0;
+  for (std::size_t i = 0; i < buckets; ++i) hits += distances_[i];
+  return total_ > 0 ? hits / total_ : 0.0;
+}
+
+double MissRatioCurve::samplingRate() const {
+  return threshold_ / HASH_SPACE;
+}
+
+std::uint64_t MissRatioCurve::getSampledCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return sampled_;
+}
+
+}  // namespace badgerdb
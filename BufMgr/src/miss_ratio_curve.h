@@ -0,0 +1,173 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace badgerdb {
+
+/**
+ * @brief Online estimate of the hit ratio a buffer pool would have at each of
+ * a range of sizes, from the stream of page requests.
+ *
+ * Uses SHARDS: only requests for pages whose hash falls below a threshold
+ * are looked at, so that a fixed fraction of the pages is sampled, and the
+ * reuse distance of each sampled request (the number of distinct sampled
+ * pages requested since the previous request for the same page) is scaled up
+ * by the sampling rate.  At most maxSamples pages are tracked; when more are
+ * seen, the threshold is lowered to drop the pages with the highest hashes
+ * and the counts so far are scaled down to match.  A request which is not
+ * sampled costs one hash and one comparison.
+ *
+ * Reuse distances give the hit ratio of an LRU pool; the clock replacement
+ * of BufMgr approximates it.
+ *
+ * record() must only be called by one thread at a time; the curve may be
+ * queried from any thread.
+ */
+class MissRatioCurve {
+ public:
+  /**
+   * @brief Estimated hit ratio at one pool size.
+   */
+  struct Point {
+    std::uint32_t frames;
+    double hitRatio;
+  };
+
+  /**
+   * Creates an estimator with every page sampled to begin with.
+   *
+   * @param maxFrames  Largest pool size estimated
+   * @param points     Number of pool sizes estimated, evenly spaced up to
+   *                   maxFrames
+   * @param maxSamples Most pages tracked at once
+   */
+  MissRatioCurve(std::uint32_t maxFrames, std::uint32_t points,
+                 std::uint32_t maxSamples);
+
+  /**
+   * Counts a request for a page.
+   *
+   * @param key Key of the page requested, unique to the page
+   */
+  void record(std::uint64_t key) {
+    if (static_cast<std::uint32_t>(mix(key)) < threshold_.load(
+                                                   std::memory_order_relaxed))
+      recordSampled(key);
+  }
+
+  /**
+   * Returns the estimated hit ratio at each pool size, smallest first.
+   */
+  std::vector<Point> curve() const;
+
+  /**
+   * Returns the estimated hit ratio of a pool of the given size, rounded
+   * down to the nearest size estimated; zero below the smallest.
+   */
+  double hitRatio(std::uint32_t frames) const;
+
+  /**
+   * Returns the fraction of pages currently sampled.
+   */
+  double samplingRate() const;
+
+  /**
+   * Returns the number of requests sampled so far.
+   */
+  std::uint64_t getSampledCount() const;
+
+ private:
+  /**
+   * Spreads the bits of a key (the splitmix64 finalizer).
+   */
+  static std::uint64_t mix(std::uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+  }
+
+  /**
+   * Counts a sampled request.
+   */
+  void recordSampled(std::uint64_t key);
+
+  /**
+   * Lowers the threshold until no more than maxSamples pages are tracked.
+   */
+  void shrinkSample();
+
+  /**
+   * Renumbers the live request times from zero, once the tree is full.
+   */
+  void compactTimes();
+
+  /**
+   * Adds delta at a request time in the Fenwick tree, and returns the number
+   * of live request times up to and including time.
+   */
+  void addTime(std::uint32_t time, int delta);
+  std::uint32_t timesUpTo(std::uint32_t time) const;
+
+  /**
+   * @brief A tracked page: its hash and the time of its last request.
+   */
+  struct Entry {
+    std::uint32_t hash;
+    std::uint32_t time;
+  };
+
+  const std::uint32_t bucketFrames_;
+  const std::uint32_t maxSamples_;
+
+  /**
+   * Pages whose 32-bit hash is below the threshold are sampled; 2^32 times
+   * the sampling rate, saturated at 2^32 - 1
+   */
+  std::atomic<std::uint32_t> threshold_;
+
+  /**
+   * Protects the members below.
+   */
+  mutable std::mutex mutex_;
+
+  /**
+   * Tracked pages by key, and by hash so the highest can be dropped
+   */
+  std::unordered_map<std::uint64_t, Entry> entries_;
+  std::set<std::pair<std::uint32_t, std::uint64_t>> byHash_;
+
+  /**
+   * Times of the last request of each tracked page, counted in sampled
+   * requests: a Fenwick tree of live times, the key at each time, and the
+   * next time
+   */
+  std::vector<std::uint32_t> tree_;
+  std::vector<std::uint64_t> keyAt_;
+  std::vector<bool> liveAt_;
+  std::uint32_t now_;
+
+  /**
+   * Weighted count of sampled requests by scaled reuse distance, in buckets
+   * of bucketFrames, of those beyond the largest size, and of all of them
+   */
+  std::vector<double> distances_;
+  double beyond_;
+  double total_;
+  std::uint64_t sampled_;
+};
+
+}  // namespace badgerdb
@@ -10,9 +10,11 @@
 
 #include <stdint.h>
 
+#include <array>
 #include <cstddef>
 #include <memory>
 #include <string>
+#include <type_traits>
 
 #include "types.h"
 
@@ -59,6 +61,24 @@ struct PageHeader {
    */
   PageId next_page_number;
 
+  /**
+   * Log sequence number of the last logged change to this page, or 0 if the
+   * page has never been logged.
+   */
+  Lsn lsn;
+
+  /**
+   * CRC32C of the page as last written to disk, computed with this field set
+   * to 0.
+   */
+  std::uint32_t checksum;
+
+  /**
+   * Unused; keeps the header free of padding so that every byte of it is
+   * covered by the checksum deterministically.
+   */
+  std::uint32_t reserved;
+
   /**
    * Returns true if this page header is equal to the other.
    *
@@ -201,6 +221,48 @@ class Page {
    */
   PageId next_page_number() const { return header_.next_page_number; }
 
+  /**
+   * Returns the log sequence number of the last logged change to this page.
+   *
+   * @return  Page LSN.
+   */
+  Lsn page_lsn() const { return header_.lsn; }
+
+  /**
+   * Copies the on-disk image of this page (its header followed by its data)
+   * into a buffer of Page::SIZE bytes.
+   *
+   * @param image   Buffer receiving the page image.
+   */
+  void writeImage(char *image) const;
+
+  /**
+   * Replaces the contents of this page with an on-disk page image of
+   * Page::SIZE bytes, as produced by writeImage().
+   *
+   * @param image   Buffer holding the page image.
+   */
+  void readImage(const char *image);
+
+  /**
+   * Computes the checksum a page with the given header and data is stored
+   * with.  The header's checksum field is treated as 0.
+   *
+   * @param header  Page header.
+   * @param data    Page data, Page::DATA_SIZE bytes.
+   * @return  CRC32C of the page.
+   */
+  static std::uint32_t computeChecksum(const PageHeader &header,
+                                       const char *data);
+
+  /**
+   * Returns true if the checksum in this page's header matches its contents,
+   * as is the case for a page read intact from disk.
+   */
+  bool hasValidChecksum() const {
+    return header_.checksum == computeChecksum(header_, data_.data());
+  }
+
   /**
    * Returns an iterator at the first record in the page.
    *
@@ -240,6 +302,13 @@ class Page {
     header_.next_page_number = new_next_page_number;
   }
 
+  /**
+   * Sets the log sequence number of the last logged change to this page.
+   *
+   * @param new_lsn   LSN of the log record describing this page.
+   */
+  void set_page_lsn(const Lsn new_lsn) { header_.lsn = new_lsn; }
+
   /**
    * Deletes the record with the given ID.  Page is compacted upon delete to
    * ensure that data of all records is contiguous.  Slot array is compacted if
@@ -329,12 +398,13 @@ class Page {
 
   /**
    * Data stored on the page.  Includes bookkeeping information about slots as
-   * well as actual content.
+   * well as actual content.  Held inline, so that a page is exactly one page
+   * image and can be placed in memory shared between processes.
    */
-
-  std::string data_;
+  std::array<char, DATA_SIZE> data_;
 
   friend class File;
+  friend class LogManager;
   friend class PageIterator;
   friend class PageTest;
   friend class BufferTest;
@@ -343,5 +413,8 @@ class Page {
 static_assert(Page::SIZE > sizeof(PageHeader),
               "Page size must be large enough to hold header and data.");
 static_assert(Page::DATA_SIZE > 0, "Page must have some space to hold data.");
+static_assert(sizeof(Page) == Page::SIZE, "Page must be one page image.");
+static_assert(std::is_trivially_copyable<Page>::value,
+              "Page must be copyable as a page image.");
 
 }  // namespace badgerdb
@@ -0,0 +1,127 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "page_map.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "exceptions/file_not_found_exception.h"
+
+namespace badgerdb {
+
+PageMap::PageMap(const std::string &filename, const bool create,
+                 const std::uint64_t dataStart)
+    : path_(mapPath(filename)), fd_(-1), dataFd_(-1), end_(dataStart) {
+  fd_ = ::open(path_.c_str(), create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR,
+               0644);
+  if (fd_ < 0) {
+    throw FileNotFoundException(path_);
+  }
+  dataFd_ = ::open(filename.c_str(), O_RDONLY);
+  if (dataFd_ < 0) {
+    ::close(fd_);
+    throw FileNotFoundException(filename);
+  }
+
+  struct stat st;
+  fstat(fd_, &st);
+  entries_.resize(st.st_size / sizeof(Location));
+  if (!entries_.empty()) {
+    pread(fd_, entries_.data(), entries_.size() * sizeof(Location), 0);
+  }
+
+  // Free slots are the gaps between the slots in use.
+  std::vector<Location> used;
+  for (const Location &entry : entries_) {
+    if (entry.capacity > 0) used.push_back(entry);
+  }
+  std::sort(used.begin(), used.end(),
+            [](const Location &a, const Location &b) {
+              return a.offset < b.offset;
+            });
+  for (const Location &entry : used) {
+    if (entry.offset > end_) release(end_, entry.offset - end_);
+    end_ = std::max(end_, entry.offset + entry.capacity);
+  }
+}
+
+PageMap::~PageMap() {
+  ::close(dataFd_);
+  ::close(fd_);
+}
+
+PageMap::Location PageMap::find(const PageId pageNo) const {
+  if (pageNo >= entries_.size()) {
+    return Location{0, 0, 0};
+  }
+  return entries_[pageNo];
+}
+
+PageMap::Location PageMap::reserve(const PageId pageNo,
+                                   const std::uint32_t length) {
+  Location location = find(pageNo);
+  location.length = length;
+  if (length <= location.capacity) {
+    return location;
+  }
+
+  // Best fit among the free slots, splitting off what is not needed.
+  const std::uint32_t capacity =
+      (length + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT;
+  location.capacity = capacity;
+  auto slot = free_.lower_bound(capacity);
+  if (slot == free_.end() && !unsynced_.empty()) {
+    // Syncing makes the slots given up since the last sync reusable, which
+    // beats growing the file.
+    sync();
+    slot = free_.lower_bound(capacity);
+  }
+  if (slot != free_.end()) {
+    location.offset = slot->second;
+    const std::uint32_t rest = slot->first - capacity;
+    const std::uint64_t restOffset = slot->second + capacity;
+    free_.erase(slot);
+    if (rest > 0) release(restOffset, rest);
+  } else {
+    location.offset = end_;
+    end_ += capacity;
+  }
+  return location;
+}
+
+void PageMap::commit(const PageId pageNo, const Location &location) {
+  if (pageNo >= entries_.size()) {
+    entries_.resize(pageNo + 1, Location{0, 0, 0});
+  }
+  Location &entry = entries_[pageNo];
+  const bool moved = entry.capacity > 0 && entry.offset != location.offset;
+  const Location previous = entry;
+  entry = location;
+  pwrite(fd_, &entry, sizeof(entry), pageNo * sizeof(Location));
+  if (moved) unsynced_.emplace_back(previous.offset, previous.capacity);
+}
+
+void PageMap::sync() {
+  // An entry made durable before its slot's contents would point at garbage
+  // after a crash, and the slot it moved out of may be reused by then.
+  fdatasync(dataFd_);
+  fdatasync(fd_);
+  for (const auto &slot : unsynced_) release(slot.first, slot.second);
+  unsynced_.clear();
+}
+
+void PageMap::release(const std::uint64_t offset,
+                      const std::uint32_t capacity) {
+  free_.emplace(capacity, offset);
+}
+
+}  // namespace badgerdb
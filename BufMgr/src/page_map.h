@@ -0,0 +1,163 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Page-location map of a compressed file.
+ *
+ * In a compressed file pages are not stored at fixed positions.  Each page is
+ * compressed into a slot whose size is a multiple of SLOT_ALIGNMENT, and this
+ * map records for every page the offset of its slot, the number of bytes
+ * stored in it and the slot's capacity.  A page that still fits its slot when
+ * it is rewritten stays there; otherwise it moves to a new slot and the old
+ * one is reused for other pages.
+ *
+ * The map lives in a side file next to the data file, one fixed-size entry
+ * per page, and is held in memory while the file is open.  A page is written
+ * to its new slot before its entry is updated, so a crash never leaves an
+ * entry pointing at a slot that has not been written, and the data file is
+ * synced before the map, so that no entry on disk points at a slot whose
+ * contents are not durable.  The slot a page moved out of is only reused once
+ * the map has been synced, so that the entry on disk cannot still point at it
+ * when another page is written there.  Free
+ * slots are not stored; they are the gaps between used slots and are found
+ * again on open.
+ *
+ * @warning This class is not threadsafe.
+ */
+class PageMap {
+ public:
+  /**
+   * Granularity of slot sizes and offsets in the data file.
+   */
+  static const std::uint32_t SLOT_ALIGNMENT = 256;
+
+  /**
+   * @brief Where a page is stored in the data file.
+   */
+  struct Location {
+    /**
+     * Offset of the slot in the data file.
+     */
+    std::uint64_t offset;
+
+    /**
+     * Number of bytes stored in the slot; 0 if the page was never written,
+     * Page::SIZE if it is stored uncompressed.
+     */
+    std::uint32_t length;
+
+    /**
+     * Size of the slot.
+     */
+    std::uint32_t capacity;
+  };
+
+  /**
+   * Returns the path of the map belonging to the given data file.
+   */
+  static std::string mapPath(const std::string &filename) {
+    return filename + ".pmap";
+  }
+
+  /**
+   * Opens the map of a data file, creating an empty one if asked to.
+   *
+   * @param filename    Name of the data file.
+   * @param create      Whether to create a new, empty map.
+   * @param dataStart   First offset in the data file slots may use.
+   * @throws  FileNotFoundException  If the map cannot be opened.
+   */
+  PageMap(const std::string &filename, const bool create,
+          const std::uint64_t dataStart);
+
+  /**
+   * Closes the map.
+   */
+  ~PageMap();
+
+  PageMap(const PageMap &) = delete;
+  PageMap &operator=(const PageMap &) = delete;
+
+  /**
+   * Returns the location of a page.  Its length is 0 if the page has never
+   * been written.
+   */
+  Location find(const PageId pageNo) const;
+
+  /**
+   * Chooses the slot a page of the given stored length is to be written to:
+   * its current slot if the page still fits, otherwise a free or new slot.
+   * The map is not changed until commit().
+   *
+   * @param pageNo  Page number.
+   * @param length  Number of bytes to store.
+   * @return  Location to write the page to.
+   */
+  Location reserve(const PageId pageNo, const std::uint32_t length);
+
+  /**
+   * Records that a page has been written to the given location.  If it
+   * moved, its previous slot is released at the next sync().
+   */
+  void commit(const PageId pageNo, const Location &location);
+
+  /**
+   * Forces the data file and then the map to stable storage, and releases
+   * the slots pages have moved out of since the last sync.  Slots written
+   * through the data file's stream must have been flushed to it.
+   */
+  void sync();
+
+ private:
+  /**
+   * Adds an extent of the data file to the free slots.
+   */
+  void release(const std::uint64_t offset, const std::uint32_t capacity);
+
+  /**
+   * Path and descriptor of the map file.
+   */
+  std::string path_;
+  int fd_;
+
+  /**
+   * Descriptor of the data file, used only to sync it.
+   */
+  int dataFd_;
+
+  /**
+   * Location of every page, indexed by page number.
+   */
+  std::vector<Location> entries_;
+
+  /**
+   * Free slots by capacity, and the end of the used part of the data file.
+   */
+  std::multimap<std::uint32_t, std::uint64_t> free_;
+  std::uint64_t end_;
+
+  /**
+   * Slots pages have moved out of, by offset and capacity, which the map on
+   * disk may still point at until it is synced.
+   */
+  std::vector<std::pair<std::uint64_t, std::uint32_t>> unsynced_;
+};
+
+}  // namespace badgerdb
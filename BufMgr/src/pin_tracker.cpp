@@ -0,0 +1,105 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "pin_tracker.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace badgerdb {
+
+const char *const PinTracker::UNTAGGED = "untagged";
+
+void PinTracker::pinned(FrameId frameNo, const char *tag,
+                        const std::string &filename, PageId pageNo) {
+  const std::uint64_t now = LatencyTimer::now();
+  std::lock_guard<std::mutex> lock(mutex_);
+  pins_[frameNo].push_back({tag ? tag : UNTAGGED, now, filename, pageNo});
+}
+
+void PinTracker::unpinned(FrameId frameNo) {
+  const std::uint64_t now = LatencyTimer::now();
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto frame = pins_.find(frameNo);
+  if (frame == pins_.end()) return;
+
+  const Pin &pin = frame->second.back();
+  auto histogram = histograms_.find(pin.tag);
+  if (histogram == histograms_.end()) {
+    histogram = histograms_
+                    .emplace(pin.tag, std::unique_ptr<LatencyHistogram>(
+                                          new LatencyHistogram()))
+                    .first;
+  }
+  histogram->second->record(now - pin.startNs);
+
+  frame->second.pop_back();
+  if (frame->second.empty()) pins_.erase(frame);
+}
+
+void PinTracker::forget(FrameId frameNo) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pins_.erase(frameNo);
+}
+
+std::vector<std::string> PinTracker::tags() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<std::string> tags;
+  for (const auto &histogram : histograms_) tags.push_back(histogram.first);
+  return tags;
+}
+
+const LatencyHistogram *PinTracker::histogram(const std::string &tag) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto histogram = histograms_.find(tag);
+  return histogram != histograms_.end() ? histogram->second.get() : nullptr;
+}
+
+std::vector<PinTracker::OutstandingPin> PinTracker::outstanding(
+    std::uint64_t minHeldNs) const {
+  const std::uint64_t now = LatencyTimer::now();
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<OutstandingPin> held;
+  for (const auto &frame : pins_) {
+    for (const Pin &pin : frame.second) {
+      const std::uint64_t heldNs = now - pin.startNs;
+      if (heldNs < minHeldNs) continue;
+      held.push_back({pin.tag, pin.filename, pin.pageNo, frame.first, heldNs});
+    }
+  }
+  std::sort(held.begin(), held.end(),
+            [](const OutstandingPin &a, const OutstandingPin &b) {
+              return a.heldNs > b.heldNs;
+            });
+  return held;
+}
+
+std::string PinTracker::toText(std::uint64_t minHeldNs) const {
+  std::ostringstream out;
+  out << "tag\tcount\tmean_ns\tp50_ns\tp99_ns\tmax_ns\n";
+  for (const std::string &tag : tags()) {
+    const LatencyHistogram *held = histogram(tag);
+    out << tag << "\t" << held->count() << "\t"
+        << static_cast<std::uint64_t>(held->mean()) << "\t"
+        << held->percentile(50) << "\t" << held->percentile(99) << "\t"
+        << held->max() << "\n";
+  }
+  out << "outstanding\ttag\tfile\tpage\tframe\theld_ns\n";
+  for (const OutstandingPin &pin : outstanding(minHeldNs)) {
+    out << "outstanding\t" << pin.tag << "\t" << pin.filename << "\t"
+        << pin.pageNo << "\t" << pin.frameNo << "\t" << pin.heldNs << "\n";
+  }
+  return out.str();
+}
+
+void PinTracker::reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto &histogram : histograms_) histogram.second->reset();
+}
+
+}  // namespace badgerdb
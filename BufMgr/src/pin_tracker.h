@@ -0,0 +1,146 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "latency_histogram.h"
+#include "types.h"
+
+#define BADGERDB_STRINGIFY_(x) #x
+#define BADGERDB_STRINGIFY(x) BADGERDB_STRINGIFY_(x)
+
+/**
+ * Expands to "file.cpp:123" for the line it is used on, as a pin tag naming
+ * the call site of readPage() or allocPage().
+ */
+#define BADGERDB_HERE __FILE__ ":" BADGERDB_STRINGIFY(__LINE__)
+
+namespace badgerdb {
+
+/**
+ * @brief Profiles how long pages stay pinned, by who pinned them.
+ *
+ * Each pin is recorded with a caller tag and the time it was taken; an unpin
+ * of the frame releases the most recent pin still outstanding on it, and the
+ * time it was held is added to the histogram of its tag.  Pins outstanding
+ * for longer than a threshold can be listed at any time, to find the callers
+ * which keep frames from being replaced.
+ *
+ * Tags are kept by pointer until their pin is released, so they must be
+ * string literals or otherwise outlive it; BADGERDB_HERE makes one from the
+ * call site.
+ *
+ * This class is threadsafe.
+ */
+class PinTracker {
+ public:
+  /**
+   * @brief A pin which has not been released yet.
+   */
+  struct OutstandingPin {
+    std::string tag;
+    std::string filename;
+    PageId pageNo;
+    FrameId frameNo;
+    std::uint64_t heldNs;
+  };
+
+  /**
+   * Tag recorded for pins taken without one.
+   */
+  static const char *const UNTAGGED;
+
+  /**
+   * Records a pin.
+   *
+   * @param frameNo  Frame pinned
+   * @param tag      Caller tag, or null for UNTAGGED
+   * @param filename File of the page pinned
+   * @param pageNo   Page pinned
+   */
+  void pinned(FrameId frameNo, const char *tag, const std::string &filename,
+              PageId pageNo);
+
+  /**
+   * Releases the most recent pin outstanding on a frame, recording how long
+   * it was held.  Does nothing if none is.
+   */
+  void unpinned(FrameId frameNo);
+
+  /**
+   * Drops the pins outstanding on a frame which was freed without them
+   * being released.
+   */
+  void forget(FrameId frameNo);
+
+  /**
+   * Returns the tags pins have been released under.
+   */
+  std::vector<std::string> tags() const;
+
+  /**
+   * Returns the histogram of the times pins of a tag were held, or null if
+   * none has been released.  Valid as long as the tracker.
+   */
+  const LatencyHistogram *histogram(const std::string &tag) const;
+
+  /**
+   * Returns the pins held for at least minHeldNs, longest held first.
+   */
+  std::vector<OutstandingPin> outstanding(std::uint64_t minHeldNs) const;
+
+  /**
+   * Returns a table of pin durations by tag followed by the pins held for
+   * at least minHeldNs.
+   */
+  std::string toText(std::uint64_t minHeldNs) const;
+
+  /**
+   * Clears the histograms; outstanding pins are kept.
+   */
+  void reset();
+
+ private:
+  /**
+   * @brief A pin being held.
+   */
+  struct Pin {
+    const char *tag;
+    std::uint64_t startNs;
+    std::string filename;
+    PageId pageNo;
+  };
+
+  /**
+   * Protects the members below.
+   */
+  mutable std::mutex mutex_;
+
+  /**
+   * Pins outstanding on each frame, oldest first
+   */
+  std::unordered_map<FrameId, std::vector<Pin>> pins_;
+
+  /**
+   * Histograms of pin durations by tag; never removed, so pointers to them
+   * stay valid
+   */
+  std::map<std::string, std::unique_ptr<LatencyHistogram>, std::less<>>
+      histograms_;
+};
+
+}  // namespace badgerdb
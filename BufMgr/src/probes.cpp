@@ -0,0 +1,22 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "probes.h"
+
+#if BADGERDB_USDT
+
+// Tracers find the semaphores through the probe notes and increment them
+// while attached; they live in the .probes section by convention.
+#define BADGERDB_DEFINE_SEMAPHORE_(name)                      \
+  __attribute__((section(".probes"))) volatile unsigned short \
+      BADGERDB_PROBE_SEMAPHORE_(name) = 0;
+extern "C" {
+BADGERDB_PROBES_(BADGERDB_DEFINE_SEMAPHORE_)
+}
+
+#endif
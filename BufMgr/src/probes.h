@@ -0,0 +1,120 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "latency_histogram.h"
+
+/**
+ * Static tracepoints (USDT probes) on the hot paths of the buffer manager,
+ * under the provider "badgerdb", for bpftrace, perf or SystemTap:
+ *
+ *   read_hit(file, page, frame, latency_ns)    readPage() found the page
+ *   read_miss(file, page, frame, latency_ns)   readPage() had to load it
+ *   evict(file, page, frame, dirty)            a page was evicted
+ *   writeback(file, page, frame, latency_ns)   a dirty page was written
+ *   file_read(file, page, latency_ns)          File read a page
+ *   file_write(file, page, latency_ns)         File wrote a page
+ *   flush_file(file, pages, latency_ns)        flushFile() finished
+ *
+ * where file is the file name as a C string.  For example:
+ *
+ *   bpftrace -e 'usdt:./badgerdb_main:badgerdb:read_miss
+ *                { @[str(arg0)] = hist(arg3); }'
+ *
+ * Probes are compiled in when <sys/sdt.h> is available, unless built with
+ * -DBADGERDB_USDT=0.  A probe nobody is attached to costs a nop and a test
+ * of its semaphore, which also keeps latencies from being measured for it.
+ * Without <sys/sdt.h> the probes compile to nothing.
+ */
+#ifndef BADGERDB_USDT
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#define BADGERDB_USDT 1
+#endif
+#endif
+#endif
+#ifndef BADGERDB_USDT
+#define BADGERDB_USDT 0
+#endif
+
+#if BADGERDB_USDT
+
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+#define BADGERDB_PROBE_SEMAPHORE_(name) badgerdb_##name##_semaphore
+
+#define BADGERDB_PROBES_(X) \
+  X(read_hit)               \
+  X(read_miss)              \
+  X(evict)                  \
+  X(writeback)              \
+  X(file_read)              \
+  X(file_write)             \
+  X(flush_file)
+
+#define BADGERDB_DECLARE_SEMAPHORE_(name) \
+  extern volatile unsigned short BADGERDB_PROBE_SEMAPHORE_(name);
+extern "C" {
+BADGERDB_PROBES_(BADGERDB_DECLARE_SEMAPHORE_)
+}
+
+/**
+ * True while a tracer is attached to the probe.
+ */
+#define BADGERDB_PROBE_ENABLED(name) \
+  __builtin_expect(BADGERDB_PROBE_SEMAPHORE_(name) != 0, 0)
+
+#define BADGERDB_PROBE3(name, a1, a2, a3) \
+  DTRACE_PROBE3(badgerdb, name, a1, a2, a3)
+#define BADGERDB_PROBE4(name, a1, a2, a3, a4) \
+  DTRACE_PROBE4(badgerdb, name, a1, a2, a3, a4)
+
+#else
+
+#define BADGERDB_PROBE_ENABLED(name) false
+
+// The arguments are named but not evaluated, so that variables kept only
+// for probes do not draw unused warnings.
+#define BADGERDB_PROBE3(name, a1, a2, a3) \
+  do {                                    \
+    (void)sizeof(a1);                     \
+    (void)sizeof(a2);                     \
+    (void)sizeof(a3);                     \
+  } while (0)
+#define BADGERDB_PROBE4(name, a1, a2, a3, a4) \
+  do {                                        \
+    (void)sizeof(a1);                         \
+    (void)sizeof(a2);                         \
+    (void)sizeof(a3);                         \
+    (void)sizeof(a4);                         \
+  } while (0)
+
+#endif
+
+namespace badgerdb {
+
+/**
+ * Returns the start time of a probe's latency argument, or 0 if the probe
+ * is not enabled.
+ */
+inline std::uint64_t probeStart(bool enabled) {
+  return enabled ? LatencyTimer::now() : 0;
+}
+
+/**
+ * Returns the time since probeStart(), or 0 if it was not enabled.
+ */
+inline std::uint64_t probeElapsed(std::uint64_t start) {
+  return start != 0 ? LatencyTimer::now() - start : 0;
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,82 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "query_stats.h"
+
+#include <mutex>
+#include <sstream>
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Totals of closed scopes by tag, and the mutex protecting them.
+ */
+std::mutex totalsMutex;
+std::map<std::string, QueryStats> &totalsByTag() {
+  static std::map<std::string, QueryStats> totals;
+  return totals;
+}
+
+}  // namespace
+
+thread_local QueryScope *QueryScope::current_ = nullptr;
+
+QueryStats &QueryStats::operator+=(const QueryStats &other) {
+  hits += other.hits;
+  misses += other.misses;
+  diskReads += other.diskReads;
+  bytesRead += other.bytesRead;
+  allocations += other.allocations;
+  dirtied += other.dirtied;
+  writebacks += other.writebacks;
+  bytesWritten += other.bytesWritten;
+  return *this;
+}
+
+std::string QueryStats::explain() const {
+  std::ostringstream out;
+  out << "Buffers: hit=" << hits << " read=" << diskReads;
+  if (misses > diskReads) out << " cached=" << misses - diskReads;
+  if (allocations > 0) out << " allocated=" << allocations;
+  out << " dirtied=" << dirtied << " written=" << writebacks
+      << " (bytes read=" << bytesRead << " written=" << bytesWritten << ")";
+  return out.str();
+}
+
+QueryScope::QueryScope(const std::string &tag)
+    : tag_(tag), outer_(current_) {
+  current_ = this;
+}
+
+QueryScope::~QueryScope() {
+  current_ = outer_;
+  std::lock_guard<std::mutex> lock(totalsMutex);
+  totalsByTag()[tag_] += stats_;
+}
+
+std::map<std::string, QueryStats> QueryScope::totals() {
+  std::lock_guard<std::mutex> lock(totalsMutex);
+  return totalsByTag();
+}
+
+std::string QueryScope::report() {
+  std::ostringstream out;
+  for (const auto &total : totals()) {
+    out << total.first << "\t" << total.second.explain() << "\n";
+  }
+  return out.str();
+}
+
+void QueryScope::resetTotals() {
+  std::lock_guard<std::mutex> lock(totalsMutex);
+  totalsByTag().clear();
+}
+
+}  // namespace badgerdb
@@ -0,0 +1,122 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace badgerdb {
+
+/**
+ * @brief Buffer pool work done on behalf of one query or tenant.
+ */
+struct QueryStats {
+  /**
+   * Requests for pages found in the pool, and for pages which were not
+   */
+  std::uint64_t hits = 0;
+  std::uint64_t misses = 0;
+
+  /**
+   * Pages and bytes read from disk for the misses; the rest were taken
+   * from a cache tier
+   */
+  std::uint64_t diskReads = 0;
+  std::uint64_t bytesRead = 0;
+
+  /**
+   * Pages allocated, and clean pages made dirty
+   */
+  std::uint64_t allocations = 0;
+  std::uint64_t dirtied = 0;
+
+  /**
+   * Dirty pages written back, and their bytes: evicted to make room for
+   * the query's pages, or flushed by it
+   */
+  std::uint64_t writebacks = 0;
+  std::uint64_t bytesWritten = 0;
+
+  QueryStats &operator+=(const QueryStats &other);
+
+  /**
+   * Returns a one-line summary in the style of EXPLAIN (BUFFERS):
+   * "Buffers: hit=12 read=3 dirtied=1 written=2".
+   */
+  std::string explain() const;
+};
+
+/**
+ * @brief Attributes the buffer pool work done by the calling thread to a
+ * query or tenant while it is in scope.
+ *
+ * While a scope is open, BufMgr counts the requests the thread makes and
+ * the disk reads and writebacks they cause in the scope's stats().  When
+ * the scope closes its counts are added to the process-wide totals of its
+ * tag.  Scopes nest; work is counted in the innermost one only.  Work done
+ * outside any scope is not attributed.
+ */
+class QueryScope {
+ public:
+  /**
+   * Opens a scope for the calling thread.
+   *
+   * @param tag Query or tenant the work is attributed to
+   */
+  explicit QueryScope(const std::string &tag);
+
+  /**
+   * Closes the scope, adding its counts to the totals of its tag.
+   */
+  ~QueryScope();
+
+  QueryScope(const QueryScope &) = delete;
+  QueryScope &operator=(const QueryScope &) = delete;
+
+  /**
+   * Returns the tag of the scope.
+   */
+  const std::string &tag() const { return tag_; }
+
+  /**
+   * Returns the work counted in the scope so far.
+   */
+  const QueryStats &stats() const { return stats_; }
+
+  /**
+   * Returns the stats of the calling thread's innermost scope, or null if
+   * it has none open.
+   */
+  static QueryStats *current() { return current_ ? &current_->stats_ : nullptr; }
+
+  /**
+   * Returns the counts of every closed scope, added up by tag.
+   */
+  static std::map<std::string, QueryStats> totals();
+
+  /**
+   * Returns the totals as a report with one EXPLAIN-style line per tag.
+   */
+  static std::string report();
+
+  /**
+   * Forgets the totals.
+   */
+  static void resetTotals();
+
+ private:
+  const std::string tag_;
+  QueryStats stats_;
+  QueryScope *const outer_;
+
+  static thread_local QueryScope *current_;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,931 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "shared_buffer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include "exceptions/buffer_exceeded_exception.h"
+#include "exceptions/page_not_pinned_exception.h"
+#include "exceptions/page_pinned_exception.h"
+#include "exceptions/shared_pool_exception.h"
+
+namespace badgerdb {
+
+/**
+ * @brief A process attached to a shared pool.
+ */
+struct SharedClient {
+  /**
+   * Process id, 0 for a free slot.
+   */
+  pid_t pid;
+
+  /**
+   * Start time of the process in clock ticks since boot, or 0 if unknown.
+   * Tells the client apart from a later process reusing its id.
+   */
+  std::uint64_t startTime;
+};
+
+/**
+ * @brief Header at the start of a shared pool segment.
+ */
+struct SharedPoolHeader {
+  /**
+   * Set to POOL_MAGIC once the creator has initialized the segment.
+   */
+  std::atomic<std::uint64_t> magic;
+
+  /**
+   * Number of frames and hash buckets in the pool.
+   */
+  std::uint32_t numBufs;
+  std::uint32_t htSize;
+
+  /**
+   * Current position of the shared clock hand, advanced without a latch.
+   */
+  std::atomic<std::uint32_t> clockHand;
+
+  /**
+   * Process-shared, robust latch protecting the client table.
+   */
+  pthread_mutex_t latch;
+
+  /**
+   * Attached clients, by slot.
+   */
+  SharedClient clients[SharedBufMgr::MAX_CLIENTS];
+};
+
+/**
+ * @brief Hash bucket of the shared page table.
+ */
+struct SharedBucket {
+  /**
+   * Latch protecting the chain, including the links of the frames on it.
+   */
+  pthread_mutex_t latch;
+
+  /**
+   * First frame in the chain, or -1.
+   */
+  std::int32_t head;
+};
+
+/**
+ * @brief Shared counterpart of BufDesc.
+ */
+struct SharedFrameDesc {
+  /**
+   * Latch protecting the fields below, except next, and the frame's pins.
+   */
+  pthread_mutex_t latch;
+
+  /**
+   * Latch held by a process changing the page; see latchPage().
+   */
+  pthread_mutex_t contentLatch;
+
+  /**
+   * Absolute path of the file the frame is assigned to.
+   */
+  char filename[SharedBufMgr::MAX_FILENAME];
+
+  /**
+   * Page within the file the frame is assigned to.
+   */
+  PageId pageNo;
+
+  /**
+   * Total number of pins held on the frame by all clients.
+   */
+  std::int32_t pinCnt;
+
+  /**
+   * Next frame in the same hash chain, or -1.
+   */
+  std::int32_t next;
+
+  /**
+   * Client reading the page into the frame, while loading is set.
+   */
+  std::uint32_t loader;
+
+  /**
+   * True while the frame is in the page table; changed with both its bucket
+   * latch and its frame latch held.
+   */
+  bool inTable;
+
+  /**
+   * True while the page is being read into the frame.
+   */
+  bool loading;
+
+  bool dirty;
+  bool valid;
+  bool refbit;
+};
+
+namespace {
+
+const std::uint64_t POOL_MAGIC = 0x42616467657232ULL;  // "Badger2"
+
+/**
+ * How long an attaching process waits for the creator to initialize the pool.
+ */
+const std::chrono::seconds ATTACH_TIMEOUT(5);
+
+/**
+ * How often a process waiting for a page being loaded checks on it, and
+ * after how many checks it looks for a dead loader.
+ */
+const std::chrono::microseconds LOAD_POLL(50);
+const std::uint32_t LOAD_REAP_INTERVAL = 1000;
+
+std::size_t alignUp(const std::size_t n, const std::size_t alignment) {
+  return (n + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * @brief Offsets of the regions of a shared pool segment.
+ */
+struct SegmentLayout {
+  std::size_t descs;
+  std::size_t buckets;
+  std::size_t pins;
+  std::size_t frames;
+  std::size_t size;
+
+  SegmentLayout(const std::uint32_t numBufs, const std::uint32_t htSize) {
+    descs = alignUp(sizeof(SharedPoolHeader), 64);
+    buckets = alignUp(descs + numBufs * sizeof(SharedFrameDesc), 64);
+    pins = alignUp(buckets + htSize * sizeof(SharedBucket), 64);
+    frames = alignUp(pins + SharedBufMgr::MAX_CLIENTS * numBufs *
+                                sizeof(std::uint16_t),
+                     4096);
+    size = frames + static_cast<std::size_t>(numBufs) * Page::SIZE;
+  }
+};
+
+/**
+ * FNV-1a, so that every process hashes a page to the same bucket regardless
+ * of its standard library.
+ */
+std::uint32_t hashPage(const char *filename, const PageId pageNo) {
+  std::uint32_t h = 2166136261u;
+  for (const char *c = filename; *c; ++c) {
+    h = (h ^ static_cast<unsigned char>(*c)) * 16777619u;
+  }
+  for (int i = 0; i < 4; ++i) {
+    h = (h ^ ((pageNo >> (8 * i)) & 0xff)) * 16777619u;
+  }
+  return h;
+}
+
+void initLatch(pthread_mutex_t &latch) {
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+  pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+  pthread_mutex_init(&latch, &attr);
+  pthread_mutexattr_destroy(&attr);
+}
+
+/**
+ * Takes a robust latch.  If its owner died holding it, the latch is made
+ * consistent again and true is returned, so that the caller can repair what
+ * it protects.
+ */
+bool lockLatch(pthread_mutex_t &latch, const std::string &pool) {
+  const int rc = pthread_mutex_lock(&latch);
+  if (rc == EOWNERDEAD) {
+    pthread_mutex_consistent(&latch);
+    return true;
+  }
+  if (rc != 0) {
+    throw SharedPoolException(pool, "cannot take pool latch");
+  }
+  return false;
+}
+
+void clearTag(SharedFrameDesc &desc) {
+  desc.filename[0] = '\0';
+  desc.pageNo = Page::INVALID_NUMBER;
+  desc.dirty = false;
+  desc.valid = false;
+  desc.loading = false;
+}
+
+/**
+ * Returns the start time of a process in clock ticks since boot, field 22 of
+ * /proc/<pid>/stat, or 0 if it cannot be read.
+ */
+std::uint64_t processStartTime(const pid_t pid) {
+  std::ifstream in("/proc/" + std::to_string(pid) + "/stat");
+  std::string stat;
+  std::getline(in, stat);
+  // The command name, field 2, is in parentheses and may contain spaces.
+  const std::size_t end = stat.rfind(')');
+  if (end == std::string::npos) return 0;
+  std::istringstream fields(stat.substr(end + 1));
+  std::string field;
+  for (int i = 3; i < 22 && fields >> field; ++i) {
+  }
+  std::uint64_t startTime = 0;
+  fields >> startTime;
+  return startTime;
+}
+
+/**
+ * Returns true if the process registered as a client still exists.
+ */
+bool clientAlive(const SharedClient &client) {
+  if (kill(client.pid, 0) != 0 && errno == ESRCH) return false;
+  // The id may have been reused by a process started since.
+  const std::uint64_t startTime = processStartTime(client.pid);
+  return client.startTime == 0 || startTime == 0 ||
+         startTime == client.startTime;
+}
+
+/**
+ * Returns the absolute path of a file, so that processes in different
+ * working directories name its pages alike and can open it to write them.
+ */
+std::string absolutePath(const std::string &filename) {
+  char *resolved = realpath(filename.c_str(), nullptr);
+  if (resolved) {
+    const std::string path(resolved);
+    std::free(resolved);
+    return path;
+  }
+  char cwd[PATH_MAX];
+  if (filename.empty() || filename[0] == '/' || !getcwd(cwd, sizeof(cwd))) {
+    return filename;
+  }
+  return std::string(cwd) + "/" + filename;
+}
+
+/**
+ * @brief Holds an exclusive lock on a file among processes while pages are
+ * allocated or deleted in it, since both rewrite its header.
+ */
+class FileLock {
+ public:
+  explicit FileLock(const std::string &path)
+      : fd_(::open(path.c_str(), O_RDONLY)) {
+    if (fd_ >= 0) flock(fd_, LOCK_EX);
+  }
+
+  // Closing the descriptor releases the lock.
+  ~FileLock() {
+    if (fd_ >= 0) ::close(fd_);
+  }
+
+  FileLock(const FileLock &) = delete;
+  FileLock &operator=(const FileLock &) = delete;
+
+ private:
+  const int fd_;
+};
+
+}  // namespace
+
+class SharedBufMgr::LatchGuard {
+ public:
+  explicit LatchGuard(SharedBufMgr &mgr) : latch_(mgr.header_->latch) {
+    if (lockLatch(latch_, mgr.name_)) {
+      // The client table is consistent at every step, but its previous
+      // owner is gone.
+      mgr.reapDeadClientsLocked();
+    }
+  }
+
+  ~LatchGuard() { pthread_mutex_unlock(&latch_); }
+
+ private:
+  pthread_mutex_t &latch_;
+};
+
+class SharedBufMgr::BucketGuard {
+ public:
+  BucketGuard(SharedBufMgr &mgr, const std::uint32_t index)
+      : latch_(mgr.buckets_[index].latch) {
+    if (lockLatch(latch_, mgr.name_)) mgr.repairBucket(index);
+  }
+
+  ~BucketGuard() { pthread_mutex_unlock(&latch_); }
+
+ private:
+  pthread_mutex_t &latch_;
+};
+
+class SharedBufMgr::FrameGuard {
+ public:
+  FrameGuard(SharedBufMgr &mgr, const FrameId frameNo)
+      : latch_(mgr.desc(frameNo).latch) {
+    if (lockLatch(latch_, mgr.name_)) mgr.repairFrame(frameNo);
+  }
+
+  ~FrameGuard() { pthread_mutex_unlock(&latch_); }
+
+ private:
+  pthread_mutex_t &latch_;
+};
+
+SharedBufMgr::SharedBufMgr(const std::string &name, std::uint32_t bufs)
+    : name_(name), fd_(-1), base_(nullptr), size_(0), header_(nullptr) {
+  bool created = true;
+  fd_ = shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd_ < 0 && errno == EEXIST) {
+    created = false;
+    fd_ = shm_open(name_.c_str(), O_RDWR, 0600);
+  }
+  if (fd_ < 0) {
+    throw SharedPoolException(name_, std::strerror(errno));
+  }
+
+  if (created) {
+    const std::uint32_t htSize = ((std::uint32_t)(bufs * 1.2) & -2) + 1;
+    const SegmentLayout layout(bufs, htSize);
+    size_ = layout.size;
+    if (ftruncate(fd_, size_) != 0) {
+      close(fd_);
+      shm_unlink(name_.c_str());
+      throw SharedPoolException(name_, std::strerror(errno));
+    }
+  } else {
+    // Wait until the creator has sized the segment.
+    struct stat st;
+    const auto deadline = std::chrono::steady_clock::now() + ATTACH_TIMEOUT;
+    while (fstat(fd_, &st) == 0 && st.st_size == 0 &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    size_ = st.st_size;
+    if (size_ < sizeof(SharedPoolHeader)) {
+      close(fd_);
+      throw SharedPoolException(name_, "segment was never initialized");
+    }
+  }
+
+  void *addr =
+      mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (addr == MAP_FAILED) {
+    close(fd_);
+    throw SharedPoolException(name_, std::strerror(errno));
+  }
+  base_ = static_cast<char *>(addr);
+  header_ = reinterpret_cast<SharedPoolHeader *>(base_);
+
+  if (created) {
+    new (&header_->magic) std::atomic<std::uint64_t>(0);
+    header_->numBufs = bufs;
+    header_->htSize = ((std::uint32_t)(bufs * 1.2) & -2) + 1;
+    new (&header_->clockHand) std::atomic<std::uint32_t>(0);
+    for (std::uint32_t c = 0; c < MAX_CLIENTS; ++c) {
+      header_->clients[c].pid = 0;
+      header_->clients[c].startTime = 0;
+    }
+    initLatch(header_->latch);
+  } else {
+    const auto deadline = std::chrono::steady_clock::now() + ATTACH_TIMEOUT;
+    while (header_->magic.load(std::memory_order_acquire) != POOL_MAGIC) {
+      if (std::chrono::steady_clock::now() >= deadline) {
+        munmap(base_, size_);
+        close(fd_);
+        throw SharedPoolException(name_, "segment was never initialized");
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  const SegmentLayout layout(header_->numBufs, header_->htSize);
+  descs_ = reinterpret_cast<SharedFrameDesc *>(base_ + layout.descs);
+  buckets_ = reinterpret_cast<SharedBucket *>(base_ + layout.buckets);
+  pins_ = reinterpret_cast<std::uint16_t *>(base_ + layout.pins);
+  frames_ = base_ + layout.frames;
+
+  if (created) {
+    for (FrameId i = 0; i < header_->numBufs; ++i) {
+      SharedFrameDesc &d = descs_[i];
+      initLatch(d.latch);
+      initLatch(d.contentLatch);
+      clearTag(d);
+      d.pinCnt = 0;
+      d.next = -1;
+      d.loader = 0;
+      d.inTable = false;
+      d.refbit = false;
+      new (&framePage(i)) Page();
+    }
+    for (std::uint32_t i = 0; i < header_->htSize; ++i) {
+      initLatch(buckets_[i].latch);
+      buckets_[i].head = -1;
+    }
+    // The pin table is zero-filled by ftruncate.
+    header_->magic.store(POOL_MAGIC, std::memory_order_release);
+  }
+
+  // Register as a client, making room by cleaning up after dead ones.
+  LatchGuard latch(*this);
+  reapDeadClientsLocked();
+  client_ = MAX_CLIENTS;
+  for (std::uint32_t c = 0; c < MAX_CLIENTS; ++c) {
+    if (header_->clients[c].pid == 0) {
+      header_->clients[c].pid = getpid();
+      header_->clients[c].startTime = processStartTime(getpid());
+      client_ = c;
+      break;
+    }
+  }
+  if (client_ == MAX_CLIENTS) {
+    munmap(base_, size_);
+    close(fd_);
+    throw SharedPoolException(name_, "all client slots are in use");
+  }
+}
+
+SharedBufMgr::~SharedBufMgr() {
+  try {
+    for (FrameId f = 0; f < header_->numBufs; ++f) {
+      FrameGuard frame(*this, f);
+      std::uint16_t &pins = clientPins(client_, f);
+      desc(f).pinCnt -= pins;
+      pins = 0;
+    }
+    LatchGuard latch(*this);
+    header_->clients[client_].pid = 0;
+  } catch (...) {
+  }
+  files_.clear();
+  munmap(base_, size_);
+  close(fd_);
+}
+
+void SharedBufMgr::destroy(const std::string &name) {
+  shm_unlink(name.c_str());
+}
+
+std::uint32_t SharedBufMgr::numBufs() const { return header_->numBufs; }
+
+SharedFrameDesc &SharedBufMgr::desc(const FrameId frameNo) const {
+  return descs_[frameNo];
+}
+
+Page &SharedBufMgr::framePage(const FrameId frameNo) const {
+  return *reinterpret_cast<Page *>(
+      frames_ + static_cast<std::size_t>(frameNo) * Page::SIZE);
+}
+
+std::uint16_t &SharedBufMgr::clientPins(const std::uint32_t client,
+                                        const FrameId frameNo) const {
+  return pins_[static_cast<std::size_t>(client) * header_->numBufs + frameNo];
+}
+
+std::uint32_t SharedBufMgr::bucketIndex(const char *path,
+                                        const PageId pageNo) const {
+  return hashPage(path, pageNo) % header_->htSize;
+}
+
+const std::string &SharedBufMgr::registerFile(File &file) {
+  auto known = paths_.find(file.filename());
+  if (known != paths_.end()) {
+    return known->second;
+  }
+
+  const std::string path = absolutePath(file.filename());
+  if (path.size() >= MAX_FILENAME) {
+    throw SharedPoolException(name_, "file name too long: " + path);
+  }
+  if (file.isCompressed()) {
+    throw SharedPoolException(name_, "compressed file cannot be shared: " +
+                                         path);
+  }
+  // Only the first name a file is given under is kept open, so the process
+  // has a single stream for it.
+  files_.emplace(path, file);
+  return paths_.emplace(file.filename(), path).first->second;
+}
+
+File &SharedBufMgr::fileFor(const std::string &path) {
+  auto file = files_.find(path);
+  if (file == files_.end()) {
+    file = files_.emplace(path, File::open(path)).first;
+  }
+  return file->second;
+}
+
+bool SharedBufMgr::lookup(const std::string &path, const PageId pageNo,
+                          FrameId &frameNo) const {
+  const SharedBucket &bucket = buckets_[bucketIndex(path.c_str(), pageNo)];
+  for (std::int32_t f = bucket.head; f >= 0; f = desc(f).next) {
+    if (desc(f).pageNo == pageNo && path == desc(f).filename) {
+      frameNo = f;
+      return true;
+    }
+  }
+  return false;
+}
+
+void SharedBufMgr::insert(const FrameId frameNo) {
+  SharedFrameDesc &d = desc(frameNo);
+  std::int32_t &head = buckets_[bucketIndex(d.filename, d.pageNo)].head;
+  d.next = head;
+  head = frameNo;
+  d.inTable = true;
+}
+
+void SharedBufMgr::remove(const FrameId frameNo) {
+  SharedFrameDesc &d = desc(frameNo);
+  std::int32_t *link = &buckets_[bucketIndex(d.filename, d.pageNo)].head;
+  while (*link >= 0) {
+    if (*link == static_cast<std::int32_t>(frameNo)) {
+      *link = d.next;
+      break;
+    }
+    link = &desc(*link).next;
+  }
+  d.next = -1;
+  d.inTable = false;
+}
+
+void SharedBufMgr::pinLocked(const FrameId frameNo) {
+  SharedFrameDesc &d = desc(frameNo);
+  d.pinCnt++;
+  d.refbit = true;
+  clientPins(client_, frameNo)++;
+}
+
+void SharedBufMgr::unpinLocked(const FrameId frameNo) {
+  desc(frameNo).pinCnt--;
+  clientPins(client_, frameNo)--;
+}
+
+FrameId SharedBufMgr::pinnedFrame(File &file, const PageId pageNo) {
+  const std::string &path = registerFile(file);
+  BucketGuard bucket(*this, bucketIndex(path.c_str(), pageNo));
+  FrameId frameNo = 0;
+  if (lookup(path, pageNo, frameNo)) {
+    FrameGuard frame(*this, frameNo);
+    if (clientPins(client_, frameNo) > 0) {
+      return frameNo;
+    }
+  }
+  throw PageNotPinnedException(file.filename(), pageNo, frameNo);
+}
+
+void SharedBufMgr::writeBack(const FrameId frameNo, const std::string &path) {
+  // A process changing the page holds its content latch, so the copy taken
+  // under it is never torn.
+  Page image;
+  {
+    pthread_mutex_t &latch = desc(frameNo).contentLatch;
+    lockLatch(latch, name_);
+    image = framePage(frameNo);
+    pthread_mutex_unlock(&latch);
+  }
+  fileFor(path).writePage(image);
+}
+
+bool SharedBufMgr::evictClaimed(const FrameId frameNo) {
+  SharedFrameDesc &d = desc(frameNo);
+  std::string path;
+  PageId pageNo;
+  bool dirty;
+  {
+    FrameGuard frame(*this, frameNo);
+    path = d.filename;
+    pageNo = d.pageNo;
+    dirty = d.dirty;
+    // A process dirtying the page during the write sets it again.
+    d.dirty = false;
+  }
+  if (dirty) {
+    try {
+      writeBack(frameNo, path);
+    } catch (...) {
+      FrameGuard frame(*this, frameNo);
+      d.dirty = true;
+      unpinLocked(frameNo);
+      throw;
+    }
+  }
+
+  // Another process may have found the page and pinned it meanwhile.
+  BucketGuard bucket(*this, bucketIndex(path.c_str(), pageNo));
+  FrameGuard frame(*this, frameNo);
+  if (d.pinCnt == 1 && !d.dirty) {
+    remove(frameNo);
+    clearTag(d);
+    return true;
+  }
+  unpinLocked(frameNo);
+  return false;
+}
+
+FrameId SharedBufMgr::allocBuf() {
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    // Same two-turn clock as BufMgr::allocBuf(), with a shared hand.
+    for (std::uint32_t i = 0; i < 2 * header_->numBufs; ++i) {
+      const FrameId f = header_->clockHand.fetch_add(1) % header_->numBufs;
+      bool resident;
+      {
+        FrameGuard frame(*this, f);
+        SharedFrameDesc &d = desc(f);
+        if (d.pinCnt > 0 || d.loading) continue;
+        if (d.inTable && d.refbit) {
+          d.refbit = false;
+          continue;
+        }
+        // The pin keeps other processes from picking the frame too.
+        pinLocked(f);
+        resident = d.inTable;
+      }
+      if (!resident || evictClaimed(f)) return f;
+    }
+    // Everything is pinned; pins of crashed clients may be the reason.
+    if (reapDeadClients() == 0) break;
+  }
+  throw BufferExceededException();
+}
+
+void SharedBufMgr::load(const FrameId frameNo, File &file,
+                        const PageId pageNo) {
+  try {
+    framePage(frameNo) = file.readPage(pageNo);
+  } catch (...) {
+    abortLoad(frameNo);
+    FrameGuard frame(*this, frameNo);
+    unpinLocked(frameNo);
+    throw;
+  }
+  FrameGuard frame(*this, frameNo);
+  desc(frameNo).valid = true;
+  desc(frameNo).loading = false;
+}
+
+void SharedBufMgr::abortLoad(const FrameId frameNo) {
+  SharedFrameDesc &d = desc(frameNo);
+  std::uint32_t index;
+  {
+    FrameGuard frame(*this, frameNo);
+    if (!d.loading) return;
+    index = bucketIndex(d.filename, d.pageNo);
+  }
+  BucketGuard bucket(*this, index);
+  FrameGuard frame(*this, frameNo);
+  if (!d.loading) return;
+  if (d.inTable) remove(frameNo);
+  clearTag(d);
+}
+
+bool SharedBufMgr::waitForLoad(const FrameId frameNo) {
+  for (std::uint32_t polls = 1;; ++polls) {
+    {
+      FrameGuard frame(*this, frameNo);
+      if (!desc(frameNo).loading) return desc(frameNo).valid;
+    }
+    // The loader may have died part way.
+    if (polls % LOAD_REAP_INTERVAL == 0) reapDeadClients();
+    std::this_thread::sleep_for(LOAD_POLL);
+  }
+}
+
+void SharedBufMgr::readPage(File &file, const PageId pageNo, Page *&page) {
+  const std::string &path = registerFile(file);
+  const std::uint32_t index = bucketIndex(path.c_str(), pageNo);
+  for (;;) {
+    FrameId frameNo;
+    bool found;
+    {
+      BucketGuard bucket(*this, index);
+      found = lookup(path, pageNo, frameNo);
+      if (found) {
+        FrameGuard frame(*this, frameNo);
+        pinLocked(frameNo);
+      }
+    }
+
+    if (!found) {
+      // The victim is chosen, and written back, with no latch held.
+      const FrameId victim = allocBuf();
+      BucketGuard bucket(*this, index);
+      found = lookup(path, pageNo, frameNo);
+      if (found) {
+        // Another process read the page meanwhile.
+        {
+          FrameGuard frame(*this, victim);
+          unpinLocked(victim);
+        }
+        FrameGuard frame(*this, frameNo);
+        pinLocked(frameNo);
+      } else {
+        FrameGuard frame(*this, victim);
+        SharedFrameDesc &d = desc(victim);
+        std::strcpy(d.filename, path.c_str());
+        d.pageNo = pageNo;
+        d.loading = true;
+        d.loader = client_;
+        insert(victim);
+        frameNo = victim;
+      }
+    }
+
+    if (!found) {
+      // Processes hitting the page while it is read wait for it.
+      load(frameNo, file, pageNo);
+      page = &framePage(frameNo);
+      return;
+    }
+    if (waitForLoad(frameNo)) {
+      page = &framePage(frameNo);
+      return;
+    }
+    // Its loader failed; reading it again reports why.
+    FrameGuard frame(*this, frameNo);
+    unpinLocked(frameNo);
+  }
+}
+
+void SharedBufMgr::unPinPage(File &file, const PageId pageNo,
+                             const bool dirty) {
+  const std::string &path = registerFile(file);
+  BucketGuard bucket(*this, bucketIndex(path.c_str(), pageNo));
+
+  FrameId frameNo;
+  if (!lookup(path, pageNo, frameNo)) {
+    return;
+  }
+  FrameGuard frame(*this, frameNo);
+  if (clientPins(client_, frameNo) == 0) {
+    throw PageNotPinnedException(file.filename(), pageNo, frameNo);
+  }
+  if (dirty) {
+    desc(frameNo).dirty = true;
+  }
+  unpinLocked(frameNo);
+}
+
+void SharedBufMgr::allocPage(File &file, PageId &pageNo, Page *&page) {
+  const std::string &path = registerFile(file);
+  const FrameId frameNo = allocBuf();
+  Page &framed = framePage(frameNo);
+  try {
+    FileLock lock(path);
+    framed = file.allocatePage();
+  } catch (...) {
+    FrameGuard frame(*this, frameNo);
+    unpinLocked(frameNo);
+    throw;
+  }
+  pageNo = framed.page_number();
+
+  BucketGuard bucket(*this, bucketIndex(path.c_str(), pageNo));
+  FrameGuard frame(*this, frameNo);
+  SharedFrameDesc &d = desc(frameNo);
+  std::strcpy(d.filename, path.c_str());
+  d.pageNo = pageNo;
+  d.valid = true;
+  insert(frameNo);
+  page = &framed;
+}
+
+void SharedBufMgr::flushFile(File &file) {
+  const std::string &path = registerFile(file);
+
+  for (FrameId f = 0; f < header_->numBufs; ++f) {
+    FrameGuard frame(*this, f);
+    const SharedFrameDesc &d = desc(f);
+    if (d.inTable && d.pinCnt > 0 && path == d.filename) {
+      throw PagePinnedException(file.filename(), d.pageNo, f);
+    }
+  }
+
+  for (FrameId f = 0; f < header_->numBufs; ++f) {
+    PageId pageNo;
+    {
+      FrameGuard frame(*this, f);
+      SharedFrameDesc &d = desc(f);
+      if (!d.inTable || path != d.filename) continue;
+      if (d.pinCnt > 0) {
+        throw PagePinnedException(file.filename(), d.pageNo, f);
+      }
+      pinLocked(f);
+      pageNo = d.pageNo;
+    }
+    if (!evictClaimed(f)) {
+      throw PagePinnedException(file.filename(), pageNo, f);
+    }
+    FrameGuard frame(*this, f);
+    unpinLocked(f);
+  }
+}
+
+void SharedBufMgr::disposePage(File &file, const PageId pageNo) {
+  const std::string &path = registerFile(file);
+  {
+    BucketGuard bucket(*this, bucketIndex(path.c_str(), pageNo));
+    FrameId frameNo;
+    if (lookup(path, pageNo, frameNo)) {
+      FrameGuard frame(*this, frameNo);
+      SharedFrameDesc &d = desc(frameNo);
+      // Other processes' pins are theirs to release; only this process's
+      // own go with the page.
+      std::uint16_t &pins = clientPins(client_, frameNo);
+      if (d.pinCnt > pins) {
+        throw PagePinnedException(file.filename(), pageNo, frameNo);
+      }
+      d.pinCnt -= pins;
+      pins = 0;
+      remove(frameNo);
+      clearTag(d);
+    }
+  }
+  FileLock lock(path);
+  file.deletePage(pageNo);
+}
+
+void SharedBufMgr::latchPage(File &file, const PageId pageNo) {
+  lockLatch(desc(pinnedFrame(file, pageNo)).contentLatch, name_);
+}
+
+void SharedBufMgr::unlatchPage(File &file, const PageId pageNo) {
+  pthread_mutex_unlock(&desc(pinnedFrame(file, pageNo)).contentLatch);
+}
+
+std::uint32_t SharedBufMgr::reapDeadClients() {
+  LatchGuard latch(*this);
+  return reapDeadClientsLocked();
+}
+
+std::uint32_t SharedBufMgr::reapDeadClientsLocked() {
+  std::uint32_t reaped = 0;
+  for (std::uint32_t c = 0; c < MAX_CLIENTS; ++c) {
+    SharedClient &client = header_->clients[c];
+    if (client.pid == 0 || clientAlive(client)) continue;
+
+    for (FrameId f = 0; f < header_->numBufs; ++f) {
+      bool loading;
+      {
+        FrameGuard frame(*this, f);
+        SharedFrameDesc &d = desc(f);
+        std::uint16_t &pins = clientPins(c, f);
+        d.pinCnt -= pins;
+        pins = 0;
+        loading = d.loading && d.loader == c;
+      }
+      // Processes waiting for the page find it gone and read it themselves.
+      if (loading) abortLoad(f);
+    }
+    client.pid = 0;
+    ++reaped;
+  }
+  return reaped;
+}
+
+void SharedBufMgr::repairBucket(const std::uint32_t index) {
+  std::int32_t &head = buckets_[index].head;
+  head = -1;
+  for (FrameId f = 0; f < header_->numBufs; ++f) {
+    FrameGuard frame(*this, f);
+    SharedFrameDesc &d = desc(f);
+    if (d.inTable && bucketIndex(d.filename, d.pageNo) == index) {
+      d.next = head;
+      head = f;
+    }
+  }
+}
+
+void SharedBufMgr::repairFrame(const FrameId frameNo) {
+  SharedFrameDesc &d = desc(frameNo);
+  d.pinCnt = 0;
+  for (std::uint32_t c = 0; c < MAX_CLIENTS; ++c) {
+    d.pinCnt += clientPins(c, frameNo);
+  }
+}
+
+}  // namespace badgerdb
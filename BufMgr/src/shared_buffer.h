@@ -0,0 +1,361 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+#include "file.h"
+
+namespace badgerdb {
+
+struct SharedPoolHeader;
+struct SharedBucket;
+struct SharedFrameDesc;
+
+/**
+ * @brief Buffer manager whose pool is shared by all processes on a host.
+ *
+ * The frame array, the frame descriptor table and the page table live in a
+ * POSIX shared memory segment created with shm_open() and mapped by every
+ * process that constructs a SharedBufMgr with the same name.  A page read by
+ * one process is a hit for all others.  Frames hold Page objects, and a pin
+ * returns a pointer to the page in the shared frame itself, so every process
+ * sees the same page and a hit copies nothing.
+ *
+ * The shared state is protected by process-shared, robust latches: one per
+ * hash bucket for its chain, and one per frame for its descriptor and pins.
+ * A page is read into a frame marked as loading with no latch held, so misses
+ * in different processes proceed in parallel; processes hitting a page being
+ * loaded wait for it.  Victims are written back without latches as well.
+ * Each frame also has a content latch, taken with latchPage(), which
+ * processes changing a page, or reading it while others may change it, must
+ * hold, just as threads sharing a BufMgr page must coordinate.  Allocating
+ * and deleting pages is serialized among processes by a lock on the file.
+ *
+ * Pages are identified by the absolute path of their file, so processes may
+ * name files relative to different working directories.  The pool keeps one
+ * File per path, the first one it was given, and writes pages back through
+ * it; files stay open until the pool is destroyed.  Compressed files cannot be
+ * shared, as each process would allocate slots from its own page map.
+ *
+ * Each process registers in a client slot, and pins are accounted per client
+ * and frame.  If a client dies while holding pins, its slot is reclaimed and
+ * its pins released, and a page it was loading dropped, by the next process
+ * that attaches, runs out of frames, or waits for that page (see
+ * reapDeadClients()).  A client is known by its process id and the start time
+ * of its process, so a new process reusing the id is not mistaken for it.  A
+ * latch whose owner died is repaired by the next process taking it: a hash
+ * chain is rebuilt from the frames in the table, and a frame's pin count from
+ * the per-client pins.
+ *
+ * @warning A SharedBufMgr object is not threadsafe; use one per thread.
+ */
+class SharedBufMgr {
+ public:
+  /**
+   * Maximum number of processes attached to one pool at a time.
+   */
+  static const std::uint32_t MAX_CLIENTS = 64;
+
+  /**
+   * Maximum length of a file path stored in a frame descriptor, including the
+   * terminating null byte.
+   */
+  static const std::size_t MAX_FILENAME = 256;
+
+  /**
+   * Attaches to the shared pool with the given name, creating it with the
+   * given number of frames if it does not exist yet.  When attaching to an
+   * existing pool its size is used and bufs is ignored.
+   *
+   * @param name  Name of the shared memory segment, e.g. "/badgerdb_pool".
+   * @param bufs  Number of frames in a newly created pool.
+   * @throws  SharedPoolException If the segment cannot be created or mapped,
+   *                              or all client slots are taken.
+   */
+  SharedBufMgr(const std::string &name, std::uint32_t bufs);
+
+  /**
+   * Releases every pin still held by this process and detaches from the
+   * pool.  The segment itself stays around for other processes.
+   */
+  ~SharedBufMgr();
+
+  SharedBufMgr(const SharedBufMgr &) = delete;
+  SharedBufMgr &operator=(const SharedBufMgr &) = delete;
+
+  /**
+   * Removes the shared memory segment with the given name.  Processes still
+   * attached keep their mapping until they detach.
+   *
+   * @param name  Name of the shared memory segment.
+   */
+  static void destroy(const std::string &name);
+
+  /**
+   * Reads the given page into the shared pool and pins it.
+   *
+   * @param file   	File object
+   * @param pageNo  Page number in the file to be read
+   * @param page  	Reference to page pointer, set to the page in its frame
+   * @throws  SharedPoolException If the file is compressed or its path is
+   *                              too long
+   */
+  void readPage(File &file, const PageId pageNo, Page *&page);
+
+  /**
+   * Unpins a page pinned by this process.
+   *
+   * @param file   	File object
+   * @param pageNo  Page number
+   * @param dirty		True if the page has been modified
+   * @throws  PageNotPinnedException If this process does not hold a pin
+   */
+  void unPinPage(File &file, const PageId pageNo, const bool dirty);
+
+  /**
+   * Allocates a new page in the file and pins it in the shared pool.
+   *
+   * @param file   	File object
+   * @param pageNo  Page number of the new page, returned by reference
+   * @param page  	Reference to page pointer, set to the page in its frame
+   */
+  void allocPage(File &file, PageId &pageNo, Page *&page);
+
+  /**
+   * Writes out all dirty pages of the file and drops them from the pool.
+   *
+   * @param file   	File object
+   * @throws  PagePinnedException If any process has a page of the file pinned
+   */
+  void flushFile(File &file);
+
+  /**
+   * Deletes a page from the file and from the pool if present.  Pins this
+   * process holds on the page are released.
+   *
+   * @param file   	File object
+   * @param pageNo  Page number
+   * @throws  PagePinnedException If another process has the page pinned
+   */
+  void disposePage(File &file, const PageId pageNo);
+
+  /**
+   * Takes the content latch of a page this process has pinned, waiting while
+   * another process holds it.  If its holder died, the latch is taken over
+   * and the page may hold part of that process's changes.
+   *
+   * @param file   	File object
+   * @param pageNo  Page number
+   * @throws  PageNotPinnedException If this process does not hold a pin
+   */
+  void latchPage(File &file, const PageId pageNo);
+
+  /**
+   * Releases the content latch of a page taken with latchPage().
+   *
+   * @param file   	File object
+   * @param pageNo  Page number
+   * @throws  PageNotPinnedException If this process does not hold a pin
+   */
+  void unlatchPage(File &file, const PageId pageNo);
+
+  /**
+   * Releases the pins and client slots of processes which no longer exist.
+   *
+   * @return  Number of dead clients that were cleaned up.
+   */
+  std::uint32_t reapDeadClients();
+
+  /**
+   * Returns the number of frames in the shared pool.
+   */
+  std::uint32_t numBufs() const;
+
+ private:
+  /**
+   * Hold the pool latch, which protects the client table, a bucket latch or
+   * a frame latch for the lifetime of the object.  Each cleans up after the
+   * previous owner of its latch if that owner died holding it.  Latches are
+   * taken in that order, and at most one of each kind at a time.
+   */
+  class LatchGuard;
+  class BucketGuard;
+  class FrameGuard;
+
+  /**
+   * Returns the descriptor of the given frame.
+   */
+  SharedFrameDesc &desc(const FrameId frameNo) const;
+
+  /**
+   * Returns the page held in the given frame.
+   */
+  Page &framePage(const FrameId frameNo) const;
+
+  /**
+   * Returns the pin count a client holds on the given frame.
+   */
+  std::uint16_t &clientPins(const std::uint32_t client,
+                            const FrameId frameNo) const;
+
+  /**
+   * Returns the hash bucket of the given file path and page.
+   */
+  std::uint32_t bucketIndex(const char *path, const PageId pageNo) const;
+
+  /**
+   * Returns the absolute path of a file, checking it can be shared and
+   * remembering the File to write its pages back through.
+   *
+   * @throws  SharedPoolException If the file is compressed or its path is
+   *                              too long
+   */
+  const std::string &registerFile(File &file);
+
+  /**
+   * Returns the File pages of the given path are written through, opening
+   * it if this process was never given it.
+   */
+  File &fileFor(const std::string &path);
+
+  /**
+   * Looks up the frame holding the given page.  Bucket latch must be held.
+   *
+   * @return  True if the page is in the page table.
+   */
+  bool lookup(const std::string &path, const PageId pageNo,
+              FrameId &frameNo) const;
+
+  /**
+   * Inserts and removes frames from the page table.  Bucket and frame latch
+   * must be held.
+   */
+  void insert(const FrameId frameNo);
+  void remove(const FrameId frameNo);
+
+  /**
+   * Adds and releases a pin of this client on a frame.  Frame latch must be
+   * held.
+   */
+  void pinLocked(const FrameId frameNo);
+  void unpinLocked(const FrameId frameNo);
+
+  /**
+   * Returns the frame of a page this process has pinned.
+   *
+   * @throws  PageNotPinnedException If this process does not hold a pin
+   */
+  FrameId pinnedFrame(File &file, const PageId pageNo);
+
+  /**
+   * Picks a frame with the shared clock and pins it, writing back and
+   * dropping the page it held.  No latch may be held.
+   *
+   * @return  A frame pinned by this client and not in the page table.
+   * @throws  BufferExceededException If every frame is pinned
+   */
+  FrameId allocBuf();
+
+  /**
+   * Writes back and drops the page in a frame this client pinned while no
+   * one else had it pinned.  If another process pins or dirties the page
+   * meanwhile, the pin is released instead.  No latch may be held.
+   *
+   * @return  True if the frame was emptied and is still pinned.
+   */
+  bool evictClaimed(const FrameId frameNo);
+
+  /**
+   * Writes the page in a frame back to the file at the given path.  No latch
+   * may be held.
+   */
+  void writeBack(const FrameId frameNo, const std::string &path);
+
+  /**
+   * Reads a page into a frame this client inserted into the page table as
+   * loading, then marks it valid.  No latch may be held.
+   */
+  void load(const FrameId frameNo, File &file, const PageId pageNo);
+
+  /**
+   * Drops a page whose load failed or whose loader died.  Processes waiting
+   * for it find it invalid.  No latch may be held.
+   */
+  void abortLoad(const FrameId frameNo);
+
+  /**
+   * Waits until a frame pinned by this client is no longer loading.  No
+   * latch may be held.
+   *
+   * @return  True if the page was loaded, false if its load was aborted.
+   */
+  bool waitForLoad(const FrameId frameNo);
+
+  /**
+   * Releases dead clients' pins.  Pool latch must be held.
+   */
+  std::uint32_t reapDeadClientsLocked();
+
+  /**
+   * Rebuild a hash chain from the frames in the page table, and a frame's
+   * pin count from the per-client pins, after the owner of their latch died
+   * part way through changing them.  Bucket or frame latch must be held.
+   */
+  void repairBucket(const std::uint32_t index);
+  void repairFrame(const FrameId frameNo);
+
+  /**
+   * Name of the shared memory segment.
+   */
+  std::string name_;
+
+  /**
+   * Descriptor of the shared memory object.
+   */
+  int fd_;
+
+  /**
+   * Base address and size of the mapping.
+   */
+  char *base_;
+  std::size_t size_;
+
+  /**
+   * Pointers into the mapping.
+   */
+  SharedPoolHeader *header_;
+  SharedFrameDesc *descs_;
+  SharedBucket *buckets_;
+  std::uint16_t *pins_;
+  char *frames_;
+
+  /**
+   * Client slot of this process.
+   */
+  std::uint32_t client_;
+
+  /**
+   * Absolute path of each file name this process has passed in.
+   */
+  std::unordered_map<std::string, std::string> paths_;
+
+  /**
+   * File each path's pages are written through.
+   */
+  std::map<std::string, File> files_;
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,138 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace badgerdb {
+
+/**
+ * @brief A fixed set of 64-bit event counters, sharded by thread.
+ *
+ * Each thread updates the shard it is assigned on first use, so threads
+ * counting the same events do not contend for one cache line, and a reader
+ * adds the shards up.  Updates are relaxed atomics: a sum read while counters
+ * are being updated is not a consistent cut, but no update is ever lost.
+ *
+ * @tparam N  Number of counters.
+ *
+ * This class is threadsafe.
+ */
+template <std::size_t N>
+class ShardedCounters {
+ public:
+  /**
+   * Number of shards; threads beyond that share shards.
+   */
+  static const std::size_t SHARDS = 16;
+
+  ShardedCounters() { reset(); }
+
+  ShardedCounters(const ShardedCounters &) = delete;
+  ShardedCounters &operator=(const ShardedCounters &) = delete;
+
+  /**
+   * Adds to a counter.
+   *
+   * @param counter Index of the counter.
+   * @param n       Amount to add.
+   */
+  void add(const std::size_t counter, const std::uint64_t n = 1) {
+    shards_[shardIndex()].values[counter].fetch_add(n,
+                                                   std::memory_order_relaxed);
+  }
+
+  /**
+   * Raises a counter to the given value if it is lower, making it a maximum
+   * rather than a sum.  Read such a counter with max().
+   *
+   * @param counter Index of the counter.
+   * @param value   Value observed.
+   */
+  void raise(const std::size_t counter, const std::uint64_t value) {
+    std::atomic<std::uint64_t> &slot = shards_[shardIndex()].values[counter];
+    std::uint64_t current = slot.load(std::memory_order_relaxed);
+    while (current < value &&
+           !slot.compare_exchange_weak(current, value,
+                                       std::memory_order_relaxed)) {
+    }
+  }
+
+  /**
+   * Returns the sum of a counter over all shards.
+   */
+  std::uint64_t sum(const std::size_t counter) const {
+    std::uint64_t total = 0;
+    for (const Shard &shard : shards_) {
+      total += shard.values[counter].load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+  /**
+   * Returns the maximum of a counter over all shards.
+   */
+  std::uint64_t max(const std::size_t counter) const {
+    std::uint64_t highest = 0;
+    for (const Shard &shard : shards_) {
+      const std::uint64_t value =
+          shard.values[counter].load(std::memory_order_relaxed);
+      if (value > highest) highest = value;
+    }
+    return highest;
+  }
+
+  /**
+   * Sets every counter back to 0.
+   */
+  void reset() {
+    for (Shard &shard : shards_) {
+      for (std::atomic<std::uint64_t> &value : shard.values) {
+        value.store(0, std::memory_order_relaxed);
+      }
+    }
+  }
+
+ private:
+  /**
+   * Size of a cache line, which shards are padded to.
+   */
+  static const std::size_t CACHE_LINE = 64;
+
+  /**
+   * @brief The counters updated by one group of threads, followed by a full
+   * cache line of padding so that no two shards' counters share a line
+   * however the object is aligned.
+   */
+  struct Shard {
+    std::atomic<std::uint64_t> values[N];
+    char padding[CACHE_LINE];
+  };
+
+  /**
+   * Returns the shard of the calling thread, handing shards out round-robin.
+   */
+  static std::size_t shardIndex() {
+    static std::atomic<std::size_t> nextShard(0);
+    thread_local const std::size_t index =
+        nextShard.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+    return index;
+  }
+
+  /**
+   * One extra cache line in front, so the first shard does not share a
+   * line with whatever precedes the counters.
+   */
+  char leading_[CACHE_LINE];
+  Shard shards_[SHARDS];
+};
+
+}  // namespace badgerdb
@@ -0,0 +1,137 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "page.h"
+#include "types.h"
+
+namespace badgerdb {
+
+class BufDesc;
+class BufMgr;
+
+/**
+ * @brief A swizzlable reference from one page to another.
+ *
+ * A swip holds a single 64-bit word which is either the on-disk page number of
+ * the referenced page (unswizzled) or, while that page is resident in the
+ * buffer pool, a direct pointer to the descriptor of the frame holding it
+ * (swizzled).  Unswizzled values carry a tag in the lowest bit, which is never
+ * set in a frame descriptor pointer.
+ *
+ * Following a swizzled swip with BufMgr::readPage() pins the frame directly,
+ * without a lookup in the buffer hash table.  The buffer manager remembers
+ * every swip it swizzled and turns them back into page numbers when the frame
+ * is evicted, flushed or disposed of.
+ *
+ * Because the buffer manager keeps a pointer to each swizzled swip, swips can
+ * be neither copied nor moved.  A swip which is still swizzled must be passed to
+ * BufMgr::unswizzle() before it is destroyed.  For the same reason swips live
+ * in memory owned by the caller and cannot be stored in a page: a page image
+ * is copied when it is written back or evicted, which would leave the buffer
+ * manager pointing into the old frame and the copy holding a pointer.  A page
+ * stores the page number and the caller keeps a Swip for it alongside.
+ *
+ * @warning This class is not threadsafe.
+ */
+class Swip {
+ public:
+  /**
+   * Constructs a swip referencing no page.
+   */
+  Swip() : value_(tag(Page::INVALID_NUMBER)) {}
+
+  /**
+   * Constructs an unswizzled swip referencing the given page.
+   *
+   * @param pageNo  Number of the referenced page.
+   */
+  explicit Swip(const PageId pageNo) : value_(tag(pageNo)) {}
+
+  Swip(const Swip &) = delete;
+  Swip &operator=(const Swip &) = delete;
+
+  /**
+   * Returns true if this swip currently points directly at a buffer frame.
+   *
+   * @return  True if swizzled.
+   */
+  bool isSwizzled() const { return (value_ & UNSWIZZLED_TAG) == 0; }
+
+  /**
+   * Returns the number of the referenced page, whether or not the swip is
+   * swizzled.
+   *
+   * @return  Page number of the referenced page.
+   */
+  PageId pageId() const;
+
+  /**
+   * Makes this swip reference another page.  The swip must not be swizzled.
+   *
+   * @param pageNo  Number of the referenced page.
+   */
+  void set(const PageId pageNo) { value_ = tag(pageNo); }
+
+  /**
+   * Returns the raw 64-bit representation of this swip.
+   *
+   * @return  Raw swip value.
+   */
+  std::uint64_t raw() const { return value_; }
+
+ private:
+  friend class BufDesc;
+  friend class BufMgr;
+
+  /**
+   * Tag bit set in every unswizzled swip.
+   */
+  static const std::uint64_t UNSWIZZLED_TAG = 1;
+
+  /**
+   * Encodes a page number as an unswizzled swip value.
+   *
+   * @param pageNo  Page number to encode.
+   * @return  Tagged swip value.
+   */
+  static std::uint64_t tag(const PageId pageNo) {
+    return (static_cast<std::uint64_t>(pageNo) << 1) | UNSWIZZLED_TAG;
+  }
+
+  /**
+   * Returns the frame descriptor of a swizzled swip.
+   *
+   * @return  Frame descriptor the swip points at.
+   */
+  BufDesc *desc() const { return reinterpret_cast<BufDesc *>(value_); }
+
+  /**
+   * Points this swip directly at a frame descriptor.
+   *
+   * @param desc  Descriptor of the frame holding the referenced page.
+   */
+  void swizzle(BufDesc *desc) { value_ = reinterpret_cast<std::uint64_t>(desc); }
+
+  /**
+   * Turns this swip back into a page number.
+   *
+   * @param pageNo  Number of the referenced page.
+   */
+  void unswizzle(const PageId pageNo) { value_ = tag(pageNo); }
+
+  /**
+   * Either a tagged page number or a frame descriptor pointer.
+   */
+  std::uint64_t value_;
+};
+
+}  // namespace badgerdb
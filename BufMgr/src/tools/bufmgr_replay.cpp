@@ -0,0 +1,236 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+/**
+ * Replays an access trace recorded by BufMgr::startAccessTrace() against
+ * buffer pools of the given sizes and reports the hit ratio and throughput
+ * of each:
+ *
+ *   bufmgr_replay TRACE NUMBUFS [NUMBUFS...]
+ *
+ * The traced files are not touched.  Each replay runs against scratch files
+ * in the current directory which are filled with as many pages as the trace
+ * reads without allocating them first, and removed afterwards.  Requests
+ * which fail, such as those made invalid by records dropped from the trace,
+ * are counted and skipped.
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "access_trace.h"
+#include "buffer.h"
+#include "exceptions/badgerdb_exception.h"
+#include "file.h"
+#include "page.h"
+
+using namespace badgerdb;
+
+namespace {
+
+/**
+ * @brief What a trace needs before it can be replayed.
+ */
+struct TraceSummary {
+  /**
+   * Names of the traced files, by id
+   */
+  std::map<std::uint32_t, std::string> files;
+
+  /**
+   * Highest page of each file read before the trace allocates it
+   */
+  std::map<std::uint32_t, PageId> existingPages;
+
+  /**
+   * Requests in the trace, reads among them and reads which were hits
+   */
+  std::uint64_t requests = 0;
+  std::uint64_t reads = 0;
+  std::uint64_t hits = 0;
+
+  /**
+   * Time the trace spans
+   */
+  std::uint64_t durationNs = 0;
+};
+
+/**
+ * @brief Outcome of one replay.
+ */
+struct ReplayResult {
+  BufStats stats;
+  std::uint64_t failed = 0;
+  double seconds = 0;
+};
+
+/**
+ * Reads through a trace to find the pages it expects to exist.
+ */
+bool summarize(const std::string &path, TraceSummary &summary) {
+  AccessTraceReader reader(path);
+  if (!reader.good()) return false;
+
+  std::set<std::pair<std::uint32_t, PageId>> allocated;
+  TraceRecord record;
+  while (reader.next(record)) {
+    ++summary.requests;
+    summary.durationNs = record.timestampNs;
+    const std::pair<std::uint32_t, PageId> key(record.fileId, record.pageNo);
+    if (record.op == TraceRecord::ALLOC) {
+      allocated.insert(key);
+    } else if (record.op == TraceRecord::READ) {
+      ++summary.reads;
+      if (record.flags & TraceRecord::HIT) ++summary.hits;
+      if (!allocated.count(key)) {
+        PageId &existing = summary.existingPages[record.fileId];
+        if (record.pageNo > existing) existing = record.pageNo;
+      }
+    }
+  }
+  summary.files = reader.files();
+  return true;
+}
+
+/**
+ * Returns the scratch file standing in for a traced file.
+ */
+std::string scratchName(std::uint32_t fileId) {
+  return "bufmgr_replay." + std::to_string(fileId) + ".tmp";
+}
+
+/**
+ * Replays a trace against a pool of numBufs frames.
+ */
+ReplayResult replay(const std::string &path, const TraceSummary &summary,
+                    std::uint32_t numBufs) {
+  std::map<std::uint32_t, std::unique_ptr<File>> files;
+  for (const auto &traced : summary.files) {
+    const std::string name = scratchName(traced.first);
+    if (File::exists(name)) File::remove(name);
+    files[traced.first].reset(new File(File::create(name)));
+
+    const auto existing = summary.existingPages.find(traced.first);
+    if (existing == summary.existingPages.end()) continue;
+    for (PageId last = 0; last < existing->second;) {
+      last = files[traced.first]->allocatePage().page_number();
+    }
+  }
+
+  // Pages allocated during the replay may get other numbers than they had
+  // when traced.
+  std::map<std::pair<std::uint32_t, PageId>, PageId> renumbered;
+  ReplayResult result;
+  {
+    BufMgr bufMgr(numBufs);
+    const BufStats before = bufMgr.getBufStats();
+    const auto start = std::chrono::steady_clock::now();
+
+    AccessTraceReader reader(path);
+    TraceRecord record;
+    while (reader.next(record)) {
+      File &file = *files[record.fileId];
+      const std::pair<std::uint32_t, PageId> key(record.fileId, record.pageNo);
+      const auto mapped = renumbered.find(key);
+      const PageId pageNo =
+          mapped != renumbered.end() ? mapped->second : record.pageNo;
+      Page *page;
+      try {
+        switch (record.op) {
+          case TraceRecord::READ:
+            bufMgr.readPage(file, pageNo, page);
+            break;
+          case TraceRecord::UNPIN:
+            bufMgr.unPinPage(file, pageNo,
+                             (record.flags & TraceRecord::DIRTY) != 0);
+            break;
+          case TraceRecord::ALLOC: {
+            PageId allocated;
+            bufMgr.allocPage(file, allocated, page);
+            renumbered[key] = allocated;
+            break;
+          }
+          case TraceRecord::DISPOSE:
+            bufMgr.disposePage(file, pageNo);
+            renumbered.erase(key);
+            break;
+          case TraceRecord::FLUSH_FILE:
+            bufMgr.flushFile(file);
+            break;
+        }
+      } catch (const BadgerDbException &) {
+        ++result.failed;
+      }
+    }
+
+    result.seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+            .count();
+    result.stats = bufMgr.getBufStats() - before;
+
+    // Pages still pinned at the end of the trace are not flushed.
+    for (auto &file : files) {
+      try {
+        bufMgr.flushFile(*file.second);
+      } catch (const BadgerDbException &) {
+      }
+    }
+  }
+
+  for (auto &file : files) {
+    file.second.reset();
+    File::remove(scratchName(file.first));
+  }
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    std::cerr << "usage: " << argv[0] << " TRACE NUMBUFS [NUMBUFS...]\n";
+    return 2;
+  }
+
+  TraceSummary summary;
+  if (!summarize(argv[1], summary)) {
+    std::cerr << argv[1] << ": not an access trace\n";
+    return 1;
+  }
+  std::cout << std::fixed << std::setprecision(4);
+  std::cout << "trace: " << summary.requests << " requests to "
+            << summary.files.size() << " files over "
+            << summary.durationNs / 1e9 << "s, traced hit ratio "
+            << (summary.reads ? double(summary.hits) / summary.reads : 0.0)
+            << "\n";
+
+  for (int arg = 2; arg < argc; ++arg) {
+    const long numBufs = std::strtol(argv[arg], nullptr, 10);
+    if (numBufs <= 0) {
+      std::cerr << argv[arg] << ": not a pool size\n";
+      return 2;
+    }
+    const ReplayResult result = replay(argv[1], summary, numBufs);
+    std::cout << "frames " << numBufs << ": hit ratio "
+              << result.stats.hitRatio() << ", " << result.stats.diskreads
+              << " disk reads, " << result.stats.diskwrites
+              << " disk writes, " << result.failed << " failed requests, "
+              << std::setprecision(0)
+              << (result.seconds > 0 ? summary.requests / result.seconds : 0.0)
+              << std::setprecision(4) << " requests/s\n";
+  }
+  return 0;
+}
@@ -0,0 +1,87 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#include "victim_cache.h"
+
+#include <iterator>
+
+#include "lz_codec.h"
+
+namespace badgerdb {
+
+VictimCache::VictimCache(const std::size_t budget)
+    : budget_(budget), bytes_(0), hits_(0), misses_(0) {}
+
+void VictimCache::insert(const File &file, const Page &page) {
+  invalidate(file, page.page_number());
+
+  char image[Page::SIZE];
+  char compressed[Page::SIZE];
+  page.writeImage(image);
+  const std::size_t length =
+      lzCompress(image, Page::SIZE, compressed, Page::SIZE - 1);
+  std::string data = length ? std::string(compressed, length)
+                            : std::string(image, Page::SIZE);
+  if (data.size() > budget_) {
+    return;
+  }
+
+  // Make room by dropping the oldest pages.
+  while (bytes_ + data.size() > budget_) {
+    erase(index_.find(entries_.front().key));
+  }
+
+  const Key key(file.filename(), page.page_number());
+  bytes_ += data.size();
+  entries_.push_back(Entry{key, std::move(data)});
+  index_[key] = std::prev(entries_.end());
+}
+
+bool VictimCache::take(const File &file, const PageId pageNo, Page &page) {
+  const auto entry = index_.find(Key(file.filename(), pageNo));
+  if (entry == index_.end()) {
+    ++misses_;
+    return false;
+  }
+
+  const std::string &data = entry->second->data;
+  char image[Page::SIZE];
+  bool ok = true;
+  if (data.size() == Page::SIZE) {
+    page.readImage(data.data());
+  } else if ((ok = lzDecompress(data.data(), data.size(), image,
+                                Page::SIZE))) {
+    page.readImage(image);
+  }
+  erase(entry);
+  ok ? ++hits_ : ++misses_;
+  return ok;
+}
+
+void VictimCache::invalidate(const File &file, const PageId pageNo) {
+  const auto entry = index_.find(Key(file.filename(), pageNo));
+  if (entry != index_.end()) {
+    erase(entry);
+  }
+}
+
+void VictimCache::invalidate(const File &file) {
+  auto entry = index_.lower_bound(Key(file.filename(), 0));
+  while (entry != index_.end() && entry->first.first == file.filename()) {
+    erase(entry++);
+  }
+}
+
+void VictimCache::erase(
+    std::map<Key, std::list<Entry>::iterator>::iterator entry) {
+  bytes_ -= entry->second->data.size();
+  entries_.erase(entry->second);
+  index_.erase(entry);
+}
+
+}  // namespace badgerdb
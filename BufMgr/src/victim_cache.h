@@ -0,0 +1,132 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University
+ * of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "file.h"
+
+namespace badgerdb {
+
+/**
+ * @brief Compressed in-memory tier for pages evicted from the buffer pool.
+ *
+ * When BufMgr evicts a page, which has been written back if it was dirty, it
+ * compresses the page into this cache instead of discarding it.  A later miss
+ * on the page takes it back out and decompresses it, at the cost of a memcpy
+ * and decompression instead of a disk read.  Pages are evicted least recently
+ * inserted first once the compressed pages exceed the memory budget.
+ *
+ * The cache is exclusive: a page taken back into the pool is removed, since
+ * the pool now holds the authoritative copy.  BufMgr drops the pages of a
+ * file from the cache when it is flushed and drops pages that are disposed
+ * of or allocated anew, so the cache never serves a stale page through it;
+ * pages written to the file by other means must be invalidated by the caller.
+ *
+ * @warning This class is not threadsafe.
+ */
+class VictimCache {
+ public:
+  /**
+   * Creates an empty cache.
+   *
+   * @param budget  Memory, in bytes, the compressed pages may take up.
+   */
+  explicit VictimCache(const std::size_t budget);
+
+  /**
+   * Compresses a page into the cache, evicting older pages if the budget
+   * would be exceeded.  Replaces any copy of the page already cached.
+   *
+   * @param file  File the page belongs to.
+   * @param page  Page, which must be clean.
+   */
+  void insert(const File &file, const Page &page);
+
+  /**
+   * Removes a page from the cache if it is there.
+   *
+   * @param file    File the page belongs to.
+   * @param pageNo  Page number.
+   * @param page    Decompressed page, returned by reference.
+   * @return  True if the page was cached.
+   */
+  bool take(const File &file, const PageId pageNo, Page &page);
+
+  /**
+   * Drops a page from the cache.
+   */
+  void invalidate(const File &file, const PageId pageNo);
+
+  /**
+   * Drops every page of a file from the cache.
+   */
+  void invalidate(const File &file);
+
+  /**
+   * Returns the memory budget in bytes.
+   */
+  std::size_t getBudget() const { return budget_; }
+
+  /**
+   * Returns the memory, in bytes, the cached pages take up.
+   */
+  std::size_t getBytes() const { return bytes_; }
+
+  /**
+   * Returns the number of cached pages.
+   */
+  std::size_t getPageCount() const { return index_.size(); }
+
+  /**
+   * Returns the number of take() calls which found their page, and which
+   * did not.
+   */
+  std::uint64_t getHits() const { return hits_; }
+  std::uint64_t getMisses() const { return misses_; }
+
+ private:
+  typedef std::pair<std::string, PageId> Key;
+
+  /**
+   * @brief A cached page.  Its data is the page image compressed, or the
+   * image itself if it did not compress.
+   */
+  struct Entry {
+    Key key;
+    std::string data;
+  };
+
+  /**
+   * Removes an entry from the cache.
+   */
+  void erase(std::map<Key, std::list<Entry>::iterator>::iterator entry);
+
+  /**
+   * Memory budget and memory in use, in bytes.
+   */
+  std::size_t budget_;
+  std::size_t bytes_;
+
+  /**
+   * Cached pages, oldest first, and their index.
+   */
+  std::list<Entry> entries_;
+  std::map<Key, std::list<Entry>::iterator> index_;
+
+  std::uint64_t hits_;
+  std::uint64_t misses_;
+};
+
+}  // namespace badgerdb